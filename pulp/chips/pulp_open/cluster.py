@@ -131,7 +131,7 @@ class Cluster(st.Component):
 
         if has_redmule:
             # REDMULE
-            redmule = RedMule(self, 'redmule')
+            redmule = RedMule(self, 'redmule', wide_accesses=True)
 
         # Icache controller
         icache_ctrl = Icache_ctrl(self, 'icache_ctrl')
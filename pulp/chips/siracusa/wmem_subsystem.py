@@ -17,7 +17,7 @@
 import gvsoc.systree as st
 from memory.memory import Memory
 from interco.router import Router
-from interco.interleaver import Interleaver
+from pulp.cluster.l1_interleaver import L1_interleaver
 import math
 
 
@@ -40,7 +40,7 @@ class Wmem_subsystem(st.Component):
         #
 
         ico = Router(self, 'ico', latency=2)
-        interleaver = Interleaver(self, 'interleaver',  interleaving_bits=2, nb_masters=1, nb_slaves=nb_wmem_banks, stage_bits=0)
+        interleaver = L1_interleaver(self, 'interleaver', interleaving_bits=2, nb_masters=1, nb_slaves=nb_wmem_banks, stage_bits=0)
 
         wmem_banks = []
         for i in range(0, nb_wmem_banks):
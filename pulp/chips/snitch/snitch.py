@@ -39,6 +39,7 @@ class SnitchArchProperties:
         self.core_type               = 'accurate'
         self.use_spatz               = spatz
         self.isa                     = 'rv32imfdcav' if spatz else 'rv32imfdca'
+        self.dma_profile_file        = ''
 
 
     def declare_target_properties(self, target):
@@ -68,6 +69,11 @@ class SnitchArchProperties:
             name='core_type', value=self.core_type, allowed_values=['accurate', 'fast'], description='Type of the snitch model'
         )
 
+        self.dma_profile_file = target.declare_user_property(
+            name='soc/cluster/dma_profile_file', value=self.dma_profile_file,
+            description='Path of the cluster DMA transfer profiles, the DMA path is added to the name'
+        )
+
 
 class SnitchArch:
 
@@ -0,0 +1,148 @@
+/*
+ * Copyright (C) 2020 GreenWaves Technologies, SAS, ETH Zurich and
+ *                    University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Authors: Germain Haugou, GreenWaves Technologies (germain.haugou@greenwaves-technologies.com)
+ */
+
+#pragma once
+
+#include <stdio.h>
+#include <stdint.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <pulp/utils/statistics.hpp>
+
+/**
+ * @brief Bank access profiler for TCDM interleavers
+ *
+ * This counts the accesses of each bank and, for each initiator, the cycles lost to bank
+ * conflicts. Two accesses conflict when they hit the same bank during the same cycle. The n-th
+ * access to a bank in a cycle counts n-1 conflict cycles, as it waits for the previous ones.
+ * The profiler only observes the traffic and does not change the timing of the requests.
+ */
+class BankProfiler
+{
+public:
+    /**
+     * @brief Allocate the counters
+     *
+     * @param nb_banks Number of banks behind the interleaver.
+     * @param nb_initiators Number of initiators, i.e. input ports, of the interleaver.
+     */
+    void init(int nb_banks, int nb_initiators)
+    {
+        this->bank_accesses.assign(nb_banks, 0);
+        this->bank_last_cycle.assign(nb_banks, -1);
+        this->bank_cycle_accesses.assign(nb_banks, 0);
+        this->initiator_accesses.assign(nb_initiators, 0);
+        this->initiator_conflicts.assign(nb_initiators, 0);
+    }
+
+    /**
+     * @brief Account one bank access
+     *
+     * @param cycle Current cycle.
+     * @param bank Index of the accessed bank.
+     * @param initiator Index of the initiator doing the access.
+     */
+    inline void access(int64_t cycle, int bank, int initiator)
+    {
+        if (this->bank_last_cycle[bank] != cycle)
+        {
+            this->bank_last_cycle[bank] = cycle;
+            this->bank_cycle_accesses[bank] = 0;
+        }
+
+        this->initiator_conflicts[initiator] += this->bank_cycle_accesses[bank];
+        this->bank_cycle_accesses[bank]++;
+        this->bank_accesses[bank]++;
+        this->initiator_accesses[initiator]++;
+    }
+
+    /**
+     * @brief Dump the statistics
+     *
+     * This dumps the accesses per bank, the accesses and conflict cycles per initiator and a
+     * histogram of the banks sorted by their number of accesses relative to the busiest bank.
+     *
+     * @param output Output where the statistics are dumped.
+     * @param block Interleaver owning the profiler, used as prefix of each line.
+     */
+    void dump(StatisticsOutput &output, vp::Block *block)
+    {
+        uint64_t max_accesses = 0;
+        for (uint64_t accesses: this->bank_accesses)
+        {
+            max_accesses = std::max(max_accesses, accesses);
+        }
+
+        std::string line;
+        for (int i = 0; i < this->bank_accesses.size(); i++)
+        {
+            line += " " + std::to_string(i) + ": " + std::to_string(this->bank_accesses[i]);
+        }
+        output.print(block, "bank accesses (bank: accesses):%s", line.c_str());
+
+        line = "";
+        for (int i = 0; i < this->initiator_accesses.size(); i++)
+        {
+            if (this->initiator_accesses[i] != 0)
+            {
+                line += " " + std::to_string(i) + ": " + std::to_string(this->initiator_accesses[i]) +
+                    "/" + std::to_string(this->initiator_conflicts[i]);
+            }
+        }
+        output.print(block, "initiator conflicts (initiator: accesses/conflict cycles):%s", line.c_str());
+
+        int histogram[BankProfiler::heat_buckets] = { 0 };
+        for (uint64_t accesses: this->bank_accesses)
+        {
+            int bucket = max_accesses ? accesses * BankProfiler::heat_buckets / max_accesses : 0;
+            if (bucket == BankProfiler::heat_buckets)
+            {
+                bucket--;
+            }
+            histogram[bucket]++;
+        }
+
+        line = "";
+        for (int i = 0; i < BankProfiler::heat_buckets; i++)
+        {
+            if (histogram[i] != 0)
+            {
+                line += " " + std::to_string(i * 100 / BankProfiler::heat_buckets) + "-" +
+                    std::to_string((i + 1) * 100 / BankProfiler::heat_buckets) + "%: " +
+                    std::to_string(histogram[i]);
+            }
+        }
+        output.print(block, "bank heat histogram (accesses relative to busiest bank: banks):%s", line.c_str());
+    }
+
+private:
+    // Number of buckets of the bank heat histogram
+    static const int heat_buckets = 10;
+    // Number of accesses of each bank
+    std::vector<uint64_t> bank_accesses;
+    // Last cycle where each bank was accessed, and number of accesses during this cycle
+    std::vector<int64_t> bank_last_cycle;
+    std::vector<int> bank_cycle_accesses;
+    // Number of accesses and of conflict cycles of each initiator
+    std::vector<uint64_t> initiator_accesses;
+    std::vector<uint64_t> initiator_conflicts;
+};
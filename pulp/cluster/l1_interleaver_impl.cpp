@@ -23,6 +23,9 @@
 #include <vp/itf/io.hpp>
 #include <stdio.h>
 #include <math.h>
+#include <algorithm>
+#include <vector>
+#include <pulp/cluster/bank_profiler.hpp>
 
 class interleaver : public vp::Component
 {
@@ -32,10 +35,18 @@ public:
   interleaver(vp::ComponentConf &config);
 
   static vp::IoReqStatus req(vp::Block *__this, vp::IoReq *req);
-  static vp::IoReqStatus req_ts(vp::Block *__this, vp::IoReq *req);
+  static vp::IoReqStatus req_muxed(vp::Block *__this, vp::IoReq *req, int id);
+  static vp::IoReqStatus req_ts(vp::Block *__this, vp::IoReq *req, int id);
+
+  void reset(bool active);
+  void stop();
 
 
 private:
+  vp::IoReqStatus handle_req(vp::IoReq *req, int initiator);
+  vp::IoReqStatus req_split(vp::IoReq *req, int initiator);
+  int64_t bank_access(int bank_id, int64_t cycle);
+
   vp::Trace     trace;
 
   vp::IoMaster **out;
@@ -50,6 +61,21 @@ private:
   uint64_t bank_mask;
   vp::IoReq ts_req;
   int interleaving_bits;
+
+  // Precomputed address decoding constants
+  uint64_t word_size;
+  uint64_t word_mask;
+  int offset_shift;
+  // Request used for each bank access of requests spanning several banks
+  vp::IoReq bank_req;
+  // First cycle where each bank is free. A bank serves one access per cycle, the other ones wait.
+  std::vector<int64_t> bank_free_cycle;
+
+  // Bank accesses and conflicts, only collected and dumped if statistics are enabled. The
+  // initiators are the masters, the generic input being the last one.
+  bool statistics;
+  std::string statistics_file;
+  BankProfiler profiler;
 };
 
 interleaver::interleaver(vp::ComponentConf &config)
@@ -64,6 +90,8 @@ interleaver::interleaver(vp::ComponentConf &config)
   nb_masters = get_js_config()->get_child_int("nb_masters");
   stage_bits = get_js_config()->get_child_int("stage_bits");
   interleaving_bits = get_js_config()->get_child_int("interleaving_bits");
+  statistics = get_js_config()->get_child_bool("statistics");
+  statistics_file = get_js_config()->get_child_str("statistics_file");
 
   if (stage_bits == 0)
   {
@@ -71,6 +99,11 @@ interleaver::interleaver(vp::ComponentConf &config)
   }
 
   bank_mask = (1<<stage_bits) - 1;
+  word_size = 1 << interleaving_bits;
+  word_mask = word_size - 1;
+  offset_shift = stage_bits + interleaving_bits;
+
+  bank_free_cycle.resize(nb_slaves);
 
   out = new vp::IoMaster *[nb_slaves];
   for (int i=0; i<nb_slaves; i++)
@@ -84,35 +117,152 @@ interleaver::interleaver(vp::ComponentConf &config)
   for (int i=0; i<nb_masters; i++)
   {
     masters_in[i] = new vp::IoSlave();
-    masters_in[i]->set_req_meth(&interleaver::req);
+    masters_in[i]->set_req_meth_muxed(&interleaver::req_muxed, i);
     new_slave_port("in_" + std::to_string(i), masters_in[i]);
 
     masters_ts_in[i] = new vp::IoSlave();
-    masters_ts_in[i]->set_req_meth(&interleaver::req_ts);
+    masters_ts_in[i]->set_req_meth_muxed(&interleaver::req_ts, i);
     new_slave_port("ts_in_" + std::to_string(i), masters_ts_in[i]);
   }
 
+  if (statistics)
+  {
+    profiler.init(nb_slaves, nb_masters + 1);
+  }
+
+}
 
+void interleaver::reset(bool active)
+{
+  if (active)
+  {
+    std::fill(this->bank_free_cycle.begin(), this->bank_free_cycle.end(), 0);
+  }
+}
+
+void interleaver::stop()
+{
+  if (this->statistics)
+  {
+    StatisticsOutput output(this, &this->trace, this->statistics_file);
+    this->profiler.dump(output, this);
+  }
 }
 
 vp::IoReqStatus interleaver::req(vp::Block *__this, vp::IoReq *req)
 {
   interleaver *_this = (interleaver *)__this;
+  return _this->handle_req(req, _this->nb_masters);
+}
+
+vp::IoReqStatus interleaver::req_muxed(vp::Block *__this, vp::IoReq *req, int id)
+{
+  interleaver *_this = (interleaver *)__this;
+  return _this->handle_req(req, id);
+}
+
+// Reserve the bank for one access which reaches it at the specified cycle, and return the number of
+// cycles the access has to wait because the bank is busy with previous accesses
+int64_t interleaver::bank_access(int bank_id, int64_t cycle)
+{
+  int64_t start = std::max(cycle, this->bank_free_cycle[bank_id]);
+  this->bank_free_cycle[bank_id] = start + 1;
+  return start - cycle;
+}
+
+vp::IoReqStatus interleaver::handle_req(vp::IoReq *req, int initiator)
+{
   uint64_t offset = req->get_addr();
   bool is_write = req->get_is_write();
   uint64_t size = req->get_size();
   uint8_t *data = req->get_data();
 
-  _this->trace.msg("Received IO req (offset: 0x%llx, size: 0x%llx, is_write: %d)\n", offset, size, is_write);
- 
-  int bank_id = (offset >> _this->interleaving_bits) & _this->bank_mask;
-  uint64_t bank_offset = ((offset >> (_this->stage_bits + _this->interleaving_bits)) << _this->interleaving_bits) + (offset & ((1<<_this->interleaving_bits)-1));
+  this->trace.msg("Received IO req (offset: 0x%llx, size: 0x%llx, is_write: %d)\n", offset, size, is_write);
+
+  // Requests spanning several bank words are split into one access per bank word
+  if ((offset & this->word_mask) + size > this->word_size)
+  {
+    return this->req_split(req, initiator);
+  }
+
+  int bank_id = (offset >> this->interleaving_bits) & this->bank_mask;
+  uint64_t bank_offset = ((offset >> this->offset_shift) << this->interleaving_bits) + (offset & this->word_mask);
+
+  if (this->statistics)
+  {
+    this->profiler.access(this->clock.get_cycles(), bank_id, initiator);
+  }
+
+  int64_t wait = this->bank_access(bank_id, this->clock.get_cycles() + req->get_latency());
+  if (wait > 0)
+  {
+    this->trace.msg(vp::Trace::LEVEL_TRACE, "Bank conflict (bank: %d, wait: %lld)\n", bank_id, wait);
+    req->inc_latency(wait);
+  }
 
   req->set_addr(bank_offset);
-  return _this->out[bank_id]->req_forward(req);
+  return this->out[bank_id]->req_forward(req);
 }
 
-vp::IoReqStatus interleaver::req_ts(vp::Block *__this, vp::IoReq *req)
+vp::IoReqStatus interleaver::req_split(vp::IoReq *req, int initiator)
+{
+  uint64_t offset = req->get_addr();
+  bool is_write = req->get_is_write();
+  uint64_t size = req->get_size();
+  uint8_t *data = req->get_data();
+  int64_t max_latency = 0;
+  int64_t cycles = this->clock.get_cycles();
+  int64_t access_cycle = cycles + req->get_latency();
+
+  // All bank accesses are issued at the same cycle. The ones going to a bank already accessed, by
+  // this request or by another master, wait for it to be free.
+  while (size > 0)
+  {
+    uint64_t bank_size = std::min(this->word_size - (offset & this->word_mask), size);
+    int bank_id = (offset >> this->interleaving_bits) & this->bank_mask;
+    uint64_t bank_offset = ((offset >> this->offset_shift) << this->interleaving_bits) + (offset & this->word_mask);
+
+    this->trace.msg(vp::Trace::LEVEL_TRACE, "Forwarding bank request (bank: %d, offset: 0x%llx, size: 0x%llx)\n", bank_id, bank_offset, bank_size);
+
+    if (this->statistics)
+    {
+      this->profiler.access(cycles, bank_id, initiator);
+    }
+
+    this->bank_req.init();
+    this->bank_req.set_addr(bank_offset);
+    this->bank_req.set_size(bank_size);
+    this->bank_req.set_data(data);
+    this->bank_req.set_is_write(is_write);
+
+    vp::IoReqStatus err = this->out[bank_id]->req(&this->bank_req);
+    if (err == vp::IO_REQ_INVALID)
+    {
+      return err;
+    }
+    else if (err != vp::IO_REQ_OK)
+    {
+      this->trace.fatal("Unsupported asynchronous reply for request spanning several banks\n");
+    }
+
+    int64_t latency = this->bank_req.get_latency() + this->bank_access(bank_id, access_cycle);
+    if (latency > max_latency)
+    {
+      max_latency = latency;
+    }
+
+    offset += bank_size;
+    size -= bank_size;
+    data += bank_size;
+  }
+
+  // The request completes when its slowest bank access does
+  req->inc_latency(max_latency);
+
+  return vp::IO_REQ_OK;
+}
+
+vp::IoReqStatus interleaver::req_ts(vp::Block *__this, vp::IoReq *req, int id)
 {
   interleaver *_this = (interleaver *)__this;
   uint64_t offset = req->get_addr();
@@ -127,8 +277,18 @@ vp::IoReqStatus interleaver::req_ts(vp::Block *__this, vp::IoReq *req)
 
   bank_offset &= ~(1<<(20 - _this->stage_bits));
 
+  if (_this->statistics)
+  {
+    _this->profiler.access(_this->clock.get_cycles(), bank_id, id);
+  }
+
+  int64_t access_cycle = _this->clock.get_cycles() + req->get_latency();
+  req->inc_latency(_this->bank_access(bank_id, access_cycle));
+
   if (!is_write)
   {
+    // The bank is also busy during the next cycle for the write of the test-and-set
+    _this->bank_access(bank_id, access_cycle);
     req->set_addr(bank_offset);
     vp::IoReqStatus err = _this->out[bank_id]->req_forward(req);
     if (err != vp::IO_REQ_OK) return err;
@@ -88,6 +88,7 @@
 #define EU_CORE_TRIGG_SW_EVENT_WAIT_SIZE       0x40
 #define EU_CORE_TRIGG_SW_EVENT_WAIT_CLEAR      0x80
 #define EU_CORE_TRIGG_SW_EVENT_WAIT_CLEAR_SIZE 0x40
+#define EU_CORE_MASK_WORD_SELECT               0xC0
 
 #define EU_CORE_MASK_SEC_IRQ                   0x40
 
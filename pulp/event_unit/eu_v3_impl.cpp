@@ -24,6 +24,7 @@
 #include <vp/itf/wire.hpp>
 #include <stdio.h>
 #include <string.h>
+#include <string>
 #include "archi/eu_v3.h"
 
 class Core_event_unit;
@@ -32,6 +33,168 @@ class Dispatch_unit;
 class Mutex_unit;
 
 
+// Maximum number of cores supported by the model, this only sizes the core masks
+#ifndef EU_MAX_NB_CORES
+#define EU_MAX_NB_CORES 128
+#endif
+
+
+// Set of cores, with one bit per core, for up to N cores.
+// Software sees core masks through 32-bit registers, each word covering a group of 32 cores.
+// Each core selects the word it accesses through EU_CORE_MASK_WORD_SELECT, which defaults to
+// its own group, so clusters of up to 32 cores see the full mask as before.
+template<int N>
+class Core_mask
+{
+public:
+  Core_mask() { this->clear(); }
+
+  void clear()
+  {
+    for (int i=0; i<nb_words; i++) words[i] = 0;
+  }
+
+  // Set the first nb_cores cores
+  void fill(int nb_cores)
+  {
+    for (int i=0; i<nb_words; i++)
+    {
+      int bits = nb_cores - i*64;
+      words[i] = bits >= 64 ? ~0ULL : bits > 0 ? (1ULL << bits) - 1 : 0;
+    }
+  }
+
+  void set(int core) { words[core >> 6] |= 1ULL << (core & 63); }
+  void reset(int core) { words[core >> 6] &= ~(1ULL << (core & 63)); }
+  bool test(int core) const { return (words[core >> 6] >> (core & 63)) & 1; }
+
+  bool empty() const
+  {
+    uint64_t value = 0;
+    for (int i=0; i<nb_words; i++) value |= words[i];
+    return value == 0;
+  }
+
+  // First core of the set, or -1 if it is empty
+  int first() const
+  {
+    for (int i=0; i<nb_words; i++)
+    {
+      if (words[i]) return i*64 + __builtin_ctzll(words[i]);
+    }
+    return -1;
+  }
+
+  // Call func on each core of the set, in increasing order, only visiting set bits
+  template<typename F> void for_each(F func) const
+  {
+    for (int i=0; i<nb_words; i++)
+    {
+      uint64_t word = words[i];
+      while (word)
+      {
+        func(i*64 + __builtin_ctzll(word));
+        word &= word - 1;
+      }
+    }
+  }
+
+  bool operator==(const Core_mask &other) const
+  {
+    uint64_t diff = 0;
+    for (int i=0; i<nb_words; i++) diff |= words[i] ^ other.words[i];
+    return diff == 0;
+  }
+
+  Core_mask operator&(const Core_mask &other) const
+  {
+    Core_mask result;
+    for (int i=0; i<nb_words; i++) result.words[i] = words[i] & other.words[i];
+    return result;
+  }
+
+  // 32-bit register view, word index is the group of 32 cores
+  uint32_t get_word(int index) const
+  {
+    return words[index >> 1] >> ((index & 1) * 32);
+  }
+
+  void set_word(int index, uint32_t value)
+  {
+    int shift = (index & 1) * 32;
+    words[index >> 1] = (words[index >> 1] & ~(0xffffffffULL << shift)) | ((uint64_t)value << shift);
+  }
+
+  void or_word(int index, uint32_t value)
+  {
+    words[index >> 1] |= (uint64_t)value << ((index & 1) * 32);
+  }
+
+  // Hexadecimal dump, for traces
+  std::string to_string() const
+  {
+    std::string result = "0x";
+    char buffer[17];
+    for (int i=nb_words-1; i>=0; i--)
+    {
+      snprintf(buffer, sizeof(buffer), i == nb_words-1 ? "%lx" : "%016lx", words[i]);
+      result += buffer;
+    }
+    return result;
+  }
+
+private:
+  static const int nb_words = (N + 63) / 64;
+  uint64_t words[nb_words];
+};
+
+typedef Core_mask<EU_MAX_NB_CORES> Eu_core_mask;
+
+// Core mask register which can span several 32-bit words. A new value only replaces the
+// current one once all the words have been written, so that a partially written mask is never
+// used, e.g. to complete a barrier.
+class Eu_core_mask_reg
+{
+public:
+  Eu_core_mask_reg() { this->reset(); }
+
+  void reset()
+  {
+    value.clear();
+    next_value.clear();
+    written_words = 0;
+  }
+
+  // Read the programmed value, which may not be applied yet
+  uint32_t get_word(int index) const { return next_value.get_word(index); }
+
+  // Returns true if the write completed the mask and the new value is applied
+  bool set_word(int index, uint32_t data, int nb_words)
+  {
+    next_value.set_word(index, data);
+    written_words |= 1 << index;
+    if (written_words != (1U << nb_words) - 1) return false;
+
+    value = next_value;
+    written_words = 0;
+    return true;
+  }
+
+  // Value currently applied
+  Eu_core_mask value;
+
+private:
+  Eu_core_mask next_value;
+  uint32_t written_words;
+};
+
+// Masks are only formatted when the trace is active, as trace arguments are always evaluated
+static inline std::string eu_mask_str(vp::Trace &trace, const Eu_core_mask &mask)
+{
+  return trace.get_active() ? mask.to_string() : std::string();
+}
+
+
 // Timing constants
 
 // Cycles required by the core to really wakeup after his clock is back
@@ -79,9 +242,9 @@ public:
 
   //Plp3_ckg *top;
   bool locked;
-  uint32_t waiting_mask;
+  Eu_core_mask waiting_mask;
   uint32_t value;
-  vp::IoReq *waiting_reqs[32];
+  vp::IoReq *waiting_reqs[EU_MAX_NB_CORES];
   //void sleepCancel(int coreId);
   //function<void (int)> sleepCancelCallback;
 };
@@ -112,10 +275,10 @@ public:
   //Plp3_ckg *top;
   //DispatchUnit *dispatch;
   uint32_t value;
-  uint32_t status_mask;     // Cores that must get the value before it can be written again
-  uint32_t config_mask;     // Cores that will get a valid value
-  uint32_t waiting_mask;
-  vp::IoReq *waiting_reqs[32];
+  Eu_core_mask status_mask;     // Cores that must get the value before it can be written again
+  Eu_core_mask config_mask;     // Cores that will get a valid value
+  Eu_core_mask waiting_mask;
+  vp::IoReq *waiting_reqs[EU_MAX_NB_CORES];
 //
 //  //gv::ioSlave_ioReq stallRetryCallbackPtr;
 //  //function<void (int)> sleepCancelCallback;
@@ -146,7 +309,7 @@ public:
   //Dispatch *dispatches;
   //unsigned int globalFifoId;
   //unsigned int fifoId[32];
-  unsigned int config;
+  Eu_core_mask_reg config;
   //unsigned int teamConfig;
   //bool ioReq(gv::ioReq *req, uint32_t offset, bool isRead, uint32_t *data, int coreId);
   int dispatch_event;
@@ -162,9 +325,9 @@ private:
 
 class Barrier {
 public:
-  uint32_t core_mask;
-  uint32_t status;
-  uint32_t target_mask;
+  Eu_core_mask_reg core_mask;
+  Eu_core_mask status;
+  Eu_core_mask_reg target_mask;
 };
 
 
@@ -226,10 +389,14 @@ protected:
   Soc_event_unit *soc_event_unit;
 
   int nb_core;
-
-
-  vp::IoReqStatus sw_events_req(vp::IoReq *req, uint64_t offset, bool is_write, uint32_t *data);
-  void trigger_event(int event, uint32_t core_mask);
+  // Number of 32-bit words of the core masks
+  int nb_mask_words;
+
+  // Word of the core masks accessed by a core. Accesses not coming from a core see the first word.
+  int get_mask_word(int core);
+  vp::IoReqStatus sw_events_req(vp::IoReq *req, uint64_t offset, bool is_write, uint32_t *data, int core);
+  // An empty core mask sends the event to all cores
+  void trigger_event(int event, const Eu_core_mask &core_mask);
   void send_event(int core, uint32_t mask);
   static void in_event_sync(vp::Block *__this, bool active, int id);
 
@@ -267,6 +434,8 @@ public:
 
   int sync_irq;
   int pending_elw;
+  // Word of the core masks accessed by this core through 32-bit registers
+  int mask_word;
 
 private:
   Event_unit *top;
@@ -298,6 +467,13 @@ Event_unit::Event_unit(vp::ComponentConf &config)
 
   traces.new_trace("trace", &trace, vp::DEBUG);
 
+  if (nb_core > EU_MAX_NB_CORES)
+  {
+    trace.fatal("Too many cores (nb_core: %d, max: %d), EU_MAX_NB_CORES must be increased\n", nb_core, EU_MAX_NB_CORES);
+  }
+
+  nb_mask_words = (nb_core + 31) / 32;
+
   in.set_req_meth(&Event_unit::req);
   new_slave_port("input", &in);
 
@@ -362,7 +538,7 @@ vp::IoReqStatus Event_unit::req(vp::Block *__this, vp::IoReq *req)
   }
   else if (offset >= EU_SW_EVENTS_AREA_BASE && offset < EU_SW_EVENTS_AREA_BASE + EU_SW_EVENTS_AREA_SIZE)
   {
-    return _this->sw_events_req(req, offset - EU_SW_EVENTS_AREA_BASE, is_write, (uint32_t *)data);
+    return _this->sw_events_req(req, offset - EU_SW_EVENTS_AREA_BASE, is_write, (uint32_t *)data, -1);
   }
   else if (offset >= EU_BARRIER_AREA_OFFSET && offset < EU_BARRIER_AREA_OFFSET + EU_BARRIER_AREA_SIZE)
   {
@@ -376,15 +552,42 @@ vp::IoReqStatus Event_unit::req(vp::Block *__this, vp::IoReq *req)
 
 
 
-vp::IoReqStatus Event_unit::sw_events_req(vp::IoReq *req, uint64_t offset, bool is_write, uint32_t *data)
+int Event_unit::get_mask_word(int core)
+{
+  return core >= 0 ? core_eu[core].mask_word : 0;
+}
+
+
+
+vp::IoReqStatus Event_unit::sw_events_req(vp::IoReq *req, uint64_t offset, bool is_write, uint32_t *data, int core)
 {
   if (offset >= EU_CORE_TRIGG_SW_EVENT && offset <  EU_CORE_TRIGG_SW_EVENT_SIZE)
   {
     if (!is_write) return vp::IO_REQ_INVALID;
 
     int event = (offset - EU_CORE_TRIGG_SW_EVENT) >> 2;
-    trace.msg("SW event trigger (event: %d, coreMask: 0x%x)\n", event, *data);
-    trigger_event(1<<event, *data);
+    int mask_word = get_mask_word(core);
+    trace.msg("SW event trigger (event: %d, coreMask: 0x%x, maskWord: %d)\n", event, *data, mask_word);
+    Eu_core_mask core_mask;
+    core_mask.set_word(mask_word, *data);
+    trigger_event(1<<event, core_mask);
+  }
+  else if (offset == EU_CORE_MASK_WORD_SELECT)
+  {
+    // The word is selected per core, the access is valid only through the demux
+    if (core == -1) return vp::IO_REQ_INVALID;
+
+    Core_event_unit *eu = &core_eu[core];
+    if (!is_write) *data = eu->mask_word;
+    else {
+      if (*data >= (uint32_t)nb_mask_words)
+      {
+        trace.warning("Invalid core mask word (word: %d, nb_words: %d)\n", *data, nb_mask_words);
+        return vp::IO_REQ_INVALID;
+      }
+      trace.msg("Selecting core mask word (core: %d, word: %d)\n", core, *data);
+      eu->mask_word = *data;
+    }
   }
   else if (offset >= EU_CORE_TRIGG_SW_EVENT_WAIT && offset <  EU_CORE_TRIGG_SW_EVENT_WAIT_SIZE)
   {
@@ -429,13 +632,22 @@ vp::IoReqStatus Event_unit::sw_events_req(vp::IoReq *req, uint64_t offset, bool
 }
 
 
-void Event_unit::trigger_event(int event_mask, uint32_t core_mask)
+void Event_unit::trigger_event(int event_mask, const Eu_core_mask &core_mask)
 {
-  for (unsigned int i=0; i<nb_core; i++) {
-    if (core_mask == 0 || (core_mask & (1 << i))) {
+  if (core_mask.empty())
+  {
+    for (int i=0; i<nb_core; i++)
+    {
       send_event(i, event_mask);
     }
   }
+  else
+  {
+    // Masks written by software may contain cores which do not exist
+    core_mask.for_each([this, event_mask](int core) {
+      if (core < this->nb_core) this->send_event(core, event_mask);
+    });
+  }
 }
 
 void Event_unit::send_event(int core, uint32_t mask)
@@ -635,7 +847,7 @@ vp::IoReqStatus Event_unit::demux_req(vp::Block *__this, vp::IoReq *req, int cor
   }
   else if (offset >= EU_SW_EVENTS_DEMUX_OFFSET && offset < EU_SW_EVENTS_DEMUX_OFFSET + EU_SW_EVENTS_DEMUX_SIZE)
   {
-    return _this->sw_events_req(req, offset - EU_SW_EVENTS_DEMUX_OFFSET, is_write, (uint32_t *)data);
+    return _this->sw_events_req(req, offset - EU_SW_EVENTS_DEMUX_OFFSET, is_write, (uint32_t *)data, core);
   }
   else if (offset >= EU_BARRIER_DEMUX_OFFSET && offset < EU_BARRIER_DEMUX_OFFSET + EU_BARRIER_DEMUX_SIZE)
   {
@@ -900,6 +1112,7 @@ void Core_event_unit::reset()
   clear_evt_mask = 0;
   sync_irq = -1;
   pending_elw = false;
+  mask_word = core_id >> 5;
   state = CORE_STATE_NONE;
   this->clock_itf.sync(1);
 }
@@ -1012,7 +1225,7 @@ vp::IoReqStatus Mutex_unit::enqueue_sleep(Mutex *mutex, vp::IoReq *req, int core
 
   // Enqueue the request so that the core can be unstalled when a value is pushed
   mutex->waiting_reqs[core_id] = req;
-  mutex->waiting_mask |= 1<<core_id;
+  mutex->waiting_mask.set(core_id);
 
   // Don't forget to remember to clear the event after wake-up by the dispatch event
   core_eu->clear_evt_mask = 1<<mutex_event;
@@ -1032,7 +1245,7 @@ void Mutex_unit::reset()
 void Mutex::reset()
 {
   locked = false;
-  waiting_mask = 0;
+  waiting_mask.clear();
 }
 
 
@@ -1078,33 +1291,25 @@ vp::IoReqStatus Mutex_unit::req(vp::IoReq *req, uint64_t offset, bool is_write,
     mutex->value = *(uint32_t *)req->get_data();
 
     // The core is unlocking the mutex, check if we have to wake-up someone
-    unsigned int waiting_mask = mutex->waiting_mask;
-    if (waiting_mask)
+    // We have to wake-up one core, take the first one
+    int i = mutex->waiting_mask.first();
+    if (i != -1)
     {
-      // We have to wake-up one core, take the first one
-      for (unsigned int i=0; i<32; i++)
-      {
-        if (waiting_mask & (1<<i))
-        {
-          top->trace.msg("Transfering mutex lock (mutex: %d, fromCore: %d, toCore: %d)\n", id, core, i);
-          // Clear the mask and wake-up the elected core. Don't unlock the mutex, as it is
-          // taken by the new core
-          top->trace.msg("Waking-up core waiting for dispatch value (coreId: %d)\n", i);
-          vp::IoReq *waiting_req = mutex->waiting_reqs[i];
-
-          mutex->waiting_mask &= ~(1<<i);
+      top->trace.msg("Transfering mutex lock (mutex: %d, fromCore: %d, toCore: %d)\n", id, core, i);
+      // Clear the mask and wake-up the elected core. Don't unlock the mutex, as it is
+      // taken by the new core
+      top->trace.msg("Waking-up core waiting for dispatch value (coreId: %d)\n", i);
+      vp::IoReq *waiting_req = mutex->waiting_reqs[i];
 
-          // Store the mutex value into the pending request
-          // Don't reply now to the initiator, this will be done by the wakeup event
-          // to introduce some delays
-          *(uint32_t *)waiting_req->get_data() = mutex->value;
+      mutex->waiting_mask.reset(i);
 
-          // And trigger the event to the core
-          top->trigger_event(1<<mutex_event, 1<<i); 
+      // Store the mutex value into the pending request
+      // Don't reply now to the initiator, this will be done by the wakeup event
+      // to introduce some delays
+      *(uint32_t *)waiting_req->get_data() = mutex->value;
 
-          break;
-        }
-      }
+      // And trigger the event to the core
+      top->send_event(i, 1<<mutex_event);
     } 
     else
     {
@@ -1129,7 +1334,7 @@ vp::IoReqStatus Dispatch_unit::enqueue_sleep(Dispatch *dispatch, vp::IoReq *req,
 
   // Enqueue the request so that the core can be unstalled when a value is pushed
   dispatch->waiting_reqs[core_id] = req;
-  dispatch->waiting_mask |= 1<<core_id;
+  dispatch->waiting_mask.set(core_id);
 
   // Don't forget to remember to clear the event after wake-up by the dispatch event
   core_eu->clear_evt_mask = 1<<dispatch_event;
@@ -1154,7 +1359,7 @@ Dispatch_unit::Dispatch_unit(Event_unit *top)
   void Dispatch_unit::reset()
   {
     fifo_head = 0;
-    config = 0;
+    config.reset();
     for (int i=0; i<top->nb_core; i++)
     {
       core[i].tail = 0;
@@ -1162,9 +1367,9 @@ Dispatch_unit::Dispatch_unit(Event_unit *top)
     for (int i=0; i<size; i++)
     {
       dispatches[i].value = 0;
-      dispatches[i].status_mask = 0;
-      dispatches[i].config_mask = 0;
-      dispatches[i].waiting_mask = 0;
+      dispatches[i].status_mask.clear();
+      dispatches[i].config_mask.clear();
+      dispatches[i].waiting_mask.clear();
     }
   }
 
@@ -1180,64 +1385,57 @@ Dispatch_unit::Dispatch_unit(Event_unit *top)
         Dispatch *dispatch = &dispatches[id];
 
         // When pushing to the FIFO, the global config is pushed to the elected dispatcher
-        dispatch->config_mask = config;     // Cores that will get a valid value
+        dispatch->config_mask = config.value;     // Cores that will get a valid value
 
-        top->trace.msg("Pushing dispatch value (dispatch: %d, value: 0x%x, coreMask: 0x%x)\n", id, *data, dispatch->config_mask);
+        top->trace.msg("Pushing dispatch value (dispatch: %d, value: 0x%x, coreMask: %s)\n", id, *data, eu_mask_str(top->trace, dispatch->config_mask).c_str());
 
         // Case where the master push a value
         dispatch->value = *data;
         // Reinitialize the status mask to notify a new value is ready
-        dispatch->status_mask = -1;
-        // Then wake-up the waiting cores
-        unsigned int mask = dispatch->waiting_mask & dispatch->status_mask;
-        for (int i=0; i<32 && mask; i++)
-        {
-          if (mask & (1<<i))
+        dispatch->status_mask.fill(top->nb_core);
+        // Then wake-up the waiting cores, only visiting the ones which are waiting
+        Eu_core_mask mask = dispatch->waiting_mask & dispatch->status_mask;
+        mask.for_each([this, dispatch, &id](int i) {
+          // Only wake-up the core if he's actually involved in the team
+          if (dispatch->config_mask.test(i))
           {
-            // Only wake-up the core if he's actually involved in the team
-            if (dispatch->config_mask & (1<<i))
-            {
-              top->trace.msg("Waking-up core waiting for dispatch value (coreId: %d)\n", i);
-              vp::IoReq *waiting_req = dispatch->waiting_reqs[i];
-
-              // Clear the status bit as the waking core takes the data
-              dispatch->status_mask &= ~(1<<i);
-              dispatch->waiting_mask &= ~(1<<i);
-
-              // Store the dispatch value into the pending request
-              // Don't reply now to the initiator, this will be done by the wakeup event
-              // to introduce some delays
-              *(uint32_t *)waiting_req->get_data() = dispatch->value;
-
-              // Update the core fifo
-              core[i].tail++;
-              if (core[i].tail == size) core[i].tail = 0;
-
-              // Clear the mask to stop iterating early
-              mask &= ~(1<<i);
-
-              // And trigger the event to the core
-              top->trigger_event(1<<dispatch_event, 1<<i); 
-            }
-            // Otherwise keep him sleeping and increase its index so that he will bypass this entry when he wakes up
-            else
-            {
-              // Cancel current dispatch sleep
-              dispatch->status_mask &= ~(1<<i);
-              dispatch->waiting_mask &= ~(1<<i);
-              vp::IoReq *pending_req = dispatch->waiting_reqs[i];
-
-              // Bypass the current entry
-              core[i].tail++;
-              if (core[i].tail == size) core[i].tail = 0;
-
-              // And reenqueue to the next entry
-              id = core[i].tail;
-              enqueue_sleep(&dispatches[id], pending_req, i, false);
-              top->trace.msg("Incrementing core counter to bypass entry (coreId: %d, newIndex: %d)\n", i, id);
-            }
+            top->trace.msg("Waking-up core waiting for dispatch value (coreId: %d)\n", i);
+            vp::IoReq *waiting_req = dispatch->waiting_reqs[i];
+
+            // Clear the status bit as the waking core takes the data
+            dispatch->status_mask.reset(i);
+            dispatch->waiting_mask.reset(i);
+
+            // Store the dispatch value into the pending request
+            // Don't reply now to the initiator, this will be done by the wakeup event
+            // to introduce some delays
+            *(uint32_t *)waiting_req->get_data() = dispatch->value;
+
+            // Update the core fifo
+            core[i].tail++;
+            if (core[i].tail == size) core[i].tail = 0;
+
+            // And trigger the event to the core
+            top->send_event(i, 1<<dispatch_event);
           }
-        }
+          // Otherwise keep him sleeping and increase its index so that he will bypass this entry when he wakes up
+          else
+          {
+            // Cancel current dispatch sleep
+            dispatch->status_mask.reset(i);
+            dispatch->waiting_mask.reset(i);
+            vp::IoReq *pending_req = dispatch->waiting_reqs[i];
+
+            // Bypass the current entry
+            core[i].tail++;
+            if (core[i].tail == size) core[i].tail = 0;
+
+            // And reenqueue to the next entry
+            id = core[i].tail;
+            enqueue_sleep(&dispatches[id], pending_req, i, false);
+            top->trace.msg("Incrementing core counter to bypass entry (coreId: %d, newIndex: %d)\n", i, id);
+          }
+        });
 
         return vp::IO_REQ_OK;        
       }
@@ -1249,8 +1447,8 @@ Dispatch_unit::Dispatch_unit(Event_unit *top)
         top->trace.msg("Trying to get dispatch value (dispatch: %d)\n", id);
 
         // In case we found ready elements where this core is not involved, bypass them all
-        while ((dispatch->status_mask & (1<<core_id)) && !(dispatch->config_mask & (1<<core_id))) {
-          dispatch->status_mask &= ~(1<<core_id);
+        while (dispatch->status_mask.test(core_id) && !dispatch->config_mask.test(core_id)) {
+          dispatch->status_mask.reset(core_id);
           core[core_id].tail++;
           if (core[core_id].tail == size) core[core_id].tail = 0;
           id = core[core_id].tail;
@@ -1259,21 +1457,21 @@ Dispatch_unit::Dispatch_unit(Event_unit *top)
         }
 
         // Case where a slave tries to get a value
-        if (dispatch->status_mask & (1<<core_id))
+        if (dispatch->status_mask.test(core_id))
         {
           // A value is ready. Get it and clear the status bit to not read it again the next time
           // In case the core is not involved in this dispatch, returns 0
-          if (dispatch->config_mask & (1<<core_id)) *data = dispatch->value;
+          if (dispatch->config_mask.test(core_id)) *data = dispatch->value;
           else *data = 0;
-          dispatch->status_mask &= ~(1<<core_id);
-          top->trace.msg("Getting ready dispatch value (dispatch: %d, value: %x, dispatchStatus: 0x%x)\n", id, dispatch->value, dispatch->status_mask);
+          dispatch->status_mask.reset(core_id);
+          top->trace.msg("Getting ready dispatch value (dispatch: %d, value: %x, dispatchStatus: %s)\n", id, dispatch->value, eu_mask_str(top->trace, dispatch->status_mask).c_str());
           core[core_id].tail++;
           if (core[core_id].tail == size) core[core_id].tail = 0;
         }
         else
         {
           // Nothing is ready, go to sleep
-          top->trace.msg("No ready dispatch value, going to sleep (dispatch: %d, value: %x, dispatchStatus: 0x%x)\n", id, dispatch->value, dispatch->status_mask);
+          top->trace.msg("No ready dispatch value, going to sleep (dispatch: %d, value: %x, dispatchStatus: %s)\n", id, dispatch->value, eu_mask_str(top->trace, dispatch->status_mask).c_str());
           return enqueue_sleep(dispatch, req, core_id);
         }
 
@@ -1284,7 +1482,13 @@ Dispatch_unit::Dispatch_unit(Event_unit *top)
     }
     else if (offset == EU_DISPATCH_TEAM_CONFIG)
     {
-      config = *data;
+      int mask_word = top->get_mask_word(core_id);
+      if (!is_write) *data = config.get_word(mask_word);
+      else {
+        top->trace.msg("Setting team config (maskWord: %d, mask: 0x%x)\n", mask_word, *data);
+        // The team is only updated once all the words are written
+        config.set_word(mask_word, *data, top->nb_mask_words);
+      }
       return vp::IO_REQ_OK;
     }
     else
@@ -1316,12 +1520,12 @@ void Barrier_unit::check_barrier(int barrier_id)
 {
   Barrier *barrier = &barriers[barrier_id];
 
-  if (barrier->status == barrier->core_mask) 
+  if (barrier->status == barrier->core_mask.value) 
   {
-    trace.msg("Barrier reached, triggering event (barrier: %d, coreMask: 0x%x, targetMask: 0x%x)\n", barrier_id, barrier->core_mask, barrier->target_mask);
-    barrier->status = 0;
+    trace.msg("Barrier reached, triggering event (barrier: %d, coreMask: %s, targetMask: %s)\n", barrier_id, eu_mask_str(trace, barrier->core_mask.value).c_str(), eu_mask_str(trace, barrier->target_mask.value).c_str());
+    barrier->status.clear();
 
-    top->trigger_event(1<<barrier_event, barrier->target_mask);
+    top->trigger_event(1<<barrier_event, barrier->target_mask.value);
   }
 }
 
@@ -1332,32 +1536,39 @@ vp::IoReqStatus Barrier_unit::req(vp::IoReq *req, uint64_t offset, bool is_write
   offset = offset - EU_BARRIER_AREA_OFFSET_GET(barrier_id);
   if (barrier_id >= nb_barriers) return vp::IO_REQ_INVALID;
   Barrier *barrier = &barriers[barrier_id];
+  // Masks are accessed through the word selected by the core
+  int mask_word = top->get_mask_word(core);
 
   if (offset == EU_HW_BARR_TRIGGER_MASK)
   {
-    if (!is_write) *data = barrier->core_mask;
+    if (!is_write) *data = barrier->core_mask.get_word(mask_word);
     else {
-      trace.msg("Setting barrier core mask (barrier: %d, mask: 0x%x)\n", barrier_id, *data);
-      barrier->core_mask = *data;
-      check_barrier(barrier_id);
+      trace.msg("Setting barrier core mask (barrier: %d, mask: 0x%x, maskWord: %d)\n", barrier_id, *data, mask_word);
+      // The barrier is only checked once all the words are written
+      if (barrier->core_mask.set_word(mask_word, *data, top->nb_mask_words))
+      {
+        check_barrier(barrier_id);
+      }
     }
   }
 
   else if (offset == EU_HW_BARR_TARGET_MASK)
   {
-    if (!is_write) *data = barrier->target_mask;
+    if (!is_write) *data = barrier->target_mask.get_word(mask_word);
     else {
-      trace.msg("Setting barrier target mask (barrier: %d, mask: 0x%x)\n", barrier_id, *data);
-      barrier->target_mask = *data;
-      check_barrier(barrier_id);
+      trace.msg("Setting barrier target mask (barrier: %d, mask: 0x%x, maskWord: %d)\n", barrier_id, *data, mask_word);
+      if (barrier->target_mask.set_word(mask_word, *data, top->nb_mask_words))
+      {
+        check_barrier(barrier_id);
+      }
     }
   }
   else if (offset == EU_HW_BARR_STATUS)
   {
-    if (!is_write) *data = barrier->status;
+    if (!is_write) *data = barrier->status.get_word(mask_word);
     else {
-      trace.msg("Setting barrier status (barrier: %d, status: 0x%x)\n", barrier_id, *data);
-      barrier->status = *data;
+      trace.msg("Setting barrier status (barrier: %d, status: 0x%x, maskWord: %d)\n", barrier_id, *data, mask_word);
+      barrier->status.set_word(mask_word, *data);
       check_barrier(barrier_id);
     }
   }
@@ -1365,8 +1576,8 @@ vp::IoReqStatus Barrier_unit::req(vp::IoReq *req, uint64_t offset, bool is_write
   {
     if (!is_write) return vp::IO_REQ_INVALID;
     else {
-      barrier->status |= *data;
-      trace.msg("Barrier mask trigger (barrier: %d, mask: 0x%x, newStatus: 0x%x)\n", barrier_id, *data, barrier->status);
+      barrier->status.or_word(mask_word, *data);
+      trace.msg("Barrier mask trigger (barrier: %d, mask: 0x%x, maskWord: %d, newStatus: %s)\n", barrier_id, *data, mask_word, eu_mask_str(trace, barrier->status).c_str());
     }
 
     check_barrier(barrier_id);
@@ -1375,9 +1586,8 @@ vp::IoReqStatus Barrier_unit::req(vp::IoReq *req, uint64_t offset, bool is_write
   {
     // The access is valid only through the demux
     if (core == -1) return vp::IO_REQ_INVALID;
-    barrier->status |= 1 << core
-    ;
-    trace.msg("Barrier trigger (barrier: %d, coreId: %d, newStatus: 0x%x)\n", barrier_id, core, barrier->status);
+    barrier->status.set(core);
+    trace.msg("Barrier trigger (barrier: %d, coreId: %d, newStatus: %s)\n", barrier_id, core, eu_mask_str(trace, barrier->status).c_str());
 
     check_barrier(barrier_id);
   }
@@ -1391,12 +1601,12 @@ vp::IoReqStatus Barrier_unit::req(vp::IoReq *req, uint64_t offset, bool is_write
     {
       // The core was already waiting for the barrier which means it was interrupted
       // by an interrupt. Just resume the barrier by going to sleep
-      trace.msg("Resuming barrier trigger and wait (barrier: %d, coreId: %d, newStatus: 0x%x)\n", barrier_id, core, barrier->status);
+      trace.msg("Resuming barrier trigger and wait (barrier: %d, coreId: %d, newStatus: %s)\n", barrier_id, core, eu_mask_str(trace, barrier->status).c_str());
     }
     else
     {
-      barrier->status |= 1 << core;
-      trace.msg("Barrier trigger and wait (barrier: %d, coreId: %d, newStatus: 0x%x)\n", barrier_id, core, barrier->status);
+      barrier->status.set(core);
+      trace.msg("Barrier trigger and wait (barrier: %d, coreId: %d, newStatus: %s)\n", barrier_id, core, eu_mask_str(trace, barrier->status).c_str());
     }
 
     check_barrier(barrier_id);
@@ -1413,12 +1623,12 @@ vp::IoReqStatus Barrier_unit::req(vp::IoReq *req, uint64_t offset, bool is_write
     {
       // The core was already waiting for the barrier which means it was interrupted
       // by an interrupt. Just resume the barrier by going to sleep
-      trace.msg("Resuming barrier trigger and wait (barrier: %d, coreId: %d, mask: 0x%x, newStatus: 0x%x)\n", barrier_id, core, barrier->core_mask, barrier->status);
+      trace.msg("Resuming barrier trigger and wait (barrier: %d, coreId: %d, mask: %s, newStatus: %s)\n", barrier_id, core, eu_mask_str(trace, barrier->core_mask.value).c_str(), eu_mask_str(trace, barrier->status).c_str());
     }
     else
     {
-      barrier->status |= 1 << core;
-      trace.msg("Barrier trigger, wait and clear (barrier: %d, coreId: %d, newStatus: 0x%x)\n", barrier_id, core, barrier->status);
+      barrier->status.set(core);
+      trace.msg("Barrier trigger, wait and clear (barrier: %d, coreId: %d, newStatus: %s)\n", barrier_id, core, eu_mask_str(trace, barrier->status).c_str());
     }
     core_eu->clear_evt_mask = core_eu->evt_mask;
 
@@ -1430,7 +1640,7 @@ vp::IoReqStatus Barrier_unit::req(vp::IoReq *req, uint64_t offset, bool is_write
   {
     if (is_write) return vp::IO_REQ_INVALID;
     uint32_t status = 0;
-    for (unsigned int i=1; i<nb_barriers; i++) status |= barriers[i].status;
+    for (unsigned int i=1; i<nb_barriers; i++) status |= barriers[i].status.get_word(mask_word);
     *data = status;
   }
   else return vp::IO_REQ_INVALID;
@@ -1443,9 +1653,9 @@ void Barrier_unit::reset()
   for (int i=0; i<nb_barriers; i++)
   {
     Barrier *barrier = &barriers[i];
-    barrier->core_mask = 0;
-    barrier->status = 0;
-    barrier->target_mask = 0;
+    barrier->core_mask.reset();
+    barrier->status.clear();
+    barrier->target_mask.reset();
   }
 }
 
@@ -1476,7 +1686,7 @@ void Soc_event_unit::check_state()
 {
   if (this->fifo_soc_event != -1 && this->nb_free_events != this->nb_fifo_events) {
     this->trace.msg("Generating FIFO event (id: %d)\n", this->fifo_soc_event);
-    this->top->trigger_event(1<<this->fifo_soc_event, -1);
+    this->top->trigger_event(1<<this->fifo_soc_event, Eu_core_mask());
   }
 }
 
@@ -1513,7 +1723,7 @@ vp::IoReqStatus Soc_event_unit::ioReq(uint32_t offset, bool is_write, uint32_t *
     if (nb_free_events != nb_fifo_events)
     {
       this->trace.msg("Generating FIFO soc event (id: %d)\n", this->fifo_soc_event);
-      this->top->trigger_event(1<<this->fifo_soc_event, -1);
+      this->top->trigger_event(1<<this->fifo_soc_event, Eu_core_mask());
     }
   }
 
@@ -20,10 +20,12 @@
  *          Jonas Martin, ETH (martinjo@student.ethz.ch)
  */
 
+#include <algorithm>
 #include <vp/vp.hpp>
 #include <vp/itf/io.hpp>
 #include "floonoc.hpp"
 #include "floonoc_router.hpp"
+#include "floonoc_routing.hpp"
 #include "floonoc_network_interface.hpp"
 
 
@@ -37,6 +39,33 @@ FlooNoc::FlooNoc(vp::ComponentConf &config)
     this->dim_x = get_js_config()->get_int("dim_x");
     this->dim_y = get_js_config()->get_int("dim_y");
     this->router_input_queue_size = get_js_config()->get_int("router_input_queue_size");
+    this->analytical_bursts = get_js_config()->get_child_bool("analytical_bursts");
+    this->statistics = get_js_config()->get_child_bool("statistics");
+    this->nb_vcs = get_js_config()->get_child_int("nb_vcs");
+    this->link_stats_file = get_js_config()->get_child_str("link_stats_file");
+    this->statistics_file = get_js_config()->get_child_str("statistics_file");
+
+    std::string routing = get_js_config()->get_child_str("routing");
+    this->routing = RoutingAlgorithm::create(routing, this->dim_x, this->dim_y);
+    if (this->routing == NULL)
+    {
+        this->trace.fatal("Unknown routing algorithm (name: %s)\n", routing.c_str());
+        return;
+    }
+
+    if (this->nb_vcs < 1 || this->nb_vcs > Router::MAX_VCS)
+    {
+        this->trace.fatal("Invalid number of virtual channels (nb_vcs: %d, max: %d)\n", this->nb_vcs,
+            Router::MAX_VCS);
+        return;
+    }
+
+    if (this->routing->is_torus() && (this->nb_vcs % 2) != 0)
+    {
+        this->trace.fatal("Torus routing requires an even number of virtual channels (nb_vcs: %d)\n",
+            this->nb_vcs);
+        return;
+    }
 
     // Reserve the array for the target. We may have one target at each node.
     this->targets.resize(this->dim_x * this->dim_y);
@@ -45,9 +74,8 @@ FlooNoc::FlooNoc(vp::ComponentConf &config)
     js::Config *mappings = get_js_config()->get("mappings");
     if (mappings != NULL)
     {
-        // For now entries are stored in a classic array. When a request is received, we will
-        // to compare to each entry which may be slow when having lots of target.
-        // We could optimize it by using a tree.
+        // Entries are first stored in a classic array, and then sorted by base address once
+        // they are all known, so that address decoding is a binary search.
         this->entries.resize(mappings->get_childs().size());
         int id = 0;
         for (auto& mapping: mappings->get_childs())
@@ -78,6 +106,23 @@ FlooNoc::FlooNoc(vp::ComponentConf &config)
 
             id++;
         }
+
+        std::stable_sort(this->entries.begin(), this->entries.end(),
+            [](const Entry &a, const Entry &b) { return a.base < b.base; });
+
+        this->entry_bases.resize(this->entries.size());
+        for (int i=0; i<this->entries.size(); i++)
+        {
+            this->entry_bases[i] = this->entries[i].base;
+
+            // The binary search only checks the closest entry below the address, so overlapping
+            // mappings would not be decoded correctly
+            if (i > 0 && this->entries[i].base < this->entries[i-1].base + this->entries[i-1].size)
+            {
+                this->trace.force_warning("Overlapping mappings (base: 0x%lx, previous base: 0x%lx, previous size: 0x%lx)\n",
+                    this->entries[i].base, this->entries[i-1].base, this->entries[i-1].size);
+            }
+        }
     }
 
     // Create the array of networks interfaces
@@ -117,6 +162,18 @@ FlooNoc::FlooNoc(vp::ComponentConf &config)
             this->wide_routers[y*this->dim_x + x] = new Router(this, "wide_router_", x, y, this->router_input_queue_size);
         }
     }
+
+    // Now that all routers are known, each of them can precompute its routing table, which
+    // includes pointers to its neighbours in the same network
+    for (int i=0; i<this->dim_x * this->dim_y; i++)
+    {
+        if (this->req_routers[i] != NULL)
+        {
+            this->req_routers[i]->build_routing_table(this->req_routers);
+            this->rsp_routers[i]->build_routing_table(this->rsp_routers);
+            this->wide_routers[i]->build_routing_table(this->wide_routers);
+        }
+    }
 }
 
 
@@ -196,7 +253,12 @@ void FlooNoc::grant(vp::Block *__this, vp::IoReq *req)
     // Get back the router and forward the grant
     FlooNoc *_this = (FlooNoc *)__this;
     Router *router = *(Router **)req->arg_get(FlooNoc::REQ_ROUTER);
-    router->grant(req);
+    // In analytical burst mode, the request was sent directly by the network interface and
+    // there is no router to unstall. The network interface will just wait for the response.
+    if (router != NULL)
+    {
+        router->grant(req);
+    }
 }
 
 
@@ -207,18 +269,106 @@ void FlooNoc::reset(bool active)
 
 
 
-Entry *FlooNoc::get_entry(uint64_t base, uint64_t size)
+void FlooNoc::stop()
 {
-    // For now, we store mapping in a classic array.
-    // Just go through each entry one by one, until one is matching the requested memory location
-    for (int i=0; i<this->entries.size(); i++)
+    if (this->statistics)
     {
-        Entry *entry = &this->entries[i];
-        if (base >= entry->base && base + size <= entry->base + entry->size)
+        StatisticsOutput output(this, &this->trace, this->statistics_file);
+        for (NetworkInterface *ni: this->network_interfaces)
         {
-            return entry;
+            if (ni != NULL)
+            {
+                ni->dump_statistics(output);
+            }
         }
     }
+
+    if (this->link_stats_file == "")
+    {
+        return;
+    }
+
+    FILE *file = fopen(this->link_stats_file.c_str(), "w");
+    if (file == NULL)
+    {
+        this->trace.force_warning("Unable to open link statistics file (path: %s)\n",
+            this->link_stats_file.c_str());
+        return;
+    }
+
+    // The format is selected from the file extension, CSV is the default
+    std::string path = this->link_stats_file;
+    bool json = path.size() >= 5 && path.compare(path.size() - 5, 5, ".json") == 0;
+
+    if (json)
+    {
+        fprintf(file, "[\n");
+    }
+    else
+    {
+        fprintf(file, "router,x,y,output,flits,stalled_cycles,input_occupancy_integral,utilisation\n");
+    }
+
+    bool first = true;
+    for (std::vector<Router *> *routers: { &this->req_routers, &this->rsp_routers, &this->wide_routers })
+    {
+        for (Router *router: *routers)
+        {
+            if (router != NULL)
+            {
+                router->dump_link_stats(file, json, first);
+            }
+        }
+    }
+
+    if (json)
+    {
+        fprintf(file, "\n]\n");
+    }
+
+    fclose(file);
+}
+
+
+
+int64_t FlooNoc::reserve_burst_path(int from_x, int from_y, int to_x, int to_y, bool is_wide,
+    bool is_write, bool is_address, int64_t cycle, int64_t nb_flits)
+{
+    Router *router = this->get_router(from_x, from_y, is_wide, is_write, is_address);
+
+    if (router == NULL)
+    {
+        // Nodes on the edges do not have any router, the burst enters the mesh through the
+        // closest one
+        int x = std::min(std::max(from_x, 1), this->dim_x - 2);
+        int y = std::min(std::max(from_y, 1), this->dim_y - 2);
+        router = this->get_router(x, y, is_wide, is_write, is_address);
+        if (router == NULL)
+        {
+            return cycle + nb_flits;
+        }
+    }
+
+    return router->reserve_burst_path(to_x, to_y, cycle, nb_flits);
+}
+
+
+
+Entry *FlooNoc::get_entry(uint64_t base, uint64_t size)
+{
+    // Entries are sorted by base address. Look for the first one starting after the requested
+    // location, the candidate is then the one just before.
+    auto it = std::upper_bound(this->entry_bases.begin(), this->entry_bases.end(), base);
+    if (it == this->entry_bases.begin())
+    {
+        return NULL;
+    }
+
+    Entry *entry = &this->entries[it - this->entry_bases.begin() - 1];
+    if (base + size <= entry->base + entry->size)
+    {
+        return entry;
+    }
     return NULL;
 }
 
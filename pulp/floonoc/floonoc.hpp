@@ -23,9 +23,11 @@
 #pragma once
 
 #include <vp/vp.hpp>
+#include <pulp/utils/statistics.hpp>
 
 class Router;
 class NetworkInterface;
+class RoutingAlgorithm;
 
 
 /**
@@ -75,6 +77,7 @@ public:
     FlooNoc(vp::ComponentConf &config);
 
     void reset(bool active);
+    void stop();
 
     // Return the router at specified position
     Router *get_req_router(int x, int y);
@@ -93,6 +96,12 @@ public:
     // Can be called to notify that an asynchronous response to a request was received. The noc
     // will then call the initiating network interface so that it is handled by the burst.
     void handle_request_end(vp::IoReq *req);
+    // Used in analytical burst mode to reserve the links along the path of a burst of nb_flits
+    // flits from one position to another, starting at the specified cycle. The links are taken
+    // in the network corresponding to the request type. Returns the cycle at which the last flit
+    // reaches the destination.
+    int64_t reserve_burst_path(int from_x, int from_y, int to_x, int to_y, bool is_wide,
+        bool is_write, bool is_address, int64_t cycle, int64_t nb_flits);
 
     // Internal router information is stored inside the requests.
     // These constants give the indices where the information is stored in the requests data.
@@ -105,7 +114,8 @@ public:
     static constexpr int REQ_QUEUE = 6;       // When a request is stalled, this gives the queue where to grant it
     static constexpr int REQ_WIDE = 7;        // Indicates if a request is a wide request or not. 1 for wide, 0 for narrow
     static constexpr int REQ_IS_ADDRESS = 8;     // Indicates if the request is a AR/AW request or not. 1 for address, 0 for data
-    static constexpr int REQ_NB_ARGS = 9;     // Number of request data required by this model
+    static constexpr int REQ_VC = 9;          // Virtual channel currently used by the request
+    static constexpr int REQ_NB_ARGS = 10;    // Number of request data required by this model
 
     // The following constants gives the index in the queue array of the queue associated to each direction
     static constexpr int DIR_RIGHT = 0;
@@ -118,6 +128,25 @@ public:
     // this width so that the bandwidth corresponds to the width.
     uint64_t wide_width;
     uint64_t narrow_width;
+    // True if bursts are modeled analytically. Instead of splitting them into internal requests
+    // going through the routers, a whole burst reserves the links along its path and its
+    // completion time is computed directly. This is much faster but only approximates contention.
+    bool analytical_bursts;
+    // True if statistics should be dumped at the end of the simulation
+    bool statistics;
+    // Path of the file where statistics are dumped, or empty if they should go through the trace
+    std::string statistics_file;
+    // Routing algorithm used by all routers to build their routing tables
+    RoutingAlgorithm *routing;
+    // Number of virtual channels per direction in the routers
+    int nb_vcs;
+    // Path of the file where link statistics are dumped at the end of the simulation, or empty
+    // if they should not be dumped
+    std::string link_stats_file;
+    // X dimension of the network. This includes both routers but also targets on the edges
+    int dim_x;
+    // Y dimension of the network. This includes both routers but also targets on the edges
+    int dim_y;
 
 private:
     // Callback called when a target request is asynchronously granted after a denied error was
@@ -130,12 +159,12 @@ private:
     // This block trace
     vp::Trace trace;
     // Set of memory-mapped entries, with one for each target. They give information about each
-    // target (base address, size, position)
+    // target (base address, size, position). They are sorted by base address so that the entry
+    // of an address can be found with a binary search.
     std::vector<Entry> entries;
-    // X dimension of the network. This includes both routers but also targets on the edges
-    int dim_x;
-    // Y dimension of the network. This includes both routers but also targets on the edges
-    int dim_y;
+    // Base addresses of the entries, in the same order as the entries. This is kept separately
+    // so that the binary search only goes through a compact array.
+    std::vector<uint64_t> entry_bases;
     // SIze of the routers input queues. Pushing more requests than this size will block the
     // output queue of the sender.
     int router_input_queue_size;
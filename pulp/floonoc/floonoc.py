@@ -46,15 +46,41 @@ class FlooNoc2dMeshNarrowWide(gvsoc.systree.Component):
     router_input_queue_size: int
         Size of the routers input queues. This gives the number of requests which can be buffered
         before the source output queue is stalled.
+    analytical_bursts: bool
+        If True, bursts are not split into flits going hop-by-hop through the routers. Instead
+        each burst reserves the links along its path and its completion time is computed
+        directly. This is much faster for big transfers but only approximates contention.
+    statistics: bool
+        If True, statistics are dumped at the end of the simulation, like the occupancy of the
+        network interfaces pending bursts, which can be used to tune ni_outstanding_reqs.
+    statistics_file: str
+        Path of the file where statistics are dumped. The path of the component is inserted before
+        the extension. If None, they are printed through the component trace, at info level.
+    routing: str
+        Routing algorithm used by the routers. Can be 'xy' or 'yx' for dimension-ordered routing,
+        'west_first' for west-first adaptive routing, or 'torus_xy' for dimension-ordered routing
+        on a torus, which requires a router at every node and an even number of virtual channels.
+    nb_vcs: int
+        Number of virtual channels per direction in the routers. Each virtual channel has its own
+        input queue and is stalled independently from the others.
+    link_stats_file: str
+        Path of the file where per-link statistics (flits forwarded, stalled cycles and input
+        queue occupancy of each router output) are dumped at the end of the simulation. The file
+        is in JSON format if the path ends with .json, CSV otherwise. Nothing is dumped if None.
+        With analytical bursts, the flits and stalled cycles of the bursts are accounted when
+        their path is reserved, and the input queue occupancy only covers the other requests.
     """
     def __init__(self, parent: gvsoc.systree.Component, name, narrow_width: int, wide_width:int,
-            dim_x: int, dim_y:int, ni_outstanding_reqs: int=8, router_input_queue_size: int=2):
+            dim_x: int, dim_y:int, ni_outstanding_reqs: int=8, router_input_queue_size: int=2,
+            analytical_bursts: bool=False, statistics: bool=False, routing: str='xy',
+            nb_vcs: int=1, link_stats_file: str=None, statistics_file: str=None):
         super().__init__(parent, name)
 
         self.add_sources([
             'pulp/floonoc/floonoc.cpp',
             'pulp/floonoc/floonoc_router.cpp',
             'pulp/floonoc/floonoc_network_interface.cpp',
+            'pulp/floonoc/floonoc_routing.cpp',
         ])
 
         self.add_property('mappings', {})
@@ -66,6 +92,12 @@ class FlooNoc2dMeshNarrowWide(gvsoc.systree.Component):
         self.add_property('dim_x', dim_x)
         self.add_property('dim_y', dim_y)
         self.add_property('router_input_queue_size', router_input_queue_size)
+        self.add_property('analytical_bursts', analytical_bursts)
+        self.add_property('statistics', statistics)
+        self.add_property('statistics_file', statistics_file if statistics_file is not None else '')
+        self.add_property('routing', routing)
+        self.add_property('nb_vcs', nb_vcs)
+        self.add_property('link_stats_file', link_stats_file if link_stats_file is not None else '')
 
     def __add_mapping(self, name: str, base: int, size: int, x: int, y: int, remove_offset:int =0):
         self.get_property('mappings')[name] =  {'base': base, 'size': size, 'x': x, 'y': y, 'remove_offset':remove_offset}
@@ -228,11 +260,33 @@ class FlooNocClusterGridNarrowWide(FlooNoc2dMeshNarrowWide):
         Number of clusters on the X direction. This should not include the targets on the borders.
     nb_y_clusters: int
         Number of clusters on the Y direction. This should not include the targets on the borders.
+    analytical_bursts: bool
+        If True, bursts are modeled analytically instead of going flit by flit through the routers.
+    statistics: bool
+        If True, statistics are dumped at the end of the simulation.
+    statistics_file: str
+        Path of the file where statistics are dumped, or None to print them through the trace.
+    routing: str
+        Routing algorithm used by the routers, 'xy' or 'west_first'. Since there are no routers on
+        the borders, a request stepping onto a border node is delivered to the target of this node.
+        'yx' and 'torus_xy' would step onto the north and south borders before reaching the
+        destination and can then not be used.
+    nb_vcs: int
+        Number of virtual channels per direction in the routers.
+    link_stats_file: str
+        Path of the file where per-link statistics are dumped at the end of the simulation.
     """
     def __init__(self, parent: gvsoc.systree.Component, name, wide_width: int,narrow_width:int, nb_x_clusters: int,
-            nb_y_clusters, router_input_queue_size=2, ni_outstanding_reqs: int=2):
+            nb_y_clusters, router_input_queue_size=2, ni_outstanding_reqs: int=2,
+            analytical_bursts: bool=False, statistics: bool=False, routing: str='xy',
+            nb_vcs: int=1, link_stats_file: str=None, statistics_file: str=None):
+        if routing not in ['xy', 'west_first']:
+            raise RuntimeError(f'Routing algorithm {routing} is not supported without routers on the borders')
+
         # The total grid contains 1 more node on each direction for the targets
-        super().__init__(parent, name, wide_width=wide_width, narrow_width=narrow_width, dim_x=nb_x_clusters+2, dim_y=nb_y_clusters+2, router_input_queue_size=router_input_queue_size, ni_outstanding_reqs=ni_outstanding_reqs)
+        super().__init__(parent, name, wide_width=wide_width, narrow_width=narrow_width, dim_x=nb_x_clusters+2, dim_y=nb_y_clusters+2, router_input_queue_size=router_input_queue_size, ni_outstanding_reqs=ni_outstanding_reqs,
+            analytical_bursts=analytical_bursts, statistics=statistics, routing=routing,
+            nb_vcs=nb_vcs, link_stats_file=link_stats_file, statistics_file=statistics_file)
 
         for tile_x in range(0, nb_x_clusters):
             for tile_y in range(0, nb_y_clusters):
@@ -24,16 +24,47 @@
 #include <vp/itf/io.hpp>
 #include "floonoc.hpp"
 #include "floonoc_router.hpp"
+#include "floonoc_routing.hpp"
 #include "floonoc_network_interface.hpp"
 
 NetworkInterface::NetworkInterface(FlooNoc *noc, int x, int y)
     : vp::Block(noc, "ni_" + std::to_string(x) + "_" + std::to_string(y)),
-      fsm_event(this, &NetworkInterface::fsm_handler)
+      fsm_event(this, &NetworkInterface::fsm_handler),
+      req_pool_used(*this, "req_pool_used", 64),
+      req_pool_high_water(*this, "req_pool_high_water", 64)
 {
     this->noc = noc;
     this->x = x;
     this->y = y;
     this->ni_outstanding_reqs = this->noc->get_js_config()->get("ni_outstanding_reqs")->get_int();
+    int router_input_queue_size = this->noc->get_js_config()->get_int("router_input_queue_size");
+
+    // Preallocate the internal requests. The number of requests in flight for this network
+    // interface is bounded by the router queues along the longest path, plus the outstanding
+    // bursts.
+    int pool_size = (router_input_queue_size + 1) * (this->noc->dim_x + this->noc->dim_y) +
+        this->ni_outstanding_reqs;
+    this->free_reqs.reserve(pool_size);
+    for (int i = 0; i < pool_size; i++)
+    {
+        this->free_reqs.push_back(new vp::IoReq());
+    }
+
+    // The initiator can have up to ni_outstanding_reqs bursts pending, plus one which is denied,
+    // and read responses from other network interfaces are also pushed there.
+    int ring_size = 1;
+    while (ring_size < 2 * (this->ni_outstanding_reqs + 1))
+    {
+        ring_size <<= 1;
+    }
+    this->pending_bursts.resize(ring_size);
+    this->pending_bursts_head = 0;
+    this->nb_pending_bursts = 0;
+    this->pending_bursts_histogram.resize(ring_size + 1);
+    this->pending_bursts_histogram_cycle = 0;
+
+    // On a torus, requests must be injected in the low class of virtual channels
+    this->nb_injection_vcs = this->noc->routing->is_torus() ? this->noc->nb_vcs / 2 : this->noc->nb_vcs;
 
     traces.new_trace("trace", &trace, vp::DEBUG);
 
@@ -55,13 +86,32 @@ void NetworkInterface::reset(bool active)
         this->stalled = false;
         this->pending_burst_size = 0;
         this->denied_req = NULL;
-        while (this->pending_bursts.size() > 0)
+        this->injection_busy_until = 0;
+        this->next_vc = 0;
+        while (this->nb_pending_bursts > 0)
         {
             this->remove_pending_burst();
         }
     }
 }
 
+void NetworkInterface::dump_statistics(StatisticsOutput &output)
+{
+    this->update_pending_bursts_histogram();
+
+    output.print(this, "request pool high-water: %ld", this->req_pool_high_water.get());
+
+    std::string histogram;
+    for (int i = 0; i < this->pending_bursts_histogram.size(); i++)
+    {
+        if (this->pending_bursts_histogram[i] != 0)
+        {
+            histogram += " " + std::to_string(i) + ": " + std::to_string(this->pending_bursts_histogram[i]);
+        }
+    }
+    output.print(this, "pending bursts histogram (occupancy: cycles):%s", histogram.c_str());
+}
+
 int NetworkInterface::get_x()
 {
     return this->x;
@@ -72,6 +122,50 @@ int NetworkInterface::get_y()
     return this->y;
 }
 
+vp::IoReq *NetworkInterface::alloc_req()
+{
+    vp::IoReq *req;
+
+    if (this->free_reqs.empty())
+    {
+        // The pool is too small, allocate a new request, it will stay in the pool once released
+        req = new vp::IoReq();
+    }
+    else
+    {
+        req = this->free_reqs.back();
+        this->free_reqs.pop_back();
+    }
+
+    int64_t used = this->req_pool_used.get() + 1;
+    this->req_pool_used.set(used);
+    if (used > this->req_pool_high_water.get())
+    {
+        this->req_pool_high_water.set(used);
+    }
+
+    req->init();
+    req->arg_alloc(FlooNoc::REQ_NB_ARGS);
+    *req->arg_get(FlooNoc::REQ_SRC_NI) = (void *)this;
+    *req->arg_get(FlooNoc::REQ_VC) = (void *)0;
+
+    return req;
+}
+
+void NetworkInterface::free_req(vp::IoReq *req)
+{
+    this->free_reqs.push_back(req);
+    this->req_pool_used.set(this->req_pool_used.get() - 1);
+}
+
+void NetworkInterface::release_req(vp::IoReq *req)
+{
+    // Requests may be released by another network interface than the one which allocated them,
+    // for example data requests are released at destination. Always give them back to the owner.
+    NetworkInterface *owner = *(NetworkInterface **)req->arg_get(FlooNoc::REQ_SRC_NI);
+    owner->free_req(req);
+}
+
 void NetworkInterface::unstall_queue(int from_x, int from_y)
 {
     // The request which was previously denied has been granted. Unstall the output queue
@@ -110,15 +204,21 @@ vp::IoReqStatus NetworkInterface::req(vp::Block *__this, vp::IoReq *req)
     // Since we handle it asynchronously, we need to start it only once its latency has been
     // reached
     req->set_latency(0); // Actually dont do that because the cluster sent them with some latency that doesnt make sense
+
+    if (_this->noc->analytical_bursts)
+    {
+        return _this->handle_burst_analytical(req);
+    }
+
     // Just enqueue it and trigger the FSM which will check if it must be processed now
-    _this->add_pending_burst(req, true, _this->clock.get_cycles() + req->get_latency(), std::make_tuple(_this->x, _this->y));
+    _this->add_pending_burst(req, true, _this->clock.get_cycles() + req->get_latency(), _this->x, _this->y);
 
     _this->fsm_event.enqueue(
-        std::max((int64_t)1, _this->pending_bursts_timestamp.front() - _this->clock.get_cycles()));
+        std::max((int64_t)1, _this->get_pending_burst()->timestamp - _this->clock.get_cycles()));
     // req->set_latency(0);
 
     // Only accept the request if we don't have too many pending requests
-    if (_this->pending_bursts.size() >= _this->ni_outstanding_reqs)
+    if (_this->nb_pending_bursts >= _this->ni_outstanding_reqs)
     {
         _this->denied_req = req;
         return vp::IO_REQ_DENIED;
@@ -150,16 +250,24 @@ vp::IoReqStatus NetworkInterface::req_from_router(vp::IoReq *req, int pos_x, int
         // Note: Memory is read/written already here. The backward path is only used to get the delay of the network.
         vp::IoReqStatus result = target->req(req);
 
+        if (result == vp::IO_REQ_OK || result == vp::IO_REQ_INVALID)
+        {
+            // The address request is not needed anymore once the target access is done.
+            // The router stored its grant information before sending it and does not access it
+            // anymore, even if we report it as denied below.
+            NetworkInterface::release_req(req);
+        }
+
         if(!burst->get_is_write()){
             // If the burst is a read burst, we need to send the data back to the origin
             // For a write nothing needs to be done. The sending NI will take care of it
-            this->add_pending_burst(burst, false, 0, std::make_tuple(origin_ni->get_x(), origin_ni->get_y()));
+            this->add_pending_burst(burst, false, 0, origin_ni->get_x(), origin_ni->get_y());
             // Enqueue the FSM event to process the burst by sending the data back
             this->fsm_event.enqueue();
         }
 
         // Check if the next would be denied and already notify the router. Note this is a bit hacky and misuses the vp::Req::Status but for now it should work
-        if(this->pending_burst_isaddr.size() >= this->ni_outstanding_reqs){
+        if(this->nb_pending_bursts >= this->ni_outstanding_reqs){
             this->trace.msg(vp::Trace::LEVEL_DEBUG, "Request denied because of too many pending requests\n");
             return vp::IO_REQ_DENIED;
         }
@@ -184,9 +292,9 @@ void NetworkInterface::fsm_handler(vp::Block *__this, vp::ClockEvent *event)
     _this->trace.msg(vp::Trace::LEVEL_DEBUG, "fsm handler invoked\n");
     if (!_this->stalled){
         // Check if there is a pending burst to process
-        if(_this->pending_bursts.size() > 0){
+        if(_this->nb_pending_bursts > 0){
             //Check if the burst is a forward going burst, or a backward going one
-            if (_this->pending_burst_isaddr.front()){
+            if (_this->get_pending_burst()->isaddr){
                 _this->handle_addr_req();
             }
             else {
@@ -203,20 +311,33 @@ void NetworkInterface::fsm_handler(vp::Block *__this, vp::ClockEvent *event)
 }
 
 
+PendingBurst *NetworkInterface::get_pending_burst()
+{
+    return &this->pending_bursts[this->pending_bursts_head];
+}
+
+
+void NetworkInterface::update_pending_bursts_histogram()
+{
+    int64_t cycles = this->clock.get_cycles();
+    this->pending_bursts_histogram[this->nb_pending_bursts] += cycles - this->pending_bursts_histogram_cycle;
+    this->pending_bursts_histogram_cycle = cycles;
+}
+
+
 void NetworkInterface::remove_pending_burst(void){
-    this->pending_bursts.pop();
-    this->pending_burst_isaddr.pop();
-    this->pending_bursts_timestamp.pop();
-    this->pending_bursts_origin_pos.pop();
+    this->update_pending_bursts_histogram();
+    this->pending_bursts_head = (this->pending_bursts_head + 1) & (this->pending_bursts.size() - 1);
+    this->nb_pending_bursts--;
 
-    if (this->pending_bursts.size() == this->ni_outstanding_reqs - 1){
+    if (this->nb_pending_bursts == this->ni_outstanding_reqs - 1){
         // If we removed a pending burst and the number of pending bursts was the maximum, notify the local router that it can send another request
         Router *lrouter = this->noc->get_req_router(this->x, this->y);
         lrouter->unstall_queue(this->x, this->y);
     }
 
     // We also have to check if another burst has been denied that can now be granted
-    if (this->denied_req && this->pending_bursts.size() != this->ni_outstanding_reqs)
+    if (this->denied_req && this->nb_pending_bursts != this->ni_outstanding_reqs)
     {
         this->trace.msg(vp::Trace::LEVEL_TRACE, "Unstalling denied request (req: %p)\n", this->denied_req);
         vp::IoReq *req = this->denied_req;
@@ -226,23 +347,49 @@ void NetworkInterface::remove_pending_burst(void){
 }
 
 
-void NetworkInterface::add_pending_burst(vp::IoReq *burst, bool isaddr, int64_t timestamp, std::tuple<int, int> origin_pos){
-    this->pending_bursts.push(burst);
-    this->pending_burst_isaddr.push(isaddr);
-    this->pending_bursts_timestamp.push(timestamp);
-    this->pending_bursts_origin_pos.push(origin_pos); // Also store the origin coordinates of the burst
+void NetworkInterface::add_pending_burst(vp::IoReq *burst, bool isaddr, int64_t timestamp, int origin_x, int origin_y){
+    int size = this->pending_bursts.size();
+
+    if (this->nb_pending_bursts == size)
+    {
+        // The ring buffer is full, double its size and move the bursts so that they are again
+        // contiguous from the head
+        std::vector<PendingBurst> bursts(size * 2);
+        for (int i = 0; i < size; i++)
+        {
+            bursts[i] = this->pending_bursts[(this->pending_bursts_head + i) & (size - 1)];
+        }
+        this->pending_bursts.swap(bursts);
+        this->pending_bursts_head = 0;
+        this->pending_bursts_histogram.resize(size * 2 + 1);
+        size *= 2;
+    }
+
+    this->update_pending_bursts_histogram();
+
+    PendingBurst *pending = &this->pending_bursts[(this->pending_bursts_head + this->nb_pending_bursts) & (size - 1)];
+    pending->burst = burst;
+    pending->isaddr = isaddr;
+    pending->timestamp = timestamp;
+    pending->origin_x = origin_x; // Also store the origin coordinates of the burst
+    pending->origin_y = origin_y;
+    pending->vc = this->next_vc;
+    this->next_vc = this->next_vc + 1 == this->nb_injection_vcs ? 0 : this->next_vc + 1;
+    this->nb_pending_bursts++;
     this->fsm_event.enqueue(); // Check if we can process the burst now
 }
 
 void NetworkInterface::handle_addr_req(void){
 
-    if(this->pending_bursts_timestamp.front() <= this->clock.get_cycles()){
-        vp::IoReq *burst = this->pending_bursts.front();
+    PendingBurst *pending = this->get_pending_burst();
+
+    if(pending->timestamp <= this->clock.get_cycles()){
+        vp::IoReq *burst = pending->burst;
         // Get the current burst to be processed
         this->trace.msg(vp::Trace::LEVEL_DEBUG, "Handling addr burst (burst: %p, offset: 0x%x, size: 0x%x, is_write: %d, op: %d)\n",
                         burst, burst->get_addr(), burst->get_size(), burst->get_is_write(), burst->get_opcode());
 
-        vp::IoReq *req = new vp::IoReq();
+        vp::IoReq *req = this->alloc_req();
 
         // Get base and size from current burst
         uint64_t base = burst->get_addr();
@@ -251,12 +398,10 @@ void NetworkInterface::handle_addr_req(void){
         bool wide = *(bool *)burst->arg_get(FlooNoc::REQ_WIDE);
 
         // Fill in the information needed by the target network interface to send back the response
-        req->init();
-        req->arg_alloc(FlooNoc::REQ_NB_ARGS);
-        *req->arg_get(FlooNoc::REQ_SRC_NI) = (void *)this;
         *req->arg_get(FlooNoc::REQ_BURST) = (void *)burst;
         *req->arg_get(FlooNoc::REQ_IS_ADDRESS) = (void *)1;
         *req->arg_get(FlooNoc::REQ_WIDE) = (void *)wide;
+        *req->arg_get(FlooNoc::REQ_VC) = (void *)(long)pending->vc;
         req->set_size(size);
         req->set_data(burst->get_data());
         req->set_is_write(burst->get_is_write());
@@ -269,6 +414,7 @@ void NetworkInterface::handle_addr_req(void){
         {
             // Burst is invalid if no target is found
             this->trace.msg(vp::Trace::LEVEL_ERROR, "No entry found for base 0x%x\n", base);
+            this->free_req(req);
             return;
             burst->status = vp::IO_REQ_INVALID;
 
@@ -299,8 +445,9 @@ void NetworkInterface::handle_addr_req(void){
             {
                 // Modifiy the burst so it is no longer an address request and will get handled as a data request in the next cycle
                 this->trace.msg(vp::Trace::LEVEL_TRACE, "Modifying burst to be a data request\n");
-                this->pending_burst_isaddr.front() = false;
-                this->pending_bursts_origin_pos.front() = std::make_tuple(entry->x, entry->y); // This is actually where the data will be sent back. TODO Rename this variable
+                pending->isaddr = false;
+                pending->origin_x = entry->x; // This is actually where the data will be sent back. TODO Rename this variable
+                pending->origin_y = entry->y;
             }
             else{
                 this->remove_pending_burst();
@@ -314,17 +461,17 @@ void NetworkInterface::handle_addr_req(void){
         this->trace.msg(vp::Trace::LEVEL_TRACE, "fsm handler invoked but burst not yet ready\n");
         // If we did not handle the first pending burst because we haven't reached its
         // timestamp, schedule the event at this timestamp to be able to process it
-        this->trace.msg(vp::Trace::LEVEL_TRACE, "Enqueuing response handler for timestamp: %ld)\n", this->pending_bursts_timestamp.front());
+        this->trace.msg(vp::Trace::LEVEL_TRACE, "Enqueuing response handler for timestamp: %ld)\n", pending->timestamp);
         this->fsm_event.enqueue(
-            this->pending_bursts_timestamp.front() - this->clock.get_cycles());
+            pending->timestamp - this->clock.get_cycles());
     }
 }
 
 void NetworkInterface::handle_data_req(void){
     this->trace.msg(vp::Trace::LEVEL_TRACE, "Handling data burst\n");
 
-    vp::IoReq *burst = this->pending_bursts.front();
-    std::tuple<int, int> origin_pos = this->pending_bursts_origin_pos.front();
+    PendingBurst *pending = this->get_pending_burst();
+    vp::IoReq *burst = pending->burst;
     bool wide = *(bool *)burst->arg_get(FlooNoc::REQ_WIDE);
 
     // If we handle the burst for the first time, we need to store the base, data and size
@@ -352,21 +499,19 @@ void NetworkInterface::handle_data_req(void){
     uint64_t size = std::min(width, this->pending_burst_size);
 
 
-    // Create a new request to send
-    vp::IoReq *req = new vp::IoReq();
-    req->init();
-    req->arg_alloc(FlooNoc::REQ_NB_ARGS);
-    *req->arg_get(FlooNoc::REQ_SRC_NI) = (void *)this;
+    // Get a new request to send
+    vp::IoReq *req = this->alloc_req();
     *req->arg_get(FlooNoc::REQ_BURST) = (void *)burst;
     *req->arg_get(FlooNoc::REQ_IS_ADDRESS) = (void *)0;
     *req->arg_get(FlooNoc::REQ_WIDE) = (void *)wide;
+    *req->arg_get(FlooNoc::REQ_VC) = (void *)(long)pending->vc;
     req->set_size(size);
     req->set_is_write(burst->get_is_write());
     req->set_addr(this->pending_burst_base);
 
     // Store information in the request which will be needed by the routers and the target
-    int src_x = std::get<0>(origin_pos);
-    int src_y = std::get<1>(origin_pos);
+    int src_x = pending->origin_x;
+    int src_y = pending->origin_y;
     *req->arg_get(FlooNoc::REQ_DEST_X) = (void *)(long)src_x;
     *req->arg_get(FlooNoc::REQ_DEST_Y) = (void *)(long)src_y;
 
@@ -403,8 +548,119 @@ void NetworkInterface::handle_data_req(void){
 }
 
 
+vp::IoReqStatus NetworkInterface::handle_burst_analytical(vp::IoReq *burst)
+{
+    uint64_t base = burst->get_addr();
+    uint64_t size = burst->get_size();
+    bool wide = burst->get_int(FlooNoc::REQ_WIDE);
+    bool is_write = burst->get_is_write();
+
+    Entry *entry = this->noc->get_entry(base, size);
+    if (entry == NULL)
+    {
+        this->trace.msg(vp::Trace::LEVEL_ERROR, "No entry found for base 0x%x\n", base);
+        return vp::IO_REQ_INVALID;
+    }
+
+    uint64_t width = wide ? this->noc->wide_width : this->noc->narrow_width;
+    int64_t nb_flits = std::max((uint64_t)1, (size + width - 1) / width);
+
+    // The address flit is injected first and, for writes, is followed by the data flits on the
+    // same network. Reads only inject the address flit, data will come back on the response path.
+    int64_t nb_injected_flits = is_write ? nb_flits + 1 : 1;
+    int64_t start = std::max(this->clock.get_cycles(), this->injection_busy_until);
+    this->injection_busy_until = start + nb_injected_flits;
+
+    int64_t end = this->noc->reserve_burst_path(this->x, this->y, entry->x, entry->y, wide,
+        is_write, true, start, nb_injected_flits);
+
+    this->trace.msg(vp::Trace::LEVEL_DEBUG, "Reserved analytical burst path (burst: %p, base: 0x%x, size: 0x%x, is_write: %d, destination: (%d, %d), start: %ld, end: %ld)\n",
+        burst, base, size, is_write, entry->x, entry->y, start, end);
+
+    // The target access is done at once for the whole burst
+    vp::IoReq *req = this->alloc_req();
+    *req->arg_get(FlooNoc::REQ_BURST) = (void *)burst;
+    *req->arg_get(FlooNoc::REQ_IS_ADDRESS) = (void *)1;
+    *req->arg_get(FlooNoc::REQ_WIDE) = (void *)wide;
+    *req->arg_get(FlooNoc::REQ_DEST_X) = (void *)(long)entry->x;
+    *req->arg_get(FlooNoc::REQ_DEST_Y) = (void *)(long)entry->y;
+    *req->arg_get(FlooNoc::REQ_ROUTER) = NULL;
+    req->set_addr(base - entry->remove_offset);
+    req->set_size(size);
+    req->set_data(burst->get_data());
+    req->set_is_write(is_write);
+    req->set_opcode(burst->get_opcode());
+    req->set_second_data(burst->get_second_data());
+
+    vp::IoMaster *target = this->noc->get_target(entry->x, entry->y);
+    vp::IoReqStatus result = target->req(req);
+
+    if (result == vp::IO_REQ_OK || result == vp::IO_REQ_INVALID)
+    {
+        end += req->get_latency();
+
+        if (!is_write)
+        {
+            // Read data is sent back from the target to this network interface
+            end = this->noc->reserve_burst_path(entry->x, entry->y, this->x, this->y, wide,
+                false, false, end, nb_flits);
+        }
+
+        burst->status = result;
+        burst->inc_latency(end - this->clock.get_cycles());
+
+        this->trace.msg(vp::Trace::LEVEL_DEBUG, "Finished analytical burst (burst: %p, latency: %ld)\n",
+            burst, burst->get_latency());
+
+        this->free_req(req);
+        return result;
+    }
+
+    // The target will reply later, the network interface will then account the response path
+    // and reply to the burst. The latency of the forward path is kept in the burst so that it is
+    // added to the response one.
+    burst->inc_latency(end - this->clock.get_cycles());
+    return vp::IO_REQ_PENDING;
+}
+
+
+void NetworkInterface::handle_response_analytical(vp::IoReq *req)
+{
+    vp::IoReq *burst = *(vp::IoReq **)req->arg_get(FlooNoc::REQ_BURST);
+    int dest_x = req->get_int(FlooNoc::REQ_DEST_X);
+    int dest_y = req->get_int(FlooNoc::REQ_DEST_Y);
+    bool wide = req->get_int(FlooNoc::REQ_WIDE);
+
+    int64_t end = this->clock.get_cycles();
+
+    if (!burst->get_is_write())
+    {
+        uint64_t width = wide ? this->noc->wide_width : this->noc->narrow_width;
+        int64_t nb_flits = std::max((uint64_t)1, (burst->get_size() + width - 1) / width);
+
+        end = this->noc->reserve_burst_path(dest_x, dest_y, this->x, this->y, wide,
+            false, false, end, nb_flits);
+    }
+
+    burst->status = req->status;
+    burst->inc_latency(end - this->clock.get_cycles());
+
+    this->trace.msg(vp::Trace::LEVEL_DEBUG, "Finished analytical burst (burst: %p, latency: %ld)\n",
+        burst, burst->get_latency());
+
+    this->free_req(req);
+    burst->get_resp_port()->resp(burst);
+}
+
+
 void NetworkInterface::handle_response(vp::IoReq *req)
 {
+    if (this->noc->analytical_bursts)
+    {
+        this->handle_response_analytical(req);
+        return;
+    }
+
     // This gets called by the routers when an internal request has been handled
     // First extract the corresponding burst from the request so that we can update the burst.
     vp::IoReq *burst = *(vp::IoReq **)req->arg_get(FlooNoc::REQ_BURST);
@@ -427,8 +683,8 @@ void NetworkInterface::handle_response(vp::IoReq *req)
         this->trace.msg(vp::Trace::LEVEL_DEBUG, "Finished %s burst (burst: %p, latency: %d)\n", burst->get_int(FlooNoc::REQ_WIDE) ? "wide" : "narrow", burst, burst->get_latency());
         burst->get_resp_port()->resp(burst);
     }
-    // Delete the request since we don't need it anymore
-    delete req;
+    // Release the request since we don't need it anymore
+    NetworkInterface::release_req(req);
     // Trigger the FSM since something may need to be done now that a new request is available
     this->fsm_event.enqueue();
 }
@@ -23,9 +23,35 @@
 #pragma once
 
 #include <vp/vp.hpp>
+#include <vp/signal.hpp>
+#include <pulp/utils/statistics.hpp>
 
 class FlooNoc;
 
+/**
+ * @brief Pending burst descriptor
+ *
+ * This gathers all the information the network interface needs about a burst waiting to be
+ * processed, so that it can be stored in a single ring buffer.
+ */
+struct PendingBurst
+{
+    // The burst itself
+    vp::IoReq *burst;
+    // Timestamp at which the burst can start to take into account the burst latency
+    int64_t timestamp;
+    // Position where the internal requests of this burst must be sent. For read data this is
+    // the origin of the burst, for write data this is the target.
+    int origin_x;
+    int origin_y;
+    // True if this is an address burst, false if it is a data burst. This is used to know if the
+    // burst must be processed by the address handler or the data handler
+    bool isaddr;
+    // Virtual channel on which all internal requests of this burst are injected, so that they
+    // stay ordered
+    int vc;
+};
+
 /**
  * @brief FlooNoc network interface
  *
@@ -40,6 +66,8 @@ public:
     NetworkInterface(FlooNoc *noc, int x, int y);
 
     void reset(bool active);
+    // Dump the statistics of this network interface, called by the top at the end of the simulation
+    void dump_statistics(StatisticsOutput &output);
 
     // This gets called by the top when an asynchronous response is received from a target.
     void handle_response(vp::IoReq *req);
@@ -49,6 +77,9 @@ public:
 
     // This gets called by a router when the destination is reached and the request is sent from the router to the network interface
     vp::IoReqStatus req_from_router(vp::IoReq *req, int pos_x, int pos_y);
+    // Release an internal request once it is not needed anymore. The request goes back to the
+    // pool of the network interface which allocated it.
+    static void release_req(vp::IoReq *req);
     // Can be used to retrieve the x coordinate of the network interface
     int get_x();
     // Can be used to retrieve the y coordinate of the network interface
@@ -71,7 +102,22 @@ private:
     // This gets called to remove the current pending burst and also remove all related information from the other queues
     void remove_pending_burst(void);
     // This gets called to add a new pending burst to the queue
-    void add_pending_burst(vp::IoReq *burst, bool isaddr, int64_t timestamp, std::tuple<int, int> origin_pos);
+    void add_pending_burst(vp::IoReq *burst, bool isaddr, int64_t timestamp, int origin_x, int origin_y);
+    // Return the oldest pending burst, which is the one currently processed
+    PendingBurst *get_pending_burst();
+    // Account the time spent with the current number of pending bursts in the histogram. Must be
+    // called before the number of pending bursts is modified.
+    void update_pending_bursts_histogram();
+    // This gets called instead of queueing the burst when bursts are modeled analytically
+    vp::IoReqStatus handle_burst_analytical(vp::IoReq *burst);
+    // This gets called in analytical burst mode when the target access of a burst is over to
+    // account the path of the read data back to this network interface.
+    void handle_response_analytical(vp::IoReq *req);
+    // Get an internal request from the pool. The request is initialized and its source network
+    // interface is set to this one.
+    vp::IoReq *alloc_req();
+    // Put back a request allocated by this network interface into the pool
+    void free_req(vp::IoReq *req);
     // Pointer to top
     FlooNoc *noc;
     // X position of this network interface in the grid
@@ -86,17 +132,24 @@ private:
     vp::IoSlave narrow_input_itf;
     // This block trace
     vp::Trace trace;
-    // Queue of pending incoming bursts. Any received burst is pushed there and they are processed
-    // one by one sequentially by the network interface.
-    std::queue<vp::IoReq *> pending_bursts;
-    // Also store if the burst is an address burst or a data burst. This is used to know if the
-    // burst must be processed by the address handler or the data handler
-    std::queue<bool> pending_burst_isaddr;
-    // Also a maintain a queue of timestamps at which the corresponding burst can start to take
-    // into account the burst latency.
-    std::queue<int64_t> pending_bursts_timestamp;
-    // Also store the origin position of the burst to know where to send the response requests
-    std::queue<std::tuple<int, int>> pending_bursts_origin_pos;
+    // Ring buffer of pending incoming bursts. Any received burst is pushed there and they are
+    // processed one by one sequentially by the network interface. Its size is a power of 2 so
+    // that indexes can be wrapped with a mask. It is sized from the maximum number of outstanding
+    // bursts and only grows if more bursts are pushed, which can happen with read responses.
+    std::vector<PendingBurst> pending_bursts;
+    // Index of the oldest pending burst in the ring buffer
+    int pending_bursts_head;
+    // Number of pending bursts in the ring buffer
+    int nb_pending_bursts;
+    // Number of cycles spent with each number of pending bursts, used to tune ni_outstanding_reqs
+    std::vector<int64_t> pending_bursts_histogram;
+    // Cycle at which the number of pending bursts was last modified
+    int64_t pending_bursts_histogram_cycle;
+    // Number of virtual channels where bursts can be injected. Bursts are assigned to them in
+    // round-robin.
+    int nb_injection_vcs;
+    // Virtual channel which will be assigned to the next pending burst
+    int next_vc;
     // Current base address of the burst currently being processed. It is used to update the address
     // of the internal requests send to the routers to process the burst
     uint64_t pending_burst_base;
@@ -115,4 +168,15 @@ private:
     // When initiator is stalled because max number of input pending req has been reached,
     // this give the input request which has been stalled and must be granted.
     vp::IoReq *denied_req;
+    // Used in analytical burst mode to give the cycle from which the network interface can
+    // inject a new burst, since flits are injected one per cycle.
+    int64_t injection_busy_until;
+    // Pool of free internal requests. Requests are allocated once and then recycled, the pool
+    // only grows if more requests than its initial size are in flight.
+    std::vector<vp::IoReq *> free_reqs;
+    // Number of requests currently taken from the pool
+    vp::Signal<int64_t> req_pool_used;
+    // Maximum number of requests which have been taken from the pool at the same time. This can
+    // be used to size the pool.
+    vp::Signal<int64_t> req_pool_high_water;
 };
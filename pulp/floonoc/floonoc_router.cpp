@@ -24,6 +24,7 @@
 #include <vp/itf/io.hpp>
 #include "floonoc.hpp"
 #include "floonoc_router.hpp"
+#include "floonoc_routing.hpp"
 #include "floonoc_network_interface.hpp"
 
 Router::Router(FlooNoc *noc, std::string name, int x, int y, int queue_size)
@@ -36,29 +37,45 @@ Router::Router(FlooNoc *noc, std::string name, int x, int y, int queue_size)
     this->x = x;
     this->y = y;
     this->queue_size = queue_size;
-
-    // Create a queue for each direction (N, E, S, W, local)
-    for (int i = 0; i < 5; i++)
+    this->nb_vcs = noc->nb_vcs;
+    this->nb_queues = 5 * this->nb_vcs;
+    this->all_queues_mask = (1 << this->nb_queues) - 1;
+    this->torus = noc->routing->is_torus();
+
+    // Create a queue for each direction (N, E, S, W, local) and each virtual channel
+    this->input_queues.resize(this->nb_queues);
+    for (int i = 0; i < this->nb_queues; i++)
     {
         this->input_queues[i] = new vp::Queue(this, "input_queue_" + std::to_string(i),
             &this->fsm_event);
 
         this->stalled_queues[i] = false;
     }
+
+    // Signals giving the number of flits forwarded on each output, so that link utilisation can
+    // be seen in traces without enabling debug messages
+    const char *dir_names[] = { "right", "left", "up", "down", "local" };
+    for (int i = 0; i < 5; i++)
+    {
+        this->out_flits_signals[i] = new vp::Signal<uint64_t>(*this,
+            std::string("out_") + dir_names[i] + "_flits", 64);
+    }
 }
 
 bool Router::handle_request(vp::IoReq *req, int from_x, int from_y)
 {
     this->trace.msg(vp::Trace::LEVEL_DEBUG, "Handle request (req: %p, base: 0x%x, size: 0x%x, from: (%d, %d)\n", req, req->get_addr(), req->get_size(), from_x, from_y);
 
-    // Each direction has its own input queue to properly implement the round-robin
-    // Get the one for the router or network interface which sent this request
-    int queue_index = this->get_req_queue(from_x, from_y);
+    // Each direction and virtual channel has its own input queue to properly implement the
+    // round-robin. Get the one for the router or network interface which sent this request
+    int queue_index = this->get_req_queue(from_x, from_y) * this->nb_vcs + req->get_int(FlooNoc::REQ_VC);
 
     this->trace.msg(vp::Trace::LEVEL_DEBUG, "Pushed request to input queue (req: %p, queue: %d)\n", req, queue_index);
 
     // And push it to the queue. The queue will automatically trigger the FSM if needed
     vp::Queue *queue = this->input_queues[queue_index];
+    this->pending_inputs |= 1 << queue_index;
+    this->update_occupancy(queue_index / this->nb_vcs, 1);
     queue->push_back(req, 1); // The queue has an intrinsic delay of 1. With this additional delay, we model the fact that a real router takes 2 cycles to forward a request
 
     // We let the source enqueue one more request than what is possible to model the fact the fact
@@ -74,199 +91,371 @@ void Router::fsm_handler(vp::Block *__this, vp::ClockEvent *event)
     // The routers can process 1 incoming request from each direction and send 1 request to each of the directions in 1 cycle
     // The round robin is used to make sure we don't always process the same direction first
     _this->trace.msg(vp::Trace::LEVEL_DEBUG, "Current queue: %d\n", _this->current_queue);
-    // Get the currently active queue and update it to implement the round-robin
-    int in_queue_index = _this->current_queue;
-
-    // Update the current queue so that another one is checked first during the next cycle
-    // _this->current_queue += 1;
-    // if (_this->current_queue == 5)
-    // {
-    //     _this->current_queue = 0;
-    // }
+
+    // Only the input queues which have requests and whose head is not waiting for a stalled
+    // output can make progress. If there is none, the router sleeps until a new request arrives
+    // or an output is unstalled.
+    uint32_t ready = _this->pending_inputs & ~_this->waiting_inputs;
+    if (ready == 0)
+    {
+        return;
+    }
+
+    // Rotate the mask so that the first set bit is the first queue to check in round-robin order,
+    // starting from the current queue
+    int nb_queues = _this->nb_queues;
+    int start = _this->current_queue;
+    uint32_t candidates = ((ready >> start) | (ready << (nb_queues - start))) & _this->all_queues_mask;
+
     bool output_full[5] = {false}; // Used to make sure we only send a single request per cycle to each direction
-    // Then go through the 5 input queues until we find a request which can be propagated
-    for (int i = 0; i < 5; i++)
+    // Set if something may be done in the next cycle
+    bool check_next_cycle = false;
+
+    // Then go through the ready input queues until we find a request which can be propagated
+    while (candidates)
     {
+        int in_queue_index = start + __builtin_ctz(candidates);
+        if (in_queue_index >= nb_queues)
+        {
+            in_queue_index -= nb_queues;
+        }
+        candidates &= candidates - 1;
+
         vp::Queue *queue = _this->input_queues[in_queue_index];
         _this->trace.msg(vp::Trace::LEVEL_TRACE, "Checking input queue (queue_index: %d, queue size: %d)\n", in_queue_index, queue->size());
-        if (!queue->empty())
+        if (queue->empty())
         {
-            vp::IoReq *req = (vp::IoReq *)queue->head();
-
-            // Extract the destination from the request, that was filled in the network interface
-            // when the request was created
-            int to_x = req->get_int(FlooNoc::REQ_DEST_X);
-            int to_y = req->get_int(FlooNoc::REQ_DEST_Y);
-
-            // Get the next position in the grid. This takes care of deciding which path is taken
-            // to go to the destination
-            int next_x, next_y;
-            _this->get_next_router_pos(to_x, to_y, next_x, next_y);
-            _this->trace.msg(vp::Trace::LEVEL_DEBUG, "Resolved next position (req: %p, dest: (%d, %d), next_position: (%d, %d))\n",
-                             req, to_x, to_y, next_x, next_y);
+            // The queue has requests which are not yet ready, it will trigger the FSM when it is
+            queue->trigger_next();
+            continue;
+        }
 
-            // Get output queue ID from next position
-            int out_queue_id = _this->get_req_queue(next_x, next_y);
+        vp::IoReq *req = (vp::IoReq *)queue->head();
+
+        // Extract the destination from the request, that was filled in the network interface
+        // when the request was created
+        int to_x = req->get_int(FlooNoc::REQ_DEST_X);
+        int to_y = req->get_int(FlooNoc::REQ_DEST_Y);
+        int vc = req->get_int(FlooNoc::REQ_VC);
+        int in_dir = in_queue_index / _this->nb_vcs;
+
+        // Get the route to the destination. This has been precomputed and takes care of
+        // deciding which paths can be taken to go to the destination
+        RouteEntry *route = &_this->routes[to_y * _this->noc->dim_x + to_x];
+
+        // Take the first output which can accept the request in this cycle. Deterministic
+        // routing only gives one output, while adaptive routing can give another one to go around
+        // a stalled output.
+        int out_dir = -1;
+        int out_vc = 0;
+        bool output_busy = false;
+        for (int i = 0; i < route->nb_outputs; i++)
+        {
+            int dir = route->outputs[i];
+            int next_vc = _this->get_next_vc(in_dir, dir, vc);
 
             // Only send one request per cycle to the same output
-            if (output_full[out_queue_id])
+            if (output_full[dir])
             {
-                _this->trace.msg(vp::Trace::LEVEL_TRACE, "Output queue is full. Skipping. out queue: %d\n", out_queue_id);
-                _this->fsm_event.enqueue(); // Check again in next cycle
-                in_queue_index += 1;
-                if (in_queue_index == 5)
-                {
-                    in_queue_index = 0;
-                }
-                continue; // Skip this request and isntead check another input queue
+                _this->trace.msg(vp::Trace::LEVEL_TRACE, "Output queue is full. Skipping. out queue: %d\n", dir);
+                output_busy = true;
+                continue;
             }
-            output_full[out_queue_id] = true;
 
             // In case the request goes to a queue which is stalled, skip it
             // we'll retry later
-            if (_this->stalled_queues[out_queue_id])
+            if (_this->stalled_queues[dir * _this->nb_vcs + next_vc])
             {
-                _this->trace.msg(vp::Trace::LEVEL_TRACE, "Output queue is stalled. Skipping. out queue: %d\n", out_queue_id);
-                // Don't enque here because the stalled router will notifiy once it is unstalled
-                in_queue_index += 1;
-                if (in_queue_index == 5)
-                {
-                    in_queue_index = 0;
-                }
+                _this->trace.msg(vp::Trace::LEVEL_TRACE, "Output queue is stalled. Skipping. out queue: %d, vc: %d\n", dir, next_vc);
                 continue;
             }
 
-            // Since we now know, that the request will be propagated, remove it from the queue
-            queue->pop();
-
-            if (queue->size() == _this->queue_size) // Remember we let the source enqueue one more request than what is possible.
-            {
-                // In case the queue had one more element than possible, it means the output
-                // queue of the sending router is stalled. Unstall it now that we can accept
-                // one more request
-                _this->unstall_previous(req, in_queue_index);
-            }
+            out_dir = dir;
+            out_vc = next_vc;
+            break;
+        }
 
-            // Now send to the next position
-            if (to_x == _this->x && to_y == _this->y)
+        if (out_dir == -1)
+        {
+            if (output_busy)
             {
-                // If next position is the same as the current one, it means it arrived to
-                // destination, we need to forward to the final target
-                _this->send_to_target_ni(req, _this->x, _this->y);
+                check_next_cycle = true; // Check again in next cycle
             }
             else
             {
-                // Otherwise forward to next position
-                Router *router = _this->noc->get_router(next_x, next_y, req->get_int(FlooNoc::REQ_WIDE), req->get_is_write(), req->get_int(FlooNoc::REQ_IS_ADDRESS));
-
-                if (router == NULL)
-                {
-                    // It is possible that we don't have any router at the destination if it is on
-                    // the edge. In this case just forward it to the ni of the target
-                    _this->send_to_target_ni(req, next_x, next_y);
-                }
-                else
+                // Don't enque here because the stalled router will notifiy once it is unstalled.
+                // Just remember that this input is waiting for these outputs so that it is not
+                // checked again until one of them is unstalled.
+                _this->waiting_inputs |= 1 << in_queue_index;
+                for (int i = 0; i < route->nb_outputs; i++)
                 {
-                    _this->trace.msg(vp::Trace::LEVEL_DEBUG, "Forwarding request to next router (req: %p, base: 0x%x, size: 0x%x, next_position: (%d, %d), in_queue: %d)\n",
-                                     req, req->get_addr(), req->get_size(), next_x, next_y, in_queue_index);
-                    // Send the request to next router, and in case it reports that its input queue
-                    // is full, stall the corresponding output queue to make sure we stop sending
-                    // there until the queue is unstalled
-                    if (router->handle_request(req, _this->x, _this->y))
-                    {
-                        _this->trace.msg(vp::Trace::LEVEL_DEBUG, "Stalling queue (position: (%d, %d), queue: %d)\n", _this->x, _this->y, out_queue_id);
-                        _this->stalled_queues[out_queue_id] = true;
-                    }
+                    int dir = route->outputs[i];
+                    int out_queue = dir * _this->nb_vcs + _this->get_next_vc(in_dir, dir, vc);
+                    _this->output_waiters[out_queue] |= 1 << in_queue_index;
                 }
             }
-            _this->current_queue = in_queue_index + 1; // Always start looking from the queue after the one that has been processed last
-            if (_this->current_queue == 5)
-            {
-                _this->current_queue = 0;
-            }
+            continue; // Skip this request and isntead check another input queue
+        }
 
-            // Since we removed a request, check in next cycle if there is another one to handle
-            _this->fsm_event.enqueue();
+        output_full[out_dir] = true;
+        int out_queue_id = out_dir * _this->nb_vcs + out_vc;
+        int next_x = _this->neighbour_x[out_dir];
+        int next_y = _this->neighbour_y[out_dir];
+
+        _this->trace.msg(vp::Trace::LEVEL_DEBUG, "Resolved next position (req: %p, dest: (%d, %d), next_position: (%d, %d), vc: %d)\n",
+                         req, to_x, to_y, next_x, next_y, out_vc);
+
+        // Since we now know, that the request will be propagated, remove it from the queue
+        queue->pop();
+        _this->update_occupancy(in_dir, -1);
+        _this->out_flits[out_dir]++;
+        _this->out_flits_signals[out_dir]->set(_this->out_flits[out_dir]);
+
+        if (queue->size() == 0)
+        {
+            _this->pending_inputs &= ~(1 << in_queue_index);
         }
         else
         {
-            queue->trigger_next(); // This might actually not do anything because the queue is empty
+            // Since we removed a request, check in next cycle if there is another one to handle
+            check_next_cycle = true;
         }
 
-        // Go to next input queue
-        in_queue_index += 1;
-        if (in_queue_index == 5)
+        if (queue->size() == _this->queue_size) // Remember we let the source enqueue one more request than what is possible.
         {
-            in_queue_index = 0;
+            // In case the queue had one more element than possible, it means the output
+            // queue of the sending router is stalled. Unstall it now that we can accept
+            // one more request
+            _this->unstall_previous(req, in_queue_index);
+        }
+
+        // The request continues on the virtual channel of the output
+        *req->arg_get(FlooNoc::REQ_VC) = (void *)(long)out_vc;
+
+        // Now send to the next position
+        if (out_dir == FlooNoc::DIR_LOCAL)
+        {
+            // If next position is the same as the current one, it means it arrived to
+            // destination, we need to forward to the final target
+            _this->send_to_target_ni(req, _this->x, _this->y, out_queue_id);
+        }
+        else
+        {
+            // Otherwise forward to next position
+            Router *router = _this->neighbours[out_dir];
+
+            if (router == NULL)
+            {
+                // It is possible that we don't have any router at the destination if it is on
+                // the edge. In this case just forward it to the ni of the target
+                _this->send_to_target_ni(req, next_x, next_y, out_queue_id);
+            }
+            else
+            {
+                _this->trace.msg(vp::Trace::LEVEL_DEBUG, "Forwarding request to next router (req: %p, base: 0x%x, size: 0x%x, next_position: (%d, %d), in_queue: %d)\n",
+                                 req, req->get_addr(), req->get_size(), next_x, next_y, in_queue_index);
+                // Send the request to next router, and in case it reports that its input queue
+                // is full, stall the corresponding output queue to make sure we stop sending
+                // there until the queue is unstalled
+                if (router->handle_request(req, _this->x, _this->y))
+                {
+                    _this->trace.msg(vp::Trace::LEVEL_DEBUG, "Stalling queue (position: (%d, %d), queue: %d)\n", _this->x, _this->y, out_queue_id);
+                    _this->stall_output(out_queue_id);
+                }
+            }
+        }
+        _this->current_queue = in_queue_index + 1; // Always start looking from the queue after the one that has been processed last
+        if (_this->current_queue == nb_queues)
+        {
+            _this->current_queue = 0;
         }
     }
+
+    if (check_next_cycle)
+    {
+        _this->fsm_event.enqueue();
+    }
+}
+
+int Router::get_next_vc(int in_dir, int out_dir, int vc)
+{
+    if (!this->torus || out_dir == FlooNoc::DIR_LOCAL)
+    {
+        return vc;
+    }
+
+    // On a torus, virtual channels are split into a low and a high class. Requests enter each
+    // ring in the low class, and switch to the high class when they cross the wrap-around link,
+    // which breaks the cyclic dependency of the ring.
+    int half = this->nb_vcs / 2;
+    bool same_dimension = in_dir != FlooNoc::DIR_LOCAL && (in_dir >> 1) == (out_dir >> 1);
+    if (!same_dimension)
+    {
+        vc = vc % half;
+    }
+    if (this->wrap_outputs[out_dir] && vc < half)
+    {
+        vc += half;
+    }
+    return vc;
 }
 
 void Router::unstall_previous(vp::IoReq *req, int in_queue_index)
 {
-    int prev_pos_x, prev_pos_y;
-    // Get the previous position out of the input queue index
-    this->get_pos_from_queue(in_queue_index, prev_pos_x, prev_pos_y);
+    int in_dir = in_queue_index / this->nb_vcs;
 
-    if (prev_pos_x == this->x && prev_pos_y == this->y)
+    if (in_dir == FlooNoc::DIR_LOCAL)
     {
-        // If the queue corresponds to the local one (previous position is same as
-        // position), it means it was injected by a network interface
+        // If the queue corresponds to the local one, it means it was injected by a network
+        // interface
         NetworkInterface *ni = this->noc->get_network_interface(this->x, this->y);
         ni->unstall_queue(this->x, this->y);
     }
     else
     {
-        // Otherwise it comes from a router
-        Router *router = this->noc->get_router(prev_pos_x, prev_pos_y, req->get_int(FlooNoc::REQ_WIDE), req->get_is_write(), req->get_int(FlooNoc::REQ_IS_ADDRESS));
-        router->unstall_queue(this->x, this->y);
+        // Otherwise it comes from a router, whose output queue going to this router is in the
+        // opposite direction, on the same virtual channel
+        int vc = in_queue_index - in_dir * this->nb_vcs;
+        this->neighbours[in_dir]->unstall_output((in_dir ^ 1) * this->nb_vcs + vc);
     }
 }
 
 
-void Router::send_to_target_ni(vp::IoReq *req, int pos_x, int pos_y)
+void Router::build_routing_table(std::vector<Router *> &routers)
+{
+    int dim_x = this->noc->dim_x;
+    int dim_y = this->noc->dim_y;
+
+    // Neighbours are in the same network as this router, since a request always stays in the
+    // same network from the source to the destination
+    for (int i = 0; i < 5; i++)
+    {
+        this->get_pos_from_queue(i, this->neighbour_x[i], this->neighbour_y[i]);
+    }
+
+    for (int i = 0; i < 4; i++)
+    {
+        int pos_x = this->neighbour_x[i], pos_y = this->neighbour_y[i];
+        bool in_grid = pos_x >= 0 && pos_x < dim_x && pos_y >= 0 && pos_y < dim_y;
+        this->wrap_outputs[i] = false;
+
+        if (!in_grid && this->torus)
+        {
+            // On a torus, the edges are connected to the opposite ones
+            pos_x = (pos_x + dim_x) % dim_x;
+            pos_y = (pos_y + dim_y) % dim_y;
+            this->neighbour_x[i] = pos_x;
+            this->neighbour_y[i] = pos_y;
+            this->wrap_outputs[i] = true;
+            in_grid = true;
+        }
+
+        this->neighbours[i] = in_grid ? routers[pos_y * dim_x + pos_x] : NULL;
+    }
+
+    this->routes.resize(dim_x * dim_y);
+    for (int dest_y = 0; dest_y < dim_y; dest_y++)
+    {
+        for (int dest_x = 0; dest_x < dim_x; dest_x++)
+        {
+            RouteEntry *route = &this->routes[dest_y * dim_x + dest_x];
+            route->nb_outputs = this->noc->routing->get_outputs(this->x, this->y, dest_x, dest_y,
+                route->outputs);
+
+            // A request sent in a direction without router is delivered to the target at this
+            // position, so such a direction can only be taken when it is the destination.
+            // Drop it when the routing algorithm offers another direction.
+            if (route->nb_outputs > 1)
+            {
+                int nb_outputs = 0;
+                for (int i = 0; i < route->nb_outputs; i++)
+                {
+                    int dir = route->outputs[i];
+                    if (dir == FlooNoc::DIR_LOCAL || this->neighbours[dir] != NULL ||
+                        (this->neighbour_x[dir] == dest_x && this->neighbour_y[dir] == dest_y))
+                    {
+                        route->outputs[nb_outputs++] = dir;
+                    }
+                }
+                if (nb_outputs > 0)
+                {
+                    route->nb_outputs = nb_outputs;
+                }
+            }
+        }
+    }
+}
+
+
+void Router::send_to_target_ni(vp::IoReq *req, int pos_x, int pos_y, int out_queue)
 {
     this->trace.msg(vp::Trace::LEVEL_DEBUG, "Sending request to target NI (req: %p, position: (%d, %d))\n",
                     req, pos_x, pos_y);
     NetworkInterface *ni = this->noc->get_network_interface(pos_x, pos_y);
 
+    // Store the router in the request in case the target denies it. Since the grant is received
+    // by top noc, it will use this argument to notify the router about the grant.
+    // This must be done before sending the request, since the network interface releases it to
+    // its pool as soon as the target access is done, even if it then reports it as denied.
+    *(Router **)req->arg_get(FlooNoc::REQ_ROUTER) = this;
+    // Also store the queue, the router will use it to know which queue to unstall
+    *(int *)req->arg_get(FlooNoc::REQ_QUEUE) = out_queue;
+
     vp::IoReqStatus result = ni->req_from_router(req, pos_x, pos_y);
 
     if (result == vp::IO_REQ_DENIED)
     {
-        int queue = this->get_req_queue(pos_x, pos_y);
         this->trace.msg(vp::Trace::LEVEL_DEBUG, "Ni denied request, stalling queue\n");
 
         // In case it is denied, the request has been queued in the target, we just need to make
-        // sure we don't send any other request there until we reveive the grant callback
-        this->stalled_queues[queue] = true;
-
-        // Store the router in the request. Since the grant is received by top noc,
-        // it will use this argument to notify the router about the grant
-        *(Router **)req->arg_get(FlooNoc::REQ_ROUTER) = this;
-        // Also store the queue, the router will use it to know which queue to unstall
-        *(int *)req->arg_get(FlooNoc::REQ_QUEUE) = queue;
+        // sure we don't send any other request there until we reveive the grant callback.
+        // The request must not be accessed anymore, it may already be back in the pool.
+        this->stall_output(out_queue);
     }
 }
 
-// This is determining the routes the requests will take in the network
-void Router::get_next_router_pos(int dest_x, int dest_y, int &next_x, int &next_y)
+int64_t Router::reserve_burst_path(int to_x, int to_y, int64_t cycle, int64_t nb_flits)
 {
-    // TODO If there is a gap in the mesh of routers this algorithm doesnt work
-    if (dest_x == this->x && dest_y == this->y)
-    {
-        next_x = this->x;
-        next_y = this->y;
-    }
-    else if (dest_x == this->x)
-    {
-        next_x = this->x;
-        next_y = dest_y < this->y ? this->y - 1 : this->y + 1;
-    }
-    else
+    Router *router = this;
+
+    // The burst is modeled as a worm going through each router of the path. The head flit
+    // can leave an output only once the burst which previously reserved it fully went through,
+    // and then the output is busy for as many cycles as there are flits.
+    while (1)
     {
-        next_x = dest_x < this->x ? this->x - 1 : this->x + 1;
-        next_y = this->y;
+        RouteEntry *route = &router->routes[to_y * this->noc->dim_x + to_x];
+
+        // With adaptive routing, take the output which is free first
+        int out_dir = route->outputs[0];
+        for (int i = 1; i < route->nb_outputs; i++)
+        {
+            if (router->output_busy_until[route->outputs[i]] < router->output_busy_until[out_dir])
+            {
+                out_dir = route->outputs[i];
+            }
+        }
+
+        int64_t *busy_until = &router->output_busy_until[out_dir];
+        int64_t arrival = cycle + Router::ANALYTICAL_HOP_LATENCY;
+
+        cycle = std::max(arrival, *busy_until);
+        *busy_until = cycle + nb_flits;
+
+        // Account the link statistics as the flit-level mode does. The cycles the head flit
+        // waits for the output are accounted as stalls. Input queue occupancy is not modeled.
+        router->out_flits[out_dir] += nb_flits;
+        router->out_flits_signals[out_dir]->set(router->out_flits[out_dir]);
+        router->out_stalled_cycles[out_dir] += cycle - arrival;
+
+        router->trace.msg(vp::Trace::LEVEL_DEBUG, "Reserved output for burst (dest: (%d, %d), out queue: %d, start: %ld, flits: %ld)\n",
+            to_x, to_y, out_dir, cycle, nb_flits);
+
+        if (out_dir == FlooNoc::DIR_LOCAL || router->neighbours[out_dir] == NULL)
+        {
+            return cycle + nb_flits;
+        }
+
+        router = router->neighbours[out_dir];
     }
 }
 
@@ -276,20 +465,93 @@ void Router::grant(vp::IoReq *req)
     int queue = *(int *)req->arg_get(FlooNoc::REQ_QUEUE);
     this->trace.msg(vp::Trace::LEVEL_DEBUG, "Unstalling queue! (position: (%d, %d), queue: %d)\n",
                     *(int *)req->arg_get(FlooNoc::REQ_DEST_X), *(int *)req->arg_get(FlooNoc::REQ_DEST_Y), queue);
+    this->unstall_output(queue);
+}
+
+void Router::stall_output(int queue)
+{
+    if (!this->stalled_queues[queue])
+    {
+        this->stalled_queues[queue] = true;
+        this->stall_start[queue] = this->clock.get_cycles();
+    }
+}
+
+void Router::unstall_output(int queue)
+{
+    if (this->stalled_queues[queue])
+    {
+        this->out_stalled_cycles[queue / this->nb_vcs] += this->clock.get_cycles() - this->stall_start[queue];
+    }
     this->stalled_queues[queue] = false;
-    // And check in next cycle if another request can be sent
-    this->fsm_event.enqueue();
+
+    // Only wake-up the input queues which were waiting for this output, and only check in next
+    // cycle if one of them can now send its request
+    if (this->output_waiters[queue])
+    {
+        this->waiting_inputs &= ~this->output_waiters[queue];
+        this->output_waiters[queue] = 0;
+        this->fsm_event.enqueue();
+    }
 }
 
 void Router::unstall_queue(int from_x, int from_y)
 {
     // This gets called when an output queue gets unstalled because the denied request gets granted.
-    // Just unstall the queue and trigger the fsm, in case we can now send a new request
-    int queue = this->get_req_queue(from_x, from_y);
-    this->trace.msg(vp::Trace::LEVEL_TRACE, "Unstalling queue (position: (%d, %d), queue: %d)\n", from_x, from_y, queue);
-    this->stalled_queues[queue] = false;
-    // And check in next cycle if another request can be sent
-    this->fsm_event.enqueue();
+    // Just unstall the queues of all virtual channels and trigger the fsm, in case we can now
+    // send a new request
+    int dir = this->get_req_queue(from_x, from_y);
+    this->trace.msg(vp::Trace::LEVEL_TRACE, "Unstalling queue (position: (%d, %d), queue: %d)\n", from_x, from_y, dir);
+    for (int vc = 0; vc < this->nb_vcs; vc++)
+    {
+        this->unstall_output(dir * this->nb_vcs + vc);
+    }
+}
+
+void Router::update_occupancy(int dir, int incr)
+{
+    int64_t cycles = this->clock.get_cycles();
+    this->occupancy_integral[dir] += this->occupancy[dir] * (cycles - this->occupancy_cycle[dir]);
+    this->occupancy_cycle[dir] = cycles;
+    this->occupancy[dir] += incr;
+}
+
+void Router::dump_link_stats(FILE *file, bool json, bool &first)
+{
+    const char *dir_names[] = { "right", "left", "up", "down", "local" };
+    int64_t cycles = this->clock.get_cycles();
+
+    for (int dir = 0; dir < 5; dir++)
+    {
+        // Account the stalls and the occupancy up to now
+        uint64_t stalled_cycles = this->out_stalled_cycles[dir];
+        for (int vc = 0; vc < this->nb_vcs; vc++)
+        {
+            if (this->stalled_queues[dir * this->nb_vcs + vc])
+            {
+                stalled_cycles += cycles - this->stall_start[dir * this->nb_vcs + vc];
+            }
+        }
+        this->update_occupancy(dir, 0);
+
+        double utilisation = cycles ? (double)this->out_flits[dir] / cycles : 0;
+
+        if (json)
+        {
+            fprintf(file, "%s    {\"router\": \"%s\", \"x\": %d, \"y\": %d, \"output\": \"%s\", "
+                "\"flits\": %ld, \"stalled_cycles\": %ld, \"input_occupancy_integral\": %ld, "
+                "\"utilisation\": %f}",
+                first ? "" : ",\n", this->get_name().c_str(), this->x, this->y, dir_names[dir],
+                this->out_flits[dir], stalled_cycles, this->occupancy_integral[dir], utilisation);
+        }
+        else
+        {
+            fprintf(file, "%s,%d,%d,%s,%ld,%ld,%ld,%f\n", this->get_name().c_str(), this->x, this->y,
+                dir_names[dir], this->out_flits[dir], stalled_cycles,
+                this->occupancy_integral[dir], utilisation);
+        }
+        first = false;
+    }
 }
 
 void Router::get_pos_from_queue(int queue, int &pos_x, int &pos_y)
@@ -321,14 +583,31 @@ void Router::get_pos_from_queue(int queue, int &pos_x, int &pos_y)
 
 int Router::get_req_queue(int from_x, int from_y)
 {
+    int diff_x = from_x - this->x;
+    int diff_y = from_y - this->y;
+
+    // On a torus, a neighbour further than one hop is reached through the wrap-around link, and
+    // is then on the other side
+    if (this->torus)
+    {
+        if (diff_x > 1 || diff_x < -1)
+        {
+            diff_x = -diff_x;
+        }
+        if (diff_y > 1 || diff_y < -1)
+        {
+            diff_y = -diff_y;
+        }
+    }
+
     int queue_index = 0;
-    if (from_x != this->x)
+    if (diff_x != 0)
     {
-        queue_index = from_x < this->x ? FlooNoc::DIR_LEFT : FlooNoc::DIR_RIGHT;
+        queue_index = diff_x < 0 ? FlooNoc::DIR_LEFT : FlooNoc::DIR_RIGHT;
     }
-    else if (from_y != this->y)
+    else if (diff_y != 0)
     {
-        queue_index = from_y < this->y ? FlooNoc::DIR_DOWN : FlooNoc::DIR_UP;
+        queue_index = diff_y < 0 ? FlooNoc::DIR_DOWN : FlooNoc::DIR_UP;
     }
     else
     {
@@ -343,9 +622,21 @@ void Router::reset(bool active)
     if (active)
     {
         this->current_queue = 0;
-        for (int i = 0; i < 5; i++)
+        this->pending_inputs = 0;
+        this->waiting_inputs = 0;
+        for (int i = 0; i < this->nb_queues; i++)
         {
             this->stalled_queues[i] = false;
+            this->output_waiters[i] = 0;
+        }
+        for (int i = 0; i < 5; i++)
+        {
+            this->output_busy_until[i] = 0;
+            this->out_flits[i] = 0;
+            this->out_stalled_cycles[i] = 0;
+            this->occupancy[i] = 0;
+            this->occupancy_integral[i] = 0;
+            this->occupancy_cycle[i] = 0;
         }
     }
 
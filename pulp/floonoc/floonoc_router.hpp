@@ -23,6 +23,7 @@
 #pragma once
 
 #include <vp/vp.hpp>
+#include <vp/signal.hpp>
 
 class FlooNoc;
 
@@ -31,6 +32,9 @@ class FlooNoc;
  *
  * Router are the nodes of the noc which are moving internal requests from the network interface
  * to the target.
+ * Each direction can be split into several virtual channels. Each virtual channel has its own
+ * input queue and is stalled independently, while the physical link of a direction can still
+ * only forward one request per cycle.
  */
 class Router : public vp::Block
 {
@@ -41,27 +45,71 @@ public:
 
     // This gets called by other routers or a network interface to move a request to this router
     bool handle_request(vp::IoReq *req, int from_x, int from_y);
-    // Called by other routers to unstall an output queue after an input queue became available
+    // Called by a network interface to unstall the output queues of all virtual channels going
+    // to it after it can accept requests again
     void unstall_queue(int from_x, int from_y);
+    // Unstalls an output queue and wakes up the input queues which were waiting for it. The queue
+    // index includes the virtual channel.
+    void unstall_output(int queue);
     // This gets called by the top noc to grant a a request denied by a target
     void grant(vp::IoReq *req);
+    // Called by the top noc once all routers are instantiated to precompute the routing decision
+    // for every destination. The array contains all routers of the same network, indexed by
+    // position.
+    void build_routing_table(std::vector<Router *> &routers);
+    // Used in analytical burst mode to reserve the output of this router and of all the next
+    // ones until the destination is reached, for a burst of nb_flits flits entering this router
+    // at the specified cycle. Returns the cycle at which the last flit leaves the path.
+    int64_t reserve_burst_path(int to_x, int to_y, int64_t cycle, int64_t nb_flits);
+    // Dump the link statistics of each output of this router, either as CSV lines or as JSON
+    // objects. first is true if nothing has been dumped yet, which is needed to separate JSON
+    // objects, and is updated accordingly.
+    void dump_link_stats(FILE *file, bool json, bool &first);
+
+    // Number of cycles taken by a flit to go through a router in analytical burst mode. This
+    // corresponds to the delay of the input queue plus the one of the FSM.
+    static constexpr int64_t ANALYTICAL_HOP_LATENCY = 2;
+    // Maximum number of virtual channels per direction. All input queues must fit in a 32 bits
+    // mask.
+    static constexpr int MAX_VCS = 4;
 
 private:
     // FSM event handler called when something happened and queues need to be checked to see
     // if a request should be handled.
     static void fsm_handler(vp::Block *__this, vp::ClockEvent *event);
-    // Called when a request has reached its destination position and should be sent to a target
-    void send_to_target_ni(vp::IoReq *req, int pos_x, int pos_y);
-    // Get the position of the next router which should handle a request.
-    void get_next_router_pos(int dest_x, int dest_y, int &next_x, int &next_y);
-    // Get the index of the queue corresponding to a source or destination position
+    // Called when a request has reached its destination position and should be sent to a target.
+    // The output queue is the one which is stalled if the target denies the request.
+    void send_to_target_ni(vp::IoReq *req, int pos_x, int pos_y, int out_queue);
+    // Get the direction corresponding to a source or destination position
     int get_req_queue(int from_x, int from_y);
     // Return the source or destination position which corresponds to a source or destination
-    // queue index
+    // direction
     void get_pos_from_queue(int queue, int &pos_x, int &pos_y);
+    // Return the virtual channel a request must use on the next hop, when going from an input
+    // direction to an output direction.
+    int get_next_vc(int in_dir, int out_dir, int vc);
 
     // Unstalls the router or network interface corresponding to the in_queue_index
     void unstall_previous(vp::IoReq *req, int in_queue_index);
+    // Stalls an output queue until it is unstalled, and starts accounting stalled cycles
+    void stall_output(int queue);
+    // Account the occupancy of the input queues of a direction until now, and then modify it
+    void update_occupancy(int dir, int incr);
+
+    /**
+     * @brief Routing table entry
+     *
+     * Gives for one destination the output directions which can be taken, by order of
+     * preference, so that the routing decision is a simple table lookup when a request is
+     * propagated. Deterministic algorithms only give one direction.
+     */
+    struct RouteEntry
+    {
+        // Number of possible output directions
+        int nb_outputs;
+        // Possible output directions
+        int outputs[2];
+    };
 
     // Pointer to top
     FlooNoc *noc;
@@ -74,8 +122,13 @@ private:
     // Size of the input queues. This limits the number of requests from the same source which can
     // be pending
     int queue_size;
+    // Number of virtual channels per direction
+    int nb_vcs;
+    // Total number of queues, which is the number of directions multiplied by the number of
+    // virtual channels. Queues are indexed by direction * nb_vcs + virtual channel.
+    int nb_queues;
     // The input queues for each direction and the local one
-    vp::Queue *input_queues[5];
+    std::vector<vp::Queue *> input_queues;
     // Clock event used to schedule FSM handler. This is scheduled eveytime something may need to
     // be done
     vp::ClockEvent fsm_event;
@@ -83,5 +136,47 @@ private:
     int current_queue;
     // State of the output queues, true if it is stalled and nothing can be sent to it anymore
     // until it is unstalled.
-    bool stalled_queues[5];
+    bool stalled_queues[5 * Router::MAX_VCS];
+    // Bitmask of the input queues which contain at least one request, ready or not
+    uint32_t pending_inputs;
+    // Bitmask of the input queues whose head request is waiting for a stalled output. They are
+    // not checked until the output is unstalled.
+    uint32_t waiting_inputs;
+    // For each output queue, bitmask of the input queues waiting for it to be unstalled
+    uint32_t output_waiters[5 * Router::MAX_VCS];
+    // Mask with one bit set for each of the input queues
+    uint32_t all_queues_mask;
+    // Routing table, giving the route to each destination, indexed by destination position
+    std::vector<RouteEntry> routes;
+    // Neighbour routers in the same network for each direction, or NULL if there is none
+    Router *neighbours[4];
+    // Position of the next hop for each direction, including the local one
+    int neighbour_x[5];
+    int neighbour_y[5];
+    // True for the directions going through a wrap-around link of a torus
+    bool wrap_outputs[4];
+    // True if the topology is a torus, in which case virtual channels are split in 2 classes
+    // to break the cyclic dependencies of the rings
+    bool torus;
+    // Used in analytical burst mode to give for each output the cycle from which it is free
+    // again, once all the flits of the bursts which reserved it went through.
+    int64_t output_busy_until[5];
+
+    // Link statistics. They are always collected since they are cheap, and can be dumped at the
+    // end of the simulation to build link utilisation heatmaps.
+    // Number of flits forwarded on each output
+    uint64_t out_flits[5];
+    // Same, as signals so that they can be seen in VCD traces
+    vp::Signal<uint64_t> *out_flits_signals[5];
+    // Number of cycles each output has been stalled, cumulated over virtual channels
+    uint64_t out_stalled_cycles[5];
+    // Cycle at which each output queue was stalled
+    int64_t stall_start[5 * Router::MAX_VCS];
+    // Current number of requests in the input queues of each direction
+    int64_t occupancy[5];
+    // Integral over time of the number of requests in the input queues of each direction. Dividing
+    // it by the number of cycles gives the average occupancy.
+    int64_t occupancy_integral[5];
+    // Cycle at which the occupancy integral was last updated
+    int64_t occupancy_cycle[5];
 };
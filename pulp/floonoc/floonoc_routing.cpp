@@ -0,0 +1,139 @@
+/*
+ * Copyright (C) 2020 GreenWaves Technologies, SAS, ETH Zurich and
+ *                    University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Authors: Germain Haugou, ETH (germain.haugou@iis.ee.ethz.ch)
+ *          Jonas Martin, ETH (martinjo@student.ethz.ch)
+ */
+
+#include <vp/vp.hpp>
+#include <vp/itf/io.hpp>
+#include "floonoc.hpp"
+#include "floonoc_routing.hpp"
+
+
+RoutingAlgorithm::RoutingAlgorithm(int dim_x, int dim_y)
+{
+    this->dim_x = dim_x;
+    this->dim_y = dim_y;
+}
+
+
+RoutingAlgorithm *RoutingAlgorithm::create(std::string name, int dim_x, int dim_y)
+{
+    if (name == "xy")
+    {
+        return new RoutingXY(dim_x, dim_y);
+    }
+    else if (name == "yx")
+    {
+        return new RoutingYX(dim_x, dim_y);
+    }
+    else if (name == "west_first")
+    {
+        return new RoutingWestFirst(dim_x, dim_y);
+    }
+    else if (name == "torus_xy")
+    {
+        return new RoutingTorusXY(dim_x, dim_y);
+    }
+    return NULL;
+}
+
+
+int RoutingXY::get_outputs(int x, int y, int dest_x, int dest_y, int outputs[2])
+{
+    // TODO If there is a gap in the mesh of routers this algorithm doesnt work
+    if (dest_x != x)
+    {
+        outputs[0] = dest_x < x ? FlooNoc::DIR_LEFT : FlooNoc::DIR_RIGHT;
+    }
+    else if (dest_y != y)
+    {
+        outputs[0] = dest_y < y ? FlooNoc::DIR_DOWN : FlooNoc::DIR_UP;
+    }
+    else
+    {
+        outputs[0] = FlooNoc::DIR_LOCAL;
+    }
+    return 1;
+}
+
+
+int RoutingYX::get_outputs(int x, int y, int dest_x, int dest_y, int outputs[2])
+{
+    if (dest_y != y)
+    {
+        outputs[0] = dest_y < y ? FlooNoc::DIR_DOWN : FlooNoc::DIR_UP;
+    }
+    else if (dest_x != x)
+    {
+        outputs[0] = dest_x < x ? FlooNoc::DIR_LEFT : FlooNoc::DIR_RIGHT;
+    }
+    else
+    {
+        outputs[0] = FlooNoc::DIR_LOCAL;
+    }
+    return 1;
+}
+
+
+int RoutingWestFirst::get_outputs(int x, int y, int dest_x, int dest_y, int outputs[2])
+{
+    // Going west must be done first and is then the only possibility
+    if (dest_x < x)
+    {
+        outputs[0] = FlooNoc::DIR_LEFT;
+        return 1;
+    }
+
+    int nb_outputs = 0;
+    if (dest_x > x)
+    {
+        outputs[nb_outputs++] = FlooNoc::DIR_RIGHT;
+    }
+    if (dest_y != y)
+    {
+        outputs[nb_outputs++] = dest_y < y ? FlooNoc::DIR_DOWN : FlooNoc::DIR_UP;
+    }
+    if (nb_outputs == 0)
+    {
+        outputs[nb_outputs++] = FlooNoc::DIR_LOCAL;
+    }
+    return nb_outputs;
+}
+
+
+int RoutingTorusXY::get_outputs(int x, int y, int dest_x, int dest_y, int outputs[2])
+{
+    // In each dimension, go in the direction giving the shortest path around the ring
+    if (dest_x != x)
+    {
+        int forward = dest_x > x ? dest_x - x : dest_x + this->dim_x - x;
+        outputs[0] = forward <= this->dim_x - forward ? FlooNoc::DIR_RIGHT : FlooNoc::DIR_LEFT;
+    }
+    else if (dest_y != y)
+    {
+        int forward = dest_y > y ? dest_y - y : dest_y + this->dim_y - y;
+        outputs[0] = forward <= this->dim_y - forward ? FlooNoc::DIR_UP : FlooNoc::DIR_DOWN;
+    }
+    else
+    {
+        outputs[0] = FlooNoc::DIR_LOCAL;
+    }
+    return 1;
+}
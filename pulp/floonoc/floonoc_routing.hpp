@@ -0,0 +1,114 @@
+/*
+ * Copyright (C) 2020 GreenWaves Technologies, SAS, ETH Zurich and
+ *                    University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Authors: Germain Haugou, ETH (germain.haugou@iis.ee.ethz.ch)
+ *          Jonas Martin, ETH (martinjo@student.ethz.ch)
+ */
+
+#pragma once
+
+#include <string>
+
+/**
+ * @brief FlooNoc routing algorithm
+ *
+ * A routing algorithm decides which output directions a request can take at a given position to
+ * reach its destination. Routers only use it when they build their routing table, so that the
+ * routing decision is a table lookup when requests are propagated.
+ * Adaptive algorithms can return several directions, by order of preference. The router will
+ * then take the first one which is not stalled.
+ */
+class RoutingAlgorithm
+{
+public:
+    RoutingAlgorithm(int dim_x, int dim_y);
+    virtual ~RoutingAlgorithm() {}
+
+    // Fill the directions which can be taken at position (x, y) to go to position
+    // (dest_x, dest_y), by order of preference, and return the number of directions.
+    // FlooNoc::DIR_LOCAL must be returned once the destination is reached.
+    virtual int get_outputs(int x, int y, int dest_x, int dest_y, int outputs[2]) = 0;
+    // Return true if the topology has wrap-around links from one edge to the opposite one.
+    virtual bool is_torus() { return false; }
+
+    // Instantiate the algorithm from its name, as given by the generator. Returns NULL if the
+    // name is unknown.
+    static RoutingAlgorithm *create(std::string name, int dim_x, int dim_y);
+
+    // Maximum number of directions returned by get_outputs
+    static constexpr int MAX_OUTPUTS = 2;
+
+protected:
+    // X dimension of the network
+    int dim_x;
+    // Y dimension of the network
+    int dim_y;
+};
+
+
+/**
+ * @brief Dimension-ordered routing, X first then Y
+ */
+class RoutingXY : public RoutingAlgorithm
+{
+public:
+    RoutingXY(int dim_x, int dim_y) : RoutingAlgorithm(dim_x, dim_y) {}
+    int get_outputs(int x, int y, int dest_x, int dest_y, int outputs[2]) override;
+};
+
+
+/**
+ * @brief Dimension-ordered routing, Y first then X
+ */
+class RoutingYX : public RoutingAlgorithm
+{
+public:
+    RoutingYX(int dim_x, int dim_y) : RoutingAlgorithm(dim_x, dim_y) {}
+    int get_outputs(int x, int y, int dest_x, int dest_y, int outputs[2]) override;
+};
+
+
+/**
+ * @brief West-first adaptive routing
+ *
+ * Requests going west are routed west first. Otherwise any productive direction among east,
+ * north and south can be taken, which makes it possible to go around stalled routers without
+ * creating deadlocks.
+ */
+class RoutingWestFirst : public RoutingAlgorithm
+{
+public:
+    RoutingWestFirst(int dim_x, int dim_y) : RoutingAlgorithm(dim_x, dim_y) {}
+    int get_outputs(int x, int y, int dest_x, int dest_y, int outputs[2]) override;
+};
+
+
+/**
+ * @brief Dimension-ordered routing on a torus
+ *
+ * Same as XY routing, but each dimension is a ring and the shortest way around it is taken.
+ * This requires a router at every node of the grid, and at least 2 virtual channels to break
+ * the cyclic dependencies of the rings.
+ */
+class RoutingTorusXY : public RoutingAlgorithm
+{
+public:
+    RoutingTorusXY(int dim_x, int dim_y) : RoutingAlgorithm(dim_x, dim_y) {}
+    int get_outputs(int x, int y, int dest_x, int dest_y, int outputs[2]) override;
+    bool is_torus() override { return true; }
+};
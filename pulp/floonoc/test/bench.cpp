@@ -0,0 +1,371 @@
+/*
+ * Copyright (C) 2020 GreenWaves Technologies, SAS, ETH Zurich and
+ *                    University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <vp/vp.hpp>
+#include <vp/itf/io.hpp>
+#include "../floonoc.hpp"
+#include "bench.hpp"
+
+// Maximum number of bursts each source can have in flight
+#define BENCH_MAX_OUTSTANDING 64
+
+
+Bench::Bench(vp::ComponentConf &config)
+    : vp::Component(config), fsm_event(this, &Bench::fsm_handler)
+{
+    this->traces.new_trace("trace", &this->trace, vp::DEBUG);
+
+    this->nb_cluster_x = this->get_js_config()->get_int("nb_cluster_x");
+    this->nb_cluster_y = this->get_js_config()->get_int("nb_cluster_y");
+    this->cluster_base = this->get_js_config()->get_uint("cluster_base");
+    this->cluster_size = this->get_js_config()->get_uint("cluster_size");
+    this->pattern = this->get_js_config()->get_child_str("pattern");
+    this->injection_rate = this->get_js_config()->get("injection_rate")->get_double();
+    this->burst_size = this->get_js_config()->get_uint("burst_size");
+    this->nb_bursts = this->get_js_config()->get_int("nb_bursts");
+    this->receiver_bw = this->get_js_config()->get_int("receiver_bw");
+    this->hotspot_ratio = this->get_js_config()->get_int("hotspot_ratio");
+
+    if (this->burst_size == 0 || this->burst_size > this->cluster_size)
+    {
+        this->trace.fatal("Invalid burst size (burst_size: 0x%lx, cluster_size: 0x%lx)\n",
+            this->burst_size, this->cluster_size);
+    }
+
+    // Sources inject one burst every period to respect the injection rate
+    this->injection_period = std::max((int64_t)1, (int64_t)(this->burst_size / this->injection_rate));
+
+    int nb_cluster = this->nb_cluster_x * this->nb_cluster_y;
+
+    this->receiver_control_itf.resize(nb_cluster);
+    this->sources.resize(nb_cluster);
+    this->data.resize(this->burst_size);
+
+    for (int x=0; x<this->nb_cluster_x; x++)
+    {
+        for (int y=0; y<this->nb_cluster_y; y++)
+        {
+            int cid = y*this->nb_cluster_x + x;
+            BenchSource *source = &this->sources[cid];
+
+            this->new_master_port(
+                "receiver_control_" + std::to_string(x) + "_" + std::to_string(y),
+                &this->receiver_control_itf[cid]);
+
+            source->x = x;
+            source->y = y;
+            source->itf.set_resp_meth(&Bench::response);
+            source->itf.set_grant_meth(&Bench::grant);
+            this->new_master_port(
+                "noc_ni_" + std::to_string(x) + "_" + std::to_string(y), &source->itf);
+
+            for (int i=0; i<BENCH_MAX_OUTSTANDING; i++)
+            {
+                BenchReq *req = new BenchReq();
+                req->source = source;
+                source->free_reqs.push_back(req);
+            }
+        }
+    }
+}
+
+
+void Bench::reset(bool active)
+{
+    if (!active)
+    {
+        this->random_state = 0x12345678;
+        this->latencies.clear();
+        this->latencies.reserve(this->nb_bursts * this->sources.size());
+        this->nb_active_sources = 0;
+
+        for (BenchSource &source: this->sources)
+        {
+            source.next_cycle = 0;
+            source.nb_injected = 0;
+            source.nb_done = 0;
+            source.denied_req = NULL;
+
+            if (!this->is_idle(&source))
+            {
+                this->nb_active_sources++;
+            }
+            else
+            {
+                // With this pattern, this source does not send anything
+                source.nb_injected = this->nb_bursts;
+                source.nb_done = this->nb_bursts;
+            }
+        }
+
+        this->receivers_started = false;
+
+        this->start_cycle = this->clock.get_cycles();
+        this->start_time = std::chrono::steady_clock::now();
+        this->fsm_event.enqueue();
+    }
+}
+
+
+uint32_t Bench::random()
+{
+    // Xorshift generator
+    uint32_t x = this->random_state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    this->random_state = x;
+    return x;
+}
+
+
+bool Bench::get_destination(BenchSource *source, int &dest_x, int &dest_y)
+{
+    int nx = this->nb_cluster_x, ny = this->nb_cluster_y;
+
+    if (this->pattern == "uniform" || this->pattern == "hotspot")
+    {
+        if (this->pattern == "hotspot" && (int)(this->random() % 100) < this->hotspot_ratio)
+        {
+            // The hotspot is the cluster in the middle of the grid
+            dest_x = nx / 2;
+            dest_y = ny / 2;
+        }
+        else
+        {
+            // Any other cluster, with the same probability
+            int nb_cluster = nx * ny;
+            int self = source->y * nx + source->x;
+            if (nb_cluster == 1)
+            {
+                return false;
+            }
+            int dest = this->random() % (nb_cluster - 1);
+            if (dest >= self)
+            {
+                dest++;
+            }
+            dest_x = dest % nx;
+            dest_y = dest / nx;
+        }
+    }
+    else if (this->pattern == "transpose")
+    {
+        dest_x = source->y % nx;
+        dest_y = source->x % ny;
+    }
+    else if (this->pattern == "bit_complement")
+    {
+        dest_x = nx - 1 - source->x;
+        dest_y = ny - 1 - source->y;
+    }
+    else if (this->pattern == "all_to_one")
+    {
+        dest_x = 0;
+        dest_y = 0;
+    }
+    else
+    {
+        this->trace.fatal("Unknown traffic pattern (name: %s)\n", this->pattern.c_str());
+        return false;
+    }
+
+    // Sources whose destination is themselves stay idle
+    return dest_x != source->x || dest_y != source->y;
+}
+
+
+bool Bench::is_idle(BenchSource *source)
+{
+    // Random patterns can always pick another cluster, unless there is only one. This must
+    // not draw random numbers, otherwise a source could be idle just because it drew itself.
+    if (this->pattern == "uniform" || this->pattern == "hotspot")
+    {
+        return this->sources.size() == 1;
+    }
+
+    // Fixed patterns are idle for the sources sending to themselves
+    int dest_x, dest_y;
+    return !this->get_destination(source, dest_x, dest_y);
+}
+
+
+bool Bench::inject(BenchSource *source)
+{
+    if (source->nb_injected == this->nb_bursts || source->denied_req != NULL ||
+        source->free_reqs.empty() || source->next_cycle > this->clock.get_cycles())
+    {
+        return false;
+    }
+
+    int dest_x, dest_y;
+    this->get_destination(source, dest_x, dest_y);
+    if (dest_x == source->x && dest_y == source->y)
+    {
+        // Random patterns may return the source itself, skip this slot
+        source->next_cycle += this->injection_period;
+        return false;
+    }
+
+    BenchReq *req = source->free_reqs.back();
+    source->free_reqs.pop_back();
+
+    // Bursts go to a random burst-aligned offset of the destination cluster, the burst must fit
+    // in the cluster
+    uint64_t nb_offsets = (this->cluster_size - this->burst_size) / this->burst_size + 1;
+    uint64_t offset = ((uint64_t)this->random() % nb_offsets) * this->burst_size;
+    uint64_t base = this->cluster_base + this->cluster_size * (dest_y * this->nb_cluster_x + dest_x);
+
+    req->init();
+    req->arg_alloc(FlooNoc::REQ_NB_ARGS + 1);
+    req->set_addr(base + offset);
+    req->set_size(this->burst_size);
+    req->set_data(this->data.data());
+    req->set_is_write(true);
+    req->issue_cycle = this->clock.get_cycles();
+
+    source->nb_injected++;
+    source->next_cycle += this->injection_period;
+
+    this->trace.msg(vp::Trace::LEVEL_DEBUG, "Injecting burst (source: (%d, %d), destination: (%d, %d), addr: 0x%lx, size: 0x%lx)\n",
+        source->x, source->y, dest_x, dest_y, req->get_addr(), req->get_size());
+
+    vp::IoReqStatus status = source->itf.req(req);
+    if (status == vp::IO_REQ_OK || status == vp::IO_REQ_INVALID)
+    {
+        this->handle_burst_end(req);
+    }
+    else if (status == vp::IO_REQ_DENIED)
+    {
+        source->denied_req = req;
+    }
+
+    return true;
+}
+
+
+void Bench::handle_burst_end(BenchReq *req)
+{
+    BenchSource *source = req->source;
+    int64_t latency = this->clock.get_cycles() + req->get_latency() - req->issue_cycle;
+
+    this->latencies.push_back(latency);
+    source->free_reqs.push_back(req);
+    source->nb_done++;
+
+    if (source->nb_done == this->nb_bursts)
+    {
+        this->nb_active_sources--;
+        if (this->nb_active_sources == 0)
+        {
+            this->report();
+        }
+    }
+}
+
+
+void Bench::fsm_handler(vp::Block *__this, vp::ClockEvent *event)
+{
+    Bench *_this = (Bench *)__this;
+    bool pending = false;
+
+    if (!_this->receivers_started)
+    {
+        // Receivers are started from the first cycle, once all components have been reset
+        _this->receivers_started = true;
+        for (TrafficReceiverConfigMaster &itf: _this->receiver_control_itf)
+        {
+            itf.start(_this->receiver_bw);
+        }
+    }
+
+    for (BenchSource &source: _this->sources)
+    {
+        _this->inject(&source);
+        pending |= source.nb_injected != _this->nb_bursts;
+    }
+
+    if (pending)
+    {
+        _this->fsm_event.enqueue();
+    }
+}
+
+
+void Bench::response(vp::Block *__this, vp::IoReq *req)
+{
+    Bench *_this = (Bench *)__this;
+    _this->handle_burst_end((BenchReq *)req);
+    if (!_this->fsm_event.is_enqueued())
+    {
+        _this->fsm_event.enqueue();
+    }
+}
+
+
+void Bench::grant(vp::Block *__this, vp::IoReq *req)
+{
+    Bench *_this = (Bench *)__this;
+    BenchSource *source = ((BenchReq *)req)->source;
+    source->denied_req = NULL;
+    if (!_this->fsm_event.is_enqueued())
+    {
+        _this->fsm_event.enqueue();
+    }
+}
+
+
+void Bench::report()
+{
+    int64_t cycles = this->clock.get_cycles() - this->start_cycle;
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - this->start_time).count();
+
+    int nb_sources = 0;
+    for (BenchSource &source: this->sources)
+    {
+        if (source.nb_injected != 0 && source.free_reqs.size() == BENCH_MAX_OUTSTANDING)
+        {
+            nb_sources++;
+        }
+    }
+
+    std::sort(this->latencies.begin(), this->latencies.end());
+    int nb = this->latencies.size();
+    auto percentile = [&](int p) { return nb ? this->latencies[std::min(nb - 1, (nb * p) / 100)] : 0; };
+
+    uint64_t bytes = (uint64_t)nb * this->burst_size;
+    double throughput = cycles ? (double)bytes / cycles : 0;
+    double throughput_per_source = nb_sources ? throughput / nb_sources : 0;
+
+    // Single line which is parsed by the sweep script
+    printf("BENCH grid=%dx%d pattern=%s rate=%f burst=%ld bursts=%d cycles=%ld "
+        "throughput=%f throughput_per_source=%f lat_p50=%ld lat_p90=%ld lat_p99=%ld lat_max=%ld "
+        "host_seconds=%f cycles_per_second=%f\n",
+        this->nb_cluster_x, this->nb_cluster_y, this->pattern.c_str(), this->injection_rate,
+        this->burst_size, nb, cycles, throughput, throughput_per_source,
+        percentile(50), percentile(90), percentile(99), nb ? this->latencies[nb - 1] : 0,
+        seconds, seconds > 0 ? cycles / seconds : 0);
+
+    this->time.get_engine()->quit(0);
+}
+
+
+extern "C" vp::Component *gv_new(vp::ComponentConf &config)
+{
+    return new Bench(config);
+}
@@ -0,0 +1,142 @@
+/*
+ * Copyright (C) 2020 GreenWaves Technologies, SAS, ETH Zurich and
+ *                    University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <vp/vp.hpp>
+#include <vp/itf/io.hpp>
+#include "interco/traffic/receiver.hpp"
+
+class Bench;
+class BenchSource;
+
+/**
+ * @brief Burst injected by the benchmark
+ *
+ * This extends the IO request with the information needed to account the burst when its
+ * response is received.
+ */
+class BenchReq : public vp::IoReq
+{
+public:
+    // Source which injected the burst
+    BenchSource *source;
+    // Cycle at which the burst was injected
+    int64_t issue_cycle;
+};
+
+/**
+ * @brief Traffic source of the benchmark
+ *
+ * There is one source per cluster position. Each source injects bursts directly into the
+ * network interface of its cluster, at the configured injection rate, to the destination given
+ * by the traffic pattern, and records the latency of each burst.
+ */
+class BenchSource
+{
+public:
+    // Input IO interface where the network interface sends back the burst responses
+    vp::IoMaster itf;
+    // Position of the source
+    int x;
+    int y;
+    // Cycle at which the next burst can be injected, which gives the injection rate
+    int64_t next_cycle;
+    // Number of bursts already injected
+    int nb_injected;
+    // Number of bursts for which the response has been received
+    int nb_done;
+    // Burst denied by the network interface, which must be granted before injecting another one
+    vp::IoReq *denied_req;
+    // Free bursts which can be injected
+    std::vector<BenchReq *> free_reqs;
+};
+
+
+/**
+ * @brief FlooNoc benchmark
+ *
+ * This injects synthetic traffic into a grid of clusters, following a traffic pattern, and
+ * reports accepted throughput, burst latency percentiles and host simulation speed once all
+ * bursts have been received.
+ */
+class Bench : public vp::Component
+{
+public:
+    Bench(vp::ComponentConf &config);
+
+    void reset(bool active);
+
+private:
+    static void fsm_handler(vp::Block *__this, vp::ClockEvent *event);
+    static void response(vp::Block *__this, vp::IoReq *req);
+    static void grant(vp::Block *__this, vp::IoReq *req);
+    // Try to inject the next burst of a source, returns true if it was injected
+    bool inject(BenchSource *source);
+    // Account the end of a burst
+    void handle_burst_end(BenchReq *req);
+    // Get the destination of the next burst of a source. Returns false if the destination is
+    // the source itself.
+    bool get_destination(BenchSource *source, int &dest_x, int &dest_y);
+    // Returns true if the source never injects anything with the current pattern
+    bool is_idle(BenchSource *source);
+    // Pseudo-random number generator, deterministic to get reproducible results
+    uint32_t random();
+    // Dump the results and quit the simulation
+    void report();
+
+    vp::Trace trace;
+    // Clock event scheduled every cycle while bursts have to be injected
+    vp::ClockEvent fsm_event;
+    // Control interfaces of the receivers, used to set their bandwidth
+    std::vector<TrafficReceiverConfigMaster> receiver_control_itf;
+    // True once the receivers have been configured
+    bool receivers_started;
+    // Traffic sources, one per cluster
+    std::vector<BenchSource> sources;
+    int nb_cluster_x;
+    int nb_cluster_y;
+    uint64_t cluster_base;
+    uint64_t cluster_size;
+    // Name of the traffic pattern
+    std::string pattern;
+    // Injection rate of each source in bytes per cycle
+    double injection_rate;
+    // Size of each burst
+    uint64_t burst_size;
+    // Number of bursts injected by each source
+    int nb_bursts;
+    // Bandwidth of the receivers in bytes per cycle
+    int receiver_bw;
+    // Proportion of the bursts going to the hotspot with the hotspot pattern, in percent
+    int hotspot_ratio;
+    // Number of cycles between 2 bursts of the same source, from the injection rate
+    int64_t injection_period;
+    // Latency of each burst
+    std::vector<int64_t> latencies;
+    // Number of sources which have not yet received all their responses
+    int nb_active_sources;
+    // Cycle at which the benchmark started
+    int64_t start_cycle;
+    // Host time at which the benchmark started
+    std::chrono::steady_clock::time_point start_time;
+    // Data buffer used by all bursts, since the content is not checked
+    std::vector<uint8_t> data;
+    // State of the pseudo-random number generator
+    uint32_t random_state;
+};
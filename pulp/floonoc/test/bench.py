@@ -0,0 +1,132 @@
+#
+# Copyright (C) 2020 GreenWaves Technologies, SAS, ETH Zurich and University of Bologna
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+
+import gvsoc.systree
+import gvsoc.runner
+
+import vp.clock_domain
+import pulp.floonoc.floonoc
+import interco.traffic.receiver
+
+
+GAPY_TARGET = True
+
+class FloonocBench(gvsoc.systree.Component):
+
+    def __init__(self, parent, name, nb_cluster_x, nb_cluster_y, cluster_base, cluster_size,
+            pattern, injection_rate, burst_size, nb_bursts, receiver_bw, hotspot_ratio):
+        super().__init__(parent, name)
+
+        if burst_size <= 0 or burst_size & (burst_size - 1) != 0:
+            raise RuntimeError(f'Burst size must be a power of 2 (burst_size: {burst_size})')
+        if burst_size > cluster_size:
+            raise RuntimeError(f'Burst size must not exceed the cluster size (burst_size: {burst_size}, cluster_size: {cluster_size})')
+
+        self.add_property('nb_cluster_x', nb_cluster_x)
+        self.add_property('nb_cluster_y', nb_cluster_y)
+        self.add_property('cluster_base', cluster_base)
+        self.add_property('cluster_size', cluster_size)
+        self.add_property('pattern', pattern)
+        self.add_property('injection_rate', injection_rate)
+        self.add_property('burst_size', burst_size)
+        self.add_property('nb_bursts', nb_bursts)
+        self.add_property('receiver_bw', receiver_bw)
+        self.add_property('hotspot_ratio', hotspot_ratio)
+
+        self.add_sources(['bench.cpp'])
+
+    def o_NOC_NI(self, x, y, itf: gvsoc.systree.SlaveItf):
+        self.itf_bind(f'noc_ni_{x}_{y}', itf, signature='io')
+
+    def o_RECEIVER_CONTROL(self, x, y, itf: gvsoc.systree.SlaveItf):
+        self.itf_bind(f'receiver_control_{x}_{y}', itf, signature='wire<TrafficReceiverConfig>')
+
+class Benchmark(gvsoc.systree.Component):
+
+    def __init__(self, parent, name, parser):
+        super().__init__(parent, name)
+
+        parser.add_argument("--bench-grid", dest="bench_grid", default="3x3",
+            help="Size of the cluster grid, as <x>x<y>")
+        parser.add_argument("--bench-pattern", dest="bench_pattern", default="uniform",
+            choices=['uniform', 'transpose', 'bit_complement', 'hotspot', 'all_to_one'],
+            help="Traffic pattern")
+        parser.add_argument("--bench-rate", dest="bench_rate", type=float, default=8.0,
+            help="Injection rate of each cluster in bytes per cycle")
+        parser.add_argument("--bench-burst-size", dest="bench_burst_size", type=int, default=1024,
+            help="Size of each burst in bytes")
+        parser.add_argument("--bench-bursts", dest="bench_bursts", type=int, default=64,
+            help="Number of bursts injected by each cluster")
+        parser.add_argument("--bench-receiver-bw", dest="bench_receiver_bw", type=int, default=64,
+            help="Bandwidth of each cluster receiver in bytes per cycle")
+        parser.add_argument("--bench-hotspot-ratio", dest="bench_hotspot_ratio", type=int, default=50,
+            help="Percentage of the bursts going to the hotspot with the hotspot pattern")
+        parser.add_argument("--bench-analytical", dest="bench_analytical", action="store_true",
+            help="Model bursts analytically instead of flit by flit")
+        parser.add_argument("--bench-routing", dest="bench_routing", default="xy", choices=["xy", "west_first"],
+            help="Routing algorithm of the network")
+        parser.add_argument("--bench-vcs", dest="bench_vcs", type=int, default=1,
+            help="Number of virtual channels of the network")
+
+        [args, otherArgs] = parser.parse_known_args()
+
+        nb_cluster_x, nb_cluster_y = [int(dim) for dim in args.bench_grid.split('x')]
+        cluster_base = 0x80000000
+        cluster_size = 0x01000000
+
+        noc = pulp.floonoc.floonoc.FlooNocClusterGridNarrowWide(self, 'noc', 64, 8,
+            nb_cluster_x, nb_cluster_y, analytical_bursts=args.bench_analytical,
+            routing=args.bench_routing, nb_vcs=args.bench_vcs)
+
+        bench = FloonocBench(self, 'bench', nb_cluster_x, nb_cluster_y, cluster_base, cluster_size,
+            args.bench_pattern, args.bench_rate, args.bench_burst_size, args.bench_bursts,
+            args.bench_receiver_bw, args.bench_hotspot_ratio)
+
+        for x in range(0, nb_cluster_x):
+            for y in range(0, nb_cluster_y):
+                receiver = interco.traffic.receiver.Receiver(self, f'receiver_{x}_{y}')
+
+                bench.o_NOC_NI(x, y, noc.i_CLUSTER_WIDE_INPUT(x, y))
+                bench.o_RECEIVER_CONTROL(x, y, receiver.i_CONTROL())
+
+                noc.o_WIDE_MAP(
+                    receiver.i_INPUT(),
+                    cluster_base + cluster_size * (y * nb_cluster_x + x),
+                    cluster_size, x+1, y+1,
+                    name=f'ni_{x}_{y}')
+
+
+# This is a wrapping component of the real one in order to connect a clock generator to it
+# so that it automatically propagate to other components
+class Chip(gvsoc.systree.Component):
+
+    def __init__(self, parent, name, parser, options):
+
+        super().__init__(parent, name, options=options)
+
+        clock = vp.clock_domain.Clock_domain(self, 'clock', frequency=100000000)
+        soc = Benchmark(self, 'soc', parser)
+        clock.o_CLOCK    (soc.i_CLOCK    ())
+
+
+
+
+# This is the top target that gapy will instantiate
+class Target(gvsoc.runner.Target):
+
+    def __init__(self, parser, options):
+        super(Target, self).__init__(parser, options,
+            model=Chip, description="FlooNoc benchmark")
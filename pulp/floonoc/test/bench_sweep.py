@@ -0,0 +1,147 @@
+#!/usr/bin/env python3
+
+#
+# Copyright (C) 2020 GreenWaves Technologies, SAS, ETH Zurich and University of Bologna
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+
+# Runs the FlooNoc benchmark over a grid of configurations and dumps the results in a CSV file.
+# If a reference CSV file is given, the results are compared against it and the script fails
+# if the timing of the model changed or if the simulation speed dropped too much.
+
+import argparse
+import csv
+import itertools
+import os
+import subprocess
+import sys
+
+
+# Fields which describe the configuration of a run
+CONFIG_FIELDS = ['grid', 'pattern', 'rate', 'burst', 'analytical']
+# Fields which are the timing results of the model
+TIMING_FIELDS = ['cycles', 'throughput', 'lat_p50', 'lat_p90', 'lat_p99', 'lat_max']
+
+
+def run_bench(args, grid, pattern, rate, burst):
+    work_dir = os.path.join(args.work_dir, f'{grid}_{pattern}_{rate}_{burst}')
+    os.makedirs(work_dir, exist_ok=True)
+
+    cmd = ['gvsoc', f'--target-dir={os.path.dirname(os.path.abspath(__file__))}',
+        '--target=bench', f'--work-dir={work_dir}', 'run',
+        f'--bench-grid={grid}', f'--bench-pattern={pattern}', f'--bench-rate={rate}',
+        f'--bench-burst-size={burst}', f'--bench-bursts={args.bursts}']
+    if args.analytical:
+        cmd.append('--bench-analytical')
+
+    output = subprocess.run(cmd, capture_output=True, text=True).stdout
+
+    for line in output.splitlines():
+        if line.startswith('BENCH '):
+            result = dict(item.split('=') for item in line.split()[1:])
+            result['grid'] = grid
+            result['analytical'] = str(args.analytical)
+            return result
+
+    print(f'Benchmark failed: {" ".join(cmd)}', file=sys.stderr)
+    print(output, file=sys.stderr)
+    return None
+
+
+def compare(args, results):
+    with open(args.reference) as file:
+        reference = {tuple(row[f] for f in CONFIG_FIELDS): row for row in csv.DictReader(file)}
+
+    errors = 0
+    for result in results:
+        ref = reference.get(tuple(result[f] for f in CONFIG_FIELDS))
+        if ref is None:
+            continue
+
+        for field in TIMING_FIELDS:
+            value, ref_value = float(result[field]), float(ref[field])
+            if abs(value - ref_value) > abs(ref_value) * args.timing_tolerance / 100:
+                print(f'Timing mismatch ({result["grid"]} {result["pattern"]} {result["rate"]} '
+                    f'{result["burst"]}): {field} is {value}, expected {ref_value}')
+                errors += 1
+
+        speed, ref_speed = float(result['cycles_per_second']), float(ref['cycles_per_second'])
+        if speed < ref_speed * (1 - args.speed_tolerance / 100):
+            print(f'Speed regression ({result["grid"]} {result["pattern"]} {result["rate"]} '
+                f'{result["burst"]}): {speed:.0f} cycles/s, reference {ref_speed:.0f} cycles/s')
+            errors += 1
+
+    return errors
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Run the FlooNoc benchmark sweep')
+
+    parser.add_argument('--grid', dest='grids', action='append', default=None,
+        help='Cluster grid size, as <x>x<y>, can be given several times')
+    parser.add_argument('--pattern', dest='patterns', action='append', default=None,
+        help='Traffic pattern, can be given several times')
+    parser.add_argument('--rate', dest='rates', action='append', type=float, default=None,
+        help='Injection rate in bytes per cycle, can be given several times')
+    parser.add_argument('--burst-size', dest='bursts_sizes', action='append', type=int, default=None,
+        help='Burst size in bytes, can be given several times')
+    parser.add_argument('--bursts', type=int, default=64,
+        help='Number of bursts injected by each cluster')
+    parser.add_argument('--analytical', action='store_true',
+        help='Model bursts analytically instead of flit by flit')
+    parser.add_argument('--work-dir', default='work_bench',
+        help='Directory where the benchmarks are run')
+    parser.add_argument('--output', default='bench.csv',
+        help='CSV file where the results are dumped')
+    parser.add_argument('--reference', default=None,
+        help='CSV file with reference results to compare with')
+    parser.add_argument('--timing-tolerance', type=float, default=0,
+        help='Allowed deviation of the timing results from the reference, in percent')
+    parser.add_argument('--speed-tolerance', type=float, default=20,
+        help='Allowed drop of simulation speed from the reference, in percent')
+
+    args = parser.parse_args()
+
+    grids = args.grids or ['2x2', '4x4', '8x8']
+    patterns = args.patterns or ['uniform', 'transpose', 'bit_complement', 'hotspot', 'all_to_one']
+    rates = args.rates or [4.0, 16.0, 64.0]
+    burst_sizes = args.bursts_sizes or [256, 4096]
+
+    results = []
+    failed = False
+    for grid, pattern, rate, burst in itertools.product(grids, patterns, rates, burst_sizes):
+        result = run_bench(args, grid, pattern, rate, burst)
+        if result is None:
+            failed = True
+            continue
+        print(f'{grid:>6} {pattern:>15} rate={rate:<6} burst={burst:<6} '
+            f'throughput={float(result["throughput"]):.2f} B/cycle '
+            f'p50={result["lat_p50"]} p99={result["lat_p99"]} '
+            f'speed={float(result["cycles_per_second"]):.0f} cycles/s')
+        results.append(result)
+
+    fields = CONFIG_FIELDS + [f for f in results[0].keys() if f not in CONFIG_FIELDS] if results else CONFIG_FIELDS
+    with open(args.output, 'w', newline='') as file:
+        writer = csv.DictWriter(file, fieldnames=fields)
+        writer.writeheader()
+        writer.writerows(results)
+
+    if args.reference is not None and compare(args, results) != 0:
+        failed = True
+
+    sys.exit(1 if failed else 0)
+
+
+if __name__ == '__main__':
+    main()
@@ -27,7 +27,9 @@ IDmaBe::IDmaBe(vp::Component *idma, IdmaTransferProducer *me,
     IdmaBeConsumer *loc_be_read, IdmaBeConsumer *loc_be_write,
     IdmaBeConsumer *ext_be_read, IdmaBeConsumer *ext_be_write)
 :   Block(idma, "be"),
-    fsm_event(this, &IDmaBe::fsm_handler)
+    fsm_event(this, &IDmaBe::fsm_handler),
+    bandwidth_event(this, &IDmaBe::bandwidth_handler),
+    bandwidth(*this, "bandwidth", 64)
 {
     // Middle-end and backend protocols will be used later for interaction
     this->me = me;
@@ -42,6 +44,44 @@ IDmaBe::IDmaBe(vp::Component *idma, IdmaTransferProducer *me,
     // Get the local area description to differentiate local and remote backend protocols
     this->loc_base = idma->get_js_config()->get_int("loc_base");
     this->loc_size = idma->get_js_config()->get_int("loc_size");
+
+    // Get the maximum number of transfers which can be split at the same time
+    int nb_transfers = idma->get_js_config()->get_int("nb_transfers");
+    if (nb_transfers < 1)
+    {
+        this->trace.fatal("Invalid number of concurrent transfers (nb_transfers: %d)\n", nb_transfers);
+    }
+    this->transfers.resize(nb_transfers);
+
+    this->bandwidth_window = idma->get_js_config()->get_int("bandwidth_window");
+}
+
+
+
+void IDmaBe::bandwidth_handler(vp::Block *__this, vp::ClockEvent *event)
+{
+    IDmaBe *_this = (IDmaBe *)__this;
+
+    _this->bandwidth.set(_this->bandwidth_window_bytes);
+
+    // Keep measuring while data is written, so that the signal goes back to 0 after the last
+    // window with some data
+    if (_this->bandwidth_window_bytes != 0)
+    {
+        _this->bandwidth_window_bytes = 0;
+        _this->bandwidth_event.enqueue(_this->bandwidth_window);
+    }
+}
+
+
+
+void IDmaBe::account_bandwidth(uint64_t size)
+{
+    this->bandwidth_window_bytes += size;
+    if (!this->bandwidth_event.is_enqueued())
+    {
+        this->bandwidth_event.enqueue(this->bandwidth_window);
+    }
 }
 
 
@@ -55,23 +95,44 @@ IdmaBeConsumer *IDmaBe::get_be_consumer(uint64_t base, uint64_t size, bool is_re
 }
 
 
-// This is called by middle to push a new transfer. This can called only once no transfer is active
-// but before they are fully handled by backend protocols so that transfer can be fully pipelined.
+IdmaBeConsumer **IDmaBe::get_dst_src_be(IdmaBeConsumer *dst_be)
+{
+    return dst_be == this->loc_be_write ? &this->loc_write_src_be : &this->ext_write_src_be;
+}
+
+
+// This is called by middle to push a new transfer. This can called only once a transfer slot is
+// free but before transfers are fully handled by backend protocols so that transfer can be fully
+// pipelined.
 void IDmaBe::enqueue_transfer(IdmaTransfer *transfer)
 {
     this->trace.msg(vp::Trace::LEVEL_TRACE, "Queueing burst (burst: %p, src: 0x%x, dst: 0x%x, size: 0x%x)\n",
         transfer, transfer->src, transfer->dst, transfer->size);
 
+    // Take the first free slot, the middle-end checked that there is one
+    IdmaBeTransferSlot *slot = NULL;
+    for (IdmaBeTransferSlot &transfer_slot: this->transfers)
+    {
+        if (transfer_slot.size == 0)
+        {
+            slot = &transfer_slot;
+            break;
+        }
+    }
+
     // Remember the transfer as it has to be provided when burst are sent to backend protocols
-    this->current_transfer = transfer;
+    slot->transfer = transfer;
 
     // Extract information abouth the transfer. This will be used to split it into smaller bursts
-    this->current_transfer_size = transfer->size;
+    slot->size = transfer->size;
     transfer->ack_size = transfer->size;
-    this->current_transfer_src = transfer->src;
-    this->current_transfer_dst = transfer->dst;
-    this->current_transfer_src_be = this->get_be_consumer(transfer->src, transfer->size, true);
-    this->current_transfer_dst_be = this->get_be_consumer(transfer->dst, transfer->size, false);
+    slot->src = transfer->src;
+    slot->dst = transfer->dst;
+    slot->src_be = this->get_be_consumer(transfer->src, transfer->size, true);
+    slot->dst_be = this->get_be_consumer(transfer->dst, transfer->size, false);
+
+    // Transfers are acknowledged in the order they are received
+    this->pending_transfers.push(transfer);
 
     // Trigger FSM
     this->fsm_event.enqueue();
@@ -80,60 +141,89 @@ void IDmaBe::enqueue_transfer(IdmaTransfer *transfer)
 
 bool IDmaBe::can_accept_transfer()
 {
-    // Only accept a new transfer if no transfer is being processed. Note that the back-end can
-    // start a new transfer as soon as it has been fully forwarded to source and destination
-    // back-ends.
-    return this->current_transfer_size == 0;
+    // Accept a new transfer if one of the slots is free. Note that a slot is freed as soon as
+    // its transfer has been fully forwarded to source and destination back-ends.
+    for (IdmaBeTransferSlot &slot: this->transfers)
+    {
+        if (slot.size == 0)
+        {
+            return true;
+        }
+    }
+    return false;
 }
 
 
 
-void IDmaBe::fsm_handler(vp::Block *__this, vp::ClockEvent *event)
+bool IDmaBe::delegate_burst(IdmaBeTransferSlot *slot)
 {
-    IDmaBe *_this = (IDmaBe *)__this;
+    IdmaBeConsumer **dst_src_be = this->get_dst_src_be(slot->dst_be);
 
-    // We can send a new transfer if:
-    // - a transfer is active
+    // We can send a new burst if:
+    // - the transfer is active
     // - the source backend can accept read burst
     // - the destination backend can accept write burst
-    // - if a transfer was previously sent, the source backend is the same of the previous
-    // trnasfer is done. This condition is to prevent several source backends to fetch
-    // bursts at the same time. Only the same source backend can do it.
-    if ((_this->prev_transfer_src_be == NULL
-        || _this->prev_transfer_src_be == _this->current_transfer_src_be
-        || _this->prev_transfer_src_be->is_empty()) && _this->current_transfer_size > 0
-        && _this->current_transfer_src_be->can_accept_burst()
-        && _this->current_transfer_dst_be->can_accept_burst())
-    {
-        uint64_t src = _this->current_transfer_src;
-        uint64_t dst = _this->current_transfer_dst;
-        uint64_t size = _this->current_transfer_size;
-
-        // Legalize the burst. We choose a burst that fits both backend protocols
-        uint64_t burst_size = _this->current_transfer_src_be->get_burst_size(src, size);
-        burst_size = _this->current_transfer_dst_be->get_burst_size(dst, burst_size);
-
-        _this->prev_transfer_src_be = _this->current_transfer_src_be;
-
-        // Enqueue the read burst. This will make the source backend start sending read requests
-        // to the memory
-        _this->current_transfer_src_be->read_burst(_this->current_transfer, src, burst_size);
-        // Also enqueue the write burst which will be used only when the source is pushing data,
-        // to know where to write it
-        _this->current_transfer_dst_be->write_burst(_this->current_transfer, dst, burst_size);
-
-        // Updated current transfer by removing the burst we just processed
-        _this->current_transfer_size -= burst_size;
-        _this->current_transfer_src += burst_size;
-        _this->current_transfer_dst += burst_size;
-
-        // Retry to send a burst in the next cycle
-        _this->fsm_event.enqueue();
-
-        if (_this->current_transfer_size == 0)
+    // - if a burst was previously sent to the same destination backend, the source backend is
+    // the same or the previous one is done. This condition is to prevent several source
+    // backends to push data to the same destination backend at the same time, since the
+    // destination handles bursts in order. Transfers using different backends can overlap.
+    if (slot->size == 0 || (*dst_src_be != NULL && *dst_src_be != slot->src_be
+        && !(*dst_src_be)->is_empty()) || !slot->src_be->can_accept_burst()
+        || !slot->dst_be->can_accept_burst())
+    {
+        return false;
+    }
+
+    uint64_t src = slot->src;
+    uint64_t dst = slot->dst;
+    uint64_t size = slot->size;
+
+    // Legalize the burst. We choose a burst that fits both backend protocols
+    uint64_t burst_size = slot->src_be->get_burst_size(src, size);
+    burst_size = slot->dst_be->get_burst_size(dst, burst_size);
+
+    *dst_src_be = slot->src_be;
+
+    // Enqueue the read burst. This will make the source backend start sending read requests
+    // to the memory
+    slot->src_be->read_burst(slot->transfer, src, burst_size);
+    // Also enqueue the write burst which will be used only when the source is pushing data,
+    // to know where to write it
+    slot->dst_be->write_burst(slot->transfer, dst, burst_size);
+
+    // Updated transfer by removing the burst we just processed
+    slot->size -= burst_size;
+    slot->src += burst_size;
+    slot->dst += burst_size;
+
+    if (slot->size == 0)
+    {
+        // In case the transfer is finished, the middle-end may push a new one
+        this->me->update();
+    }
+
+    return true;
+}
+
+
+
+void IDmaBe::fsm_handler(vp::Block *__this, vp::ClockEvent *event)
+{
+    IDmaBe *_this = (IDmaBe *)__this;
+    int nb_transfers = _this->transfers.size();
+
+    // Delegate at most one burst per cycle. Transfers are served in round-robin so that
+    // concurrent transfers progress at the same pace.
+    for (int i=0; i<nb_transfers; i++)
+    {
+        int index = (_this->next_transfer + i) % nb_transfers;
+        if (_this->delegate_burst(&_this->transfers[index]))
         {
-            // In case the transfer is finished, the middle-end may push a new one
-            _this->me->update();
+            _this->next_transfer = (index + 1) % nb_transfers;
+
+            // Retry to send a burst in the next cycle
+            _this->fsm_event.enqueue();
+            break;
         }
     }
 }
@@ -190,13 +280,78 @@ void IDmaBe::ack_data(IdmaTransfer *transfer, uint8_t *data, int size)
     // Account the acknowledged data
     transfer->ack_size -= size;
 
-    // And in case the whole transfer has been acknowledged, terminate it
-    if (transfer->ack_size == 0)
+    // And measure the bandwidth
+    this->account_bandwidth(size);
+
+    // And in case the whole transfer has been acknowledged, terminate it, as well as the
+    // following ones which finished before it
+    while (this->pending_transfers.size() > 0 && this->pending_transfers.front()->ack_size == 0)
     {
-        this->trace.msg(vp::Trace::LEVEL_TRACE, "Finished burst (transfer: %p)\n", transfer);
+        IdmaTransfer *finished_transfer = this->pending_transfers.front();
+        this->pending_transfers.pop();
+
+        this->trace.msg(vp::Trace::LEVEL_TRACE, "Finished burst (transfer: %p)\n", finished_transfer);
 
         // And if so, notify the middle end
-        this->me->ack_transfer(transfer);
+        this->me->ack_transfer(finished_transfer);
+    }
+}
+
+
+
+void IDmaBe::copy(uint64_t src, uint64_t dst, uint64_t size, IdmaTransferProducer *producer)
+{
+    if (this->copy_buffer.size() < size)
+    {
+        this->copy_buffer.resize(size);
+    }
+
+    this->copy_dst = dst;
+    this->copy_size = size;
+    this->copy_producer = producer;
+
+    // First read the source. If the response is asynchronous, the write is issued from
+    // access_done
+    this->copy_state = IDMA_COPY_READ;
+    if (this->get_be_consumer(src, size, true)->access(src, size, this->copy_buffer.data(), false))
+    {
+        this->copy_write();
+    }
+}
+
+
+
+void IDmaBe::copy_write()
+{
+    this->copy_state = IDMA_COPY_WRITE;
+    if (this->get_be_consumer(this->copy_dst, this->copy_size, false)->access(this->copy_dst,
+        this->copy_size, this->copy_buffer.data(), true))
+    {
+        this->copy_state = IDMA_COPY_IDLE;
+        this->account_bandwidth(this->copy_size);
+    }
+}
+
+
+
+void IDmaBe::access_done()
+{
+    this->trace.msg(vp::Trace::LEVEL_TRACE, "Direct access done (state: %d)\n", this->copy_state);
+
+    if (this->copy_state == IDMA_COPY_READ)
+    {
+        this->copy_write();
+    }
+    else
+    {
+        this->copy_state = IDMA_COPY_IDLE;
+        this->account_bandwidth(this->copy_size);
+    }
+
+    // The copy was pending, notify the stage which issued it so that it continues
+    if (this->copy_state == IDMA_COPY_IDLE)
+    {
+        this->copy_producer->update();
     }
 }
 
@@ -206,7 +361,18 @@ void IDmaBe::reset(bool active)
 {
     if (active)
     {
-        this->current_transfer_size = 0;
-        this->prev_transfer_src_be = NULL;
+        for (IdmaBeTransferSlot &slot: this->transfers)
+        {
+            slot.size = 0;
+        }
+        while (this->pending_transfers.size() > 0)
+        {
+            this->pending_transfers.pop();
+        }
+        this->next_transfer = 0;
+        this->copy_state = IDMA_COPY_IDLE;
+        this->loc_write_src_be = NULL;
+        this->ext_write_src_be = NULL;
+        this->bandwidth_window_bytes = 0;
     }
 }
@@ -20,7 +20,10 @@
 
 #pragma once
 
+#include <queue>
+#include <vector>
 #include <vp/vp.hpp>
+#include <vp/signal.hpp>
 #include "../idma.hpp"
 #include "vp/itf/io.hpp"
 
@@ -139,6 +142,23 @@ public:
      * @return The legalized burst size
      */
     virtual uint64_t get_burst_size(uint64_t base, uint64_t size) = 0;
+
+    /**
+     * @brief Direct access
+     *
+     * This is used in fast-forward mode to read or write a whole area in one shot, without
+     * modeling any timing. Interconnects like the NoC may still reply asynchronously, in which
+     * case the backend protocol calls access_done on the backend once the access is done.
+     * Only one direct access can be pending at the same time on a backend protocol.
+     *
+     * @param base Base address of the access
+     * @param size Size of the access
+     * @param data Pointer to the data to be read or written
+     * @param is_write True if it is a write
+     *
+     * @return True if the access is done, false if it is pending
+     */
+    virtual bool access(uint64_t base, uint64_t size, uint8_t *data, bool is_write) = 0;
 };
 
 
@@ -196,11 +216,44 @@ public:
      * @param size Size of the written data being acknowledged
      */
     virtual void ack_data(IdmaTransfer *transfer, uint8_t *data, int size) = 0;
+
+    /**
+     * @brief Notify the end of a pending direct access
+     *
+     * This is called by a backend protocol when a direct access for which it returned false is
+     * done.
+     */
+    virtual void access_done() = 0;
 };
 
 
 
 
+/**
+ * @brief Transfer being split by the backend
+ *
+ * This keeps track of the part of a transfer which has not yet been delegated to the backend
+ * protocols.
+ */
+class IdmaBeTransferSlot
+{
+public:
+    // Transfer being split
+    IdmaTransfer *transfer;
+    // Source address of the next burst
+    uint64_t src;
+    // Destination address of the next burst
+    uint64_t dst;
+    // Remaining size to be delegated. The slot is free when this is 0
+    uint64_t size;
+    // Source backend protocol of the transfer
+    IdmaBeConsumer *src_be;
+    // Destination backend protocol of the transfer
+    IdmaBeConsumer *dst_be;
+};
+
+
+
 /**
  * @brief Backend
  *
@@ -232,42 +285,94 @@ public:
     bool is_ready_to_accept_data(IdmaTransfer *transfer) override;
     void write_data(IdmaTransfer *transfer, uint8_t *data, uint64_t size) override;
     void ack_data(IdmaTransfer *transfer, uint8_t *data, int size) override;
+    void access_done() override;
+
+    /**
+     * @brief Copy data through direct accesses
+     *
+     * This is used in fast-forward mode to copy a whole row in one shot, without modeling any
+     * timing. The copy is done immediately unless one of the accesses is answered
+     * asynchronously, in which case is_copy_pending returns true until the copy is done, and
+     * the producer is then updated. Only one copy can be done at the same time.
+     *
+     * @param src Source address
+     * @param dst Destination address
+     * @param size Size of the copy
+     * @param producer Stage to be updated once a pending copy is done
+     */
+    void copy(uint64_t src, uint64_t dst, uint64_t size, IdmaTransferProducer *producer);
+
+    /**
+     * @brief Tell if a copy is waiting for an asynchronous access
+     *
+     * @return True if the last copy is not yet done
+     */
+    bool is_copy_pending() { return this->copy_state != IDMA_COPY_IDLE; }
 
 private:
     // FSM handler, called to check if any action should be taken after something was updated
     static void fsm_handler(vp::Block *__this, vp::ClockEvent *event);
+    // Called at the end of each bandwidth window to update the bandwidth signal
+    static void bandwidth_handler(vp::Block *__this, vp::ClockEvent *event);
+    // Account written bytes in the current bandwidth window, both for timed transfers and
+    // fast-forward copies
+    void account_bandwidth(uint64_t size);
     // Returne backend protocol corresponding to the specified range
     IdmaBeConsumer *get_be_consumer(uint64_t base, uint64_t size, bool is_read);
+    // Return the last source backend protocol used with the specified destination
+    IdmaBeConsumer **get_dst_src_be(IdmaBeConsumer *dst_be);
+    // Issue the write access of the current copy, once the data has been read
+    void copy_write();
+    // Try to delegate the next burst of a transfer, returns true if it was delegated
+    bool delegate_burst(IdmaBeTransferSlot *slot);
     // Pointer to middle-end, used to interact with it
     IdmaTransferProducer *me;
     // Trace for this block, messages will be displayed with this block's name
     vp::Trace trace;
     // Block FSM event, used to trigger all checks after something has been updated
     vp::ClockEvent fsm_event;
-    // Current transfer being processed. This transfer is kept active until all bursts
-    // have been delegated to backend protocols.
-    IdmaTransfer *current_transfer;
-    // Current source address of the current transfer. This is increased everytime a burst is
-    // delegated
-    uint64_t current_transfer_src;
-    // Current destination address of the current transfer. This is increased everytime a burst is
-    // delegated
-    uint64_t current_transfer_dst;
-    // Current size of the current transfer. This is decreased everytime a burst is delegated
-    uint64_t current_transfer_size;
-    // Gives tha last backend used for the source of a transfer. This is used to check
-    // that the transfer os done before changing source backend.
-    IdmaBeConsumer *prev_transfer_src_be;
-    // Source backend protocol of the current transfer
-    IdmaBeConsumer *current_transfer_src_be;
-    // Destination backend protocol of the current transfer
-    IdmaBeConsumer *current_transfer_dst_be;
+    // Transfers being split into bursts. A slot is free when its remaining size is 0. Several
+    // transfers can be split at the same time, up to the top parameter nb_transfers, so that
+    // transfers using different backend protocols, like a TCDM to L2 transfer and an L2 to TCDM
+    // one, can overlap.
+    std::vector<IdmaBeTransferSlot> transfers;
+    // Index of the slot from which the FSM starts looking for a burst to delegate, to serve
+    // transfers in round-robin
+    int next_transfer;
+    // Transfers not yet acknowledged to the middle-end, in the order they were received.
+    // Transfers can finish out of order when they overlap, but are always acknowledged in order
+    // so that the completion seen by the front-end is the same as with a single transfer.
+    std::queue<IdmaTransfer *> pending_transfers;
+    // Last source backend protocol which sent a burst to the local and external destination
+    // backend protocols. This is used to check that the source is done before another one
+    // starts pushing data to the same destination, since destination bursts are processed in
+    // order.
+    IdmaBeConsumer *loc_write_src_be;
+    IdmaBeConsumer *ext_write_src_be;
     // Backend for local area
     IdmaBeConsumer *loc_be_read;
     IdmaBeConsumer *loc_be_write;
     // Backend for external area
     IdmaBeConsumer *ext_be_read;
     IdmaBeConsumer *ext_be_write;
+    // Top parameter giving the number of cycles over which the bandwidth is measured
+    int64_t bandwidth_window;
+    // Number of bytes written during the current bandwidth window
+    uint64_t bandwidth_window_bytes;
+    // Event used to close bandwidth windows, only enqueued while data is written
+    vp::ClockEvent bandwidth_event;
+    // Number of bytes written during the last bandwidth window, for VCD traces
+    vp::Signal<uint64_t> bandwidth;
+    // Buffer used for copies in fast-forward mode. It is kept across copies and only grows
+    // when a bigger copy is done.
+    std::vector<uint8_t> copy_buffer;
+    // Access of the current copy waiting for an asynchronous response, if any
+    enum { IDMA_COPY_IDLE, IDMA_COPY_READ, IDMA_COPY_WRITE } copy_state;
+    // Destination and size of the current copy, used to issue the write once the data is read
+    uint64_t copy_dst;
+    uint64_t copy_size;
+    // Stage to be updated once a pending copy is done
+    IdmaTransferProducer *copy_producer;
     // Base address of the local area
     uint64_t loc_base;
     // Size of the local area
@@ -60,6 +60,9 @@ IDmaBeAxi::IDmaBeAxi(vp::Component *idma, std::string itf_name, IdmaBeProducer *
         // Note that bursts are only used for reading. Writing is using dynamically allocated
         // requests to fit the other backend data chunks.
         this->bursts[i].set_data(new uint8_t[AXI_PAGE_SIZE]);
+
+        // Also preallocate as many requests for writing chunks of data
+        this->write_reqs.push_back(new vp::IoReq());
     }
 }
 
@@ -71,6 +74,28 @@ IDmaBeAxi::~IDmaBeAxi()
     {
         delete[] req.get_data();
     }
+
+    for (vp::IoReq *req: this->write_reqs)
+    {
+        delete req;
+    }
+}
+
+
+
+vp::IoReq *IDmaBeAxi::alloc_write_req()
+{
+    if (this->free_write_reqs.size() == 0)
+    {
+        // All requests are pending, allocate a new one. It will be kept and reused afterwards.
+        vp::IoReq *req = new vp::IoReq();
+        this->write_reqs.push_back(req);
+        return req;
+    }
+
+    vp::IoReq *req = this->free_write_reqs.back();
+    this->free_write_reqs.pop_back();
+    return req;
 }
 
 
@@ -103,6 +128,14 @@ void IDmaBeAxi::reset(bool active)
             this->free_bursts.push(&req);
         }
 
+        // Same for write requests
+        this->free_write_reqs.clear();
+        for (vp::IoReq *req: this->write_reqs)
+        {
+            req->arg_alloc();
+            this->free_write_reqs.push_back(req);
+        }
+
         // Note that to be safe,
         // if any request is pending outside this component, the convention is that
         // any component inside the same reset domain will just release the request, while
@@ -240,6 +273,13 @@ void IDmaBeAxi::axi_response(vp::Block *__this, vp::IoReq *req)
 {
     IDmaBeAxi *_this = (IDmaBeAxi *)__this;
 
+    if (req == &_this->direct_req)
+    {
+        // End of a pending direct access done in fast-forward mode
+        _this->be->access_done();
+        return;
+    }
+
     // Just enqueue the response, it will be processed at the right timestamp, depending
     // on latency
     if (req->get_is_write())
@@ -265,7 +305,7 @@ void IDmaBeAxi::write_data(IdmaTransfer *transfer, uint8_t *data, uint64_t size)
 {
     // Each chunk is directly sent to AXI to avoid sending whole burst at the end.
     // Allocate a request and send it. The burst limitation is modeled with another request
-    vp::IoReq *req = new vp::IoReq();
+    vp::IoReq *req = this->alloc_write_req();
 
     uint64_t base = this->current_burst_base;
     this->current_burst_base += size;
@@ -329,7 +369,7 @@ void IDmaBeAxi::write_handle_req_end(vp::IoReq *req)
         this->update();
     }
 
-    delete req;
+    this->free_write_reqs.push_back(req);
 
     // For now we ignore the latency for write requests.
     // This will be better modeled when we switch to the new AXI router
@@ -337,6 +377,36 @@ void IDmaBeAxi::write_handle_req_end(vp::IoReq *req)
 
 
 
+bool IDmaBeAxi::access(uint64_t base, uint64_t size, uint8_t *data, bool is_write)
+{
+    vp::IoReq *req = &this->direct_req;
+
+    req->init();
+    req->set_is_write(is_write);
+    req->set_addr(base);
+    req->set_size(size);
+    req->set_data(data);
+
+    vp::IoReqStatus status = this->ico_itf.req(req);
+    if (status == vp::IoReqStatus::IO_REQ_INVALID)
+    {
+        trace.force_warning("Invalid access during AXI direct access (base: 0x%lx, size: 0x%lx)\n",
+            base, size);
+    }
+    else if (status != vp::IoReqStatus::IO_REQ_OK)
+    {
+        // Interconnects like the NoC always reply asynchronously. The response callback will
+        // notify the backend. The latency is ignored as fast-forward timing is analytical.
+        this->trace.msg(vp::Trace::LEVEL_TRACE, "Pending direct access (base: 0x%lx, size: 0x%lx)\n",
+            base, size);
+        return false;
+    }
+
+    return true;
+}
+
+
+
 bool IDmaBeAxi::can_accept_burst()
 {
     // We can accept a burst as soon as one is available
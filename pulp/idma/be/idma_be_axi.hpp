@@ -58,6 +58,7 @@ public:
     void write_data_ack(uint8_t *data) override;
     void write_data(IdmaTransfer *transfer, uint8_t *data, uint64_t size) override;
     uint64_t get_burst_size(uint64_t base, uint64_t size) override;
+    bool access(uint64_t base, uint64_t size, uint8_t *data, bool is_write) override;
     bool can_accept_burst() override;
     bool can_accept_data() override;
     bool is_empty() override;
@@ -76,6 +77,8 @@ private:
     void send_read_burst_to_axi();
     // Enqueue a burst to pending queue. Burst will be processed in order
     void enqueue_burst(uint64_t base, uint64_t size, bool is_write, IdmaTransfer *transfer);
+    // Get a free request for writing a chunk of data
+    vp::IoReq *alloc_write_req();
 
     // Pointer to backend, used for data synchronization
     IdmaBeProducer *be;
@@ -105,6 +108,16 @@ private:
     // processed.
     std::queue<vp::IoReq *> pending_bursts;
 
+    // All requests used for writing chunks of data. They are allocated once and reused to avoid
+    // allocating a request for each chunk. More requests are allocated only if all of them are
+    // pending in the interconnect.
+    std::vector<vp::IoReq *> write_reqs;
+    // Write requests which are not used
+    std::vector<vp::IoReq *> free_write_reqs;
+
+    // Request used for direct accesses. There is at most one pending at the same time.
+    vp::IoReq direct_req;
+
     // Current base of the first transfer. This is when a chunk of data to be written is received
     // to know the base where it should be written.
     uint64_t current_burst_base;
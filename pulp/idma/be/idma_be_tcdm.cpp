@@ -46,6 +46,40 @@ IDmaBeTcdm::IDmaBeTcdm(vp::Component *idma, std::string itf_name, IdmaBeProducer
 
     // Local memory base
     this->loc_base = idma->get_js_config()->get_int("loc_base");
+
+    // Preallocate enough line buffers for the usual number of lines waiting for acknowledgement
+    for (int i=0; i<this->burst_queue_maxsize; i++)
+    {
+        this->lines.push_back(new uint8_t[this->width]);
+    }
+}
+
+
+
+IDmaBeTcdm::~IDmaBeTcdm()
+{
+    for (uint8_t *line: this->lines)
+    {
+        delete[] line;
+    }
+}
+
+
+
+uint8_t *IDmaBeTcdm::alloc_line()
+{
+    if (this->free_lines.size() == 0)
+    {
+        // All lines are waiting for acknowledgement, allocate a new one. It will be kept
+        // and reused afterwards.
+        uint8_t *line = new uint8_t[this->width];
+        this->lines.push_back(line);
+        return line;
+    }
+
+    uint8_t *line = this->free_lines.back();
+    this->free_lines.pop_back();
+    return line;
 }
 
 
@@ -102,6 +136,32 @@ uint64_t IDmaBeTcdm::get_burst_size(uint64_t base, uint64_t size)
 }
 
 
+bool IDmaBeTcdm::access(uint64_t base, uint64_t size, uint8_t *data, bool is_write)
+{
+    vp::IoReq req;
+
+    req.init();
+    req.set_is_write(is_write);
+    req.set_addr(base - this->loc_base);
+    req.set_size(size);
+    req.set_data(data);
+
+    vp::IoReqStatus status = this->ico_itf.req(&req);
+    if (status == vp::IoReqStatus::IO_REQ_INVALID)
+    {
+        trace.force_warning("Invalid access during TCDM direct access (base: 0x%lx, size: 0x%lx)\n",
+            base, size);
+    }
+    else if (status != vp::IoReqStatus::IO_REQ_OK)
+    {
+        trace.fatal("Asynchronous response is not supported for TCDM direct access\n");
+    }
+
+    return true;
+}
+
+
+
 bool IDmaBeTcdm::can_accept_burst()
 {
     // Accept a burst if we have room in the queue of pending bursts
@@ -147,6 +207,9 @@ void IDmaBeTcdm::reset(bool active)
         this->write_ack_timestamp = -1;
 
         this->last_line_timestamp = -1;
+
+        // Mark all line buffers as free
+        this->free_lines = this->lines;
     }
 }
 
@@ -294,9 +357,9 @@ void IDmaBeTcdm::read_line()
     req->set_addr(base - this->loc_base);
     req->set_size(size);
     // Since the destination backend may keep the data until the write is done, we need
-    // to dynamically allocate the data since we may read several times before data is acknowledged
-    // We will free it when we receive the ack
-    req->set_data(new uint8_t[size]);
+    // a different line buffer for each line since we may read several times before data is
+    // acknowledged. We will release it when we receive the ack
+    req->set_data(this->alloc_line());
 
     // Send to TCDM
     vp::IoReqStatus status = this->ico_itf.req(req);
@@ -334,8 +397,8 @@ void IDmaBeTcdm::read_line()
 // Called by destination backend to ack the data we sent for writing
 void IDmaBeTcdm::write_data_ack(uint8_t *data)
 {
-    // Release the data since we are now sure it won't be used anymore
-    delete[] data;
+    // Release the line buffer since we are now sure it won't be used anymore
+    this->free_lines.push_back(data);
     // And check if there is any action to take since backend may became ready
     this->update();
 }
@@ -20,6 +20,7 @@
 
 #pragma once
 
+#include <vector>
 #include <vp/vp.hpp>
 #include <vp/itf/io.hpp>
 #include "../idma.hpp"
@@ -43,6 +44,11 @@ public:
      */
     IDmaBeTcdm(vp::Component *idma, std::string itf_name, IdmaBeProducer *be);
 
+    /**
+     * @brief Destroy a TCDM back-end
+     */
+    ~IDmaBeTcdm();
+
     void reset(bool active) override;
 
     void update();
@@ -51,6 +57,7 @@ public:
     void write_data(IdmaTransfer *transfer, uint8_t *data, uint64_t size) override;
     void write_data_ack(uint8_t *data) override;
     uint64_t get_burst_size(uint64_t base, uint64_t size) override;
+    bool access(uint64_t base, uint64_t size, uint8_t *data, bool is_write) override;
     bool can_accept_burst() override;
     bool can_accept_data() override;
     bool is_empty() override;
@@ -73,6 +80,8 @@ private:
     void activate_burst();
     // Enqueue a new burst to the queue of pending bursts
     void enqueue_burst(uint64_t base, uint64_t size, bool is_write, IdmaTransfer *transfer);
+    // Get a free line buffer for reading a line
+    uint8_t *alloc_line();
 
     // Pointer to back-end, used for data synchronization
     IdmaBeProducer *be;
@@ -93,6 +102,13 @@ private:
     // Request used for TCDM accesses, only one at the same time is possible
     vp::IoReq req;
 
+    // All line buffers, each one of the interface width. They are allocated once and reused to
+    // avoid allocating data for each line which is read. More buffers are allocated only if all
+    // of them are waiting for the destination to acknowledge them.
+    std::vector<uint8_t *> lines;
+    // Line buffers which are not used and can be used for reading a line
+    std::vector<uint8_t *> free_lines;
+
     // Queue of pending bursts giving burst base address
     std::queue<uint64_t> burst_queue_base;
     // Queue of pending bursts giving burst size
@@ -32,6 +32,23 @@ class CheshireDma(gvsoc.systree.Component):
         Number of transfer requests which can be queued to the DMA.
     burst_queue_size: int
         Maximum number of outstanding burst requests.
+    nb_transfers: int
+        Maximum number of transfers which the backend can split into bursts at the same time.
+        Transfers using different source and destination backends, like a TCDM to L2 transfer
+        and an L2 to TCDM one, can then overlap.
+    fast_forward: bool
+        True if transfers are initially done functionally in one shot instead of being timed.
+        This can then be changed at runtime through the fast-forward interface.
+    ff_latency: int
+        Fixed latency in cycles of a transfer in fast-forward mode.
+    ff_bandwidth: int
+        Bandwidth in bytes per cycle of transfers in fast-forward mode.
+    profile_file: str
+        Path of the file where a record of each transfer is dumped, as CSV, or as binary if the
+        path ends with .bin. The path of the DMA component is inserted before the extension so
+        that several DMAs can share the same setting. Nothing is dumped if it is None.
+    bandwidth_window: int
+        Number of cycles over which the bandwidth VCD signal is measured.
     loc_base: int
         Base address of the local area.
     loc_size: int
@@ -41,6 +58,12 @@ class CheshireDma(gvsoc.systree.Component):
     def __init__(self, parent: gvsoc.systree.Component, name: str,
             transfer_queue_size: int=8,
             burst_queue_size: int=8,
+            nb_transfers: int=1,
+            fast_forward: bool=False,
+            ff_latency: int=10,
+            ff_bandwidth: int=8,
+            profile_file: str=None,
+            bandwidth_window: int=100,
             loc_base: int=0,
             loc_size: int=0):
 
@@ -50,14 +73,22 @@ class CheshireDma(gvsoc.systree.Component):
             'pulp/idma/cheshire_dma.cpp',
             'pulp/idma/fe/idma_fe_cheshire.cpp',
             'pulp/idma/me/idma_me_2d.cpp',
+            'pulp/idma/me/idma_me_ff.cpp',
             'pulp/idma/be/idma_be.cpp',
             'pulp/idma/be/idma_be_axi.cpp',
             'pulp/idma/be/idma_be_tcdm.cpp',
+            'pulp/idma/idma_profiler.cpp',
         ])
 
         self.add_properties({
             "transfer_queue_size": transfer_queue_size,
             "burst_queue_size": burst_queue_size,
+            "nb_transfers": nb_transfers,
+            "fast_forward": fast_forward,
+            "ff_latency": ff_latency,
+            "ff_bandwidth": ff_bandwidth,
+            "profile_file": profile_file if profile_file is not None else '',
+            "bandwidth_window": bandwidth_window,
             "loc_base": loc_base,
             "loc_size": loc_size,
         })
@@ -79,6 +110,19 @@ class CheshireDma(gvsoc.systree.Component):
         """
         self.itf_bind('offload_grant', itf, signature='wire<IssOffloadInsnGrant<uint32_t>*>')
 
+    def i_FAST_FORWARD(self) -> gvsoc.systree.SlaveItf:
+        """Returns the fast-forward port.
+
+        This can be used to switch at runtime between timed transfers and functional transfers
+        with an analytical latency.\n
+
+        Returns
+        ----------
+        gvsoc.systree.SlaveItf
+            The slave interface
+        """
+        return gvsoc.systree.SlaveItf(self, 'fast_forward', signature='wire<bool>')
+
     def o_AXI(self, itf: gvsoc.systree.SlaveItf):
         """Binds the AXI port.
 
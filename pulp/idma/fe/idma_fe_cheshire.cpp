@@ -33,9 +33,16 @@ IDmaFeCheshire::IDmaFeCheshire(vp::Component *idma, IdmaTransferConsumer *me)
     src_stride(*this, "src_stride", 64),
     dst_stride(*this, "dst_stride", 64),
     reps(*this, "reps", 64),
+    src_stride_3d(*this, "src_stride_3d", 64),
+    dst_stride_3d(*this, "dst_stride_3d", 64),
+    reps_3d(*this, "reps_3d", 64),
+    src_stride_4d(*this, "src_stride_4d", 64),
+    dst_stride_4d(*this, "dst_stride_4d", 64),
+    reps_4d(*this, "reps_4d", 64),
     next_transfer_id(*this, "next_transfer_id", 64, true, 2),
     completed_id(*this, "completed_id", 64, true, 1),
-    do_transfer_grant(*this, "do_transfer_grant", 1)
+    do_transfer_grant(*this, "do_transfer_grant", 1),
+    profiler(idma, this)
 {
     transfer_granted = false;
 
@@ -119,6 +126,48 @@ vp::IoReqStatus IDmaFeCheshire::req(vp::Block *__this, vp::IoReq *req)
         }
         break;
 
+    case IDMA_REG64_2D_FRONTEND_STRIDE_SRC_3D_REG_OFFSET:
+        if (is_write && size == 8) {
+            _this->trace.msg("Received 3D source stride write (stride: 0x%lx)\n", *(uint64_t *)data);
+            _this->src_stride_3d.set(*(uint64_t *)data);
+        }
+        break;
+
+    case IDMA_REG64_2D_FRONTEND_STRIDE_DST_3D_REG_OFFSET:
+        if (is_write && size == 8) {
+            _this->trace.msg("Received 3D destination stride write (stride: 0x%lx)\n", *(uint64_t *)data);
+            _this->dst_stride_3d.set(*(uint64_t *)data);
+        }
+        break;
+
+    case IDMA_REG64_2D_FRONTEND_NUM_REPETITIONS_3D_REG_OFFSET:
+        if (is_write && size == 8) {
+            _this->trace.msg("Received 3D number of repetitions write (reps: 0x%lx)\n", *(uint64_t *)data);
+            _this->reps_3d.set(*(uint64_t *)data);
+        }
+        break;
+
+    case IDMA_REG64_2D_FRONTEND_STRIDE_SRC_4D_REG_OFFSET:
+        if (is_write && size == 8) {
+            _this->trace.msg("Received 4D source stride write (stride: 0x%lx)\n", *(uint64_t *)data);
+            _this->src_stride_4d.set(*(uint64_t *)data);
+        }
+        break;
+
+    case IDMA_REG64_2D_FRONTEND_STRIDE_DST_4D_REG_OFFSET:
+        if (is_write && size == 8) {
+            _this->trace.msg("Received 4D destination stride write (stride: 0x%lx)\n", *(uint64_t *)data);
+            _this->dst_stride_4d.set(*(uint64_t *)data);
+        }
+        break;
+
+    case IDMA_REG64_2D_FRONTEND_NUM_REPETITIONS_4D_REG_OFFSET:
+        if (is_write && size == 8) {
+            _this->trace.msg("Received 4D number of repetitions write (reps: 0x%lx)\n", *(uint64_t *)data);
+            _this->reps_4d.set(*(uint64_t *)data);
+        }
+        break;
+
     case IDMA_REG64_2D_FRONTEND_CONF_REG_OFFSET:
         // Set configuration for 2D transfer
         if (is_write && size == 8) {
@@ -172,6 +221,27 @@ uint64_t IDmaFeCheshire::enqueue_copy(void)
     transfer->reps       = this->reps.get();
     transfer->config     = this->config.get();
 
+    // Higher dimensions are only used for 2D transfers and when their number of repetitions
+    // is not 0
+    transfer->nb_dims = ((transfer->config >> 1) & 1) ? 2 : 1;
+    if (transfer->nb_dims == 2 && this->reps_3d.get() != 0)
+    {
+        transfer->nb_dims = 3;
+        transfer->src_stride_nd[0] = this->src_stride_3d.get();
+        transfer->dst_stride_nd[0] = this->dst_stride_3d.get();
+        transfer->reps_nd[0] = this->reps_3d.get();
+
+        if (this->reps_4d.get() != 0)
+        {
+            transfer->nb_dims = 4;
+            transfer->src_stride_nd[1] = this->src_stride_4d.get();
+            transfer->dst_stride_nd[1] = this->dst_stride_4d.get();
+            transfer->reps_nd[1] = this->reps_4d.get();
+        }
+    }
+
+    this->profiler.transfer_enqueued(transfer, transfer_id);
+
     this->trace.msg(vp::Trace::LEVEL_INFO, "Enqueuing transfer (id: %d, src: %llx, dst: %llx, "
         "size: %llx, src_stride: %llx, dst_stride: %llx, reps: %llx, config: %llx)\n",
         transfer_id, transfer->src, transfer->dst, transfer->size, transfer->src_stride,
@@ -190,6 +260,7 @@ uint64_t IDmaFeCheshire::enqueue_copy(void)
     {
         // If no enqueue the burst
         this->transfer_granted = true;
+        this->profiler.transfer_started(transfer);
         this->me->enqueue_transfer(transfer);
     }
     else
@@ -211,6 +282,7 @@ uint64_t IDmaFeCheshire::enqueue_copy(void)
 void IDmaFeCheshire::ack_transfer(IdmaTransfer *transfer)
 {
     this->completed_id.inc(1);
+    this->profiler.transfer_done(transfer);
     delete transfer;
 }
 
@@ -233,6 +305,7 @@ void IDmaFeCheshire::update()
             .result=this->next_transfer_id.get() - 1
         };
         this->offload_grant_itf.sync(&offload_grant);
+        this->profiler.transfer_started(transfer);
         this->me->enqueue_transfer(transfer);
     }
 }
@@ -27,6 +27,7 @@
 #include <vp/signal.hpp>
 #include <vp/itf/io.hpp>
 #include "../idma.hpp"
+#include "../idma_profiler.hpp"
 #include "idma_fe_cheshire_regs.hpp"
 
 /**
@@ -81,6 +82,15 @@ private:
     vp::Register<uint64_t> dst_stride;
     // Register holding replication
     vp::Register<uint64_t> reps;
+    // Registers holding source stride, destination stride and replication of the third
+    // dimension. The dimension is disabled if the replication is 0
+    vp::Register<uint64_t> src_stride_3d;
+    vp::Register<uint64_t> dst_stride_3d;
+    vp::Register<uint64_t> reps_3d;
+    // Same for the fourth dimension, which is used only if the third one is enabled
+    vp::Register<uint64_t> src_stride_4d;
+    vp::Register<uint64_t> dst_stride_4d;
+    vp::Register<uint64_t> reps_4d;
     // Transfer ID of the next transfer
     vp::Register<uint64_t> next_transfer_id;
     // Transfer ID of the last completed ID
@@ -91,4 +101,6 @@ private:
     vp::Signal<bool> do_transfer_grant;
     // In case a transfer was blocked, gives the transfer which was blocked
     IdmaTransfer *stalled_transfer;
+    // Profiler recording all transfers
+    IdmaProfiler profiler;
 };
@@ -50,6 +50,24 @@ extern "C" {
 // Number of 2D repetitions
 #define IDMA_REG64_2D_FRONTEND_NUM_REPETITIONS_REG_OFFSET 0x48
 
+// Source Stride of the third dimension
+#define IDMA_REG64_2D_FRONTEND_STRIDE_SRC_3D_REG_OFFSET 0x50
+
+// Destination Stride of the third dimension
+#define IDMA_REG64_2D_FRONTEND_STRIDE_DST_3D_REG_OFFSET 0x58
+
+// Number of 3D repetitions, 0 disables the third dimension
+#define IDMA_REG64_2D_FRONTEND_NUM_REPETITIONS_3D_REG_OFFSET 0x60
+
+// Source Stride of the fourth dimension
+#define IDMA_REG64_2D_FRONTEND_STRIDE_SRC_4D_REG_OFFSET 0x68
+
+// Destination Stride of the fourth dimension
+#define IDMA_REG64_2D_FRONTEND_STRIDE_DST_4D_REG_OFFSET 0x70
+
+// Number of 4D repetitions, 0 disables the fourth dimension
+#define IDMA_REG64_2D_FRONTEND_NUM_REPETITIONS_4D_REG_OFFSET 0x78
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif
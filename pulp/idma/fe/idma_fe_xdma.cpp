@@ -32,7 +32,8 @@ IDmaFeXdma::IDmaFeXdma(vp::Component *idma, IdmaTransferConsumer *me)
     reps(*this, "reps", 32),
     next_transfer_id(*this, "next_transfer_id", 32, true, 2),
     completed_id(*this, "completed_id", 32, true, 1),
-    do_transfer_grant(*this, "do_transfer_grant", 1)
+    do_transfer_grant(*this, "do_transfer_grant", 1),
+    profiler(idma, this)
 {
     // Middle-end will be used later for interaction
     this->me = me;
@@ -143,6 +144,10 @@ uint32_t IDmaFeXdma::enqueue_copy(uint32_t config, uint32_t size, bool &granted)
     transfer->dst_stride = this->dst_stride.get();
     transfer->reps = this->reps.get();
     transfer->config = config;
+    // Xdma instructions can only describe 1D and 2D transfers
+    transfer->nb_dims = ((config >> 1) & 1) ? 2 : 1;
+
+    this->profiler.transfer_enqueued(transfer, transfer_id);
 
     this->trace.msg(vp::Trace::LEVEL_INFO, "Enqueuing transfer (id: %d, src: %llx, dst: %llx, "
         "size: %llx, src_stride: %llx, dst_stride: %llx, reps: %llx, config: %llx)\n",
@@ -162,6 +167,7 @@ uint32_t IDmaFeXdma::enqueue_copy(uint32_t config, uint32_t size, bool &granted)
     {
         // If no enqueue the burst
         granted = true;
+        this->profiler.transfer_started(transfer);
         this->me->enqueue_transfer(transfer);
     }
     else
@@ -183,6 +189,7 @@ uint32_t IDmaFeXdma::enqueue_copy(uint32_t config, uint32_t size, bool &granted)
 void IDmaFeXdma::ack_transfer(IdmaTransfer *transfer)
 {
     this->completed_id.inc(1);
+    this->profiler.transfer_done(transfer);
     delete transfer;
 }
 
@@ -205,6 +212,7 @@ void IDmaFeXdma::update()
             .result=this->next_transfer_id.get() - 1
         };
         this->offload_grant_itf.sync(&offload_grant);
+        this->profiler.transfer_started(transfer);
         this->me->enqueue_transfer(transfer);
     }
 }
@@ -25,6 +25,7 @@
 #include <vp/register.hpp>
 #include <vp/signal.hpp>
 #include "../idma.hpp"
+#include "../idma_profiler.hpp"
 
 /**
  * @brief XDma front-end
@@ -82,4 +83,6 @@ private:
     vp::Signal<bool> do_transfer_grant;
     // In case a transfer was blocked, gives the transfer which was blocked
     IdmaTransfer *stalled_transfer;
+    // Profiler recording all transfers
+    IdmaProfiler profiler;
 };
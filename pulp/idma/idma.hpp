@@ -20,10 +20,14 @@
 
 #pragma once
 
+#include <algorithm>
 #include <vector>
 #include <vp/vp.hpp>
 
 
+// Maximum number of dimensions of a transfer
+#define IDMA_MAX_DIMS 4
+
 
 /**
  * @brief iDMA transfer
@@ -47,9 +51,15 @@ public:
     uint64_t reps;
     // Transfer config
     uint64_t config;
-
-    // Free rom for additional information
-    std::vector<uint64_t> data;
+    // Number of dimensions of the transfer, from 1 to IDMA_MAX_DIMS. The second dimension is
+    // described by src_stride, dst_stride and reps.
+    int nb_dims;
+    // Source strides of the dimensions above the second one. Index 0 is the third dimension.
+    uint64_t src_stride_nd[IDMA_MAX_DIMS - 2];
+    // Destination strides of the dimensions above the second one
+    uint64_t dst_stride_nd[IDMA_MAX_DIMS - 2];
+    // Repetitions of the dimensions above the second one
+    uint64_t reps_nd[IDMA_MAX_DIMS - 2];
 
 
     // Remaining number of bytes to be acknowledge when writing to memory. Used to know when
@@ -62,6 +72,121 @@ public:
     // Parent transfer. In case the parent has been split into several simpler transfers,
     // this field is set in the bursts to the parent transfer
     IdmaTransfer *parent;
+
+    // Transfer ID given by the front-end, used for profiling
+    uint64_t id;
+    // Cycle at which the front-end received the transfer, used for profiling
+    int64_t enqueue_cycle;
+    // Cycle at which the middle-end accepted the transfer, used for profiling
+    int64_t start_cycle;
+};
+
+
+
+
+/**
+ * @brief Iterator over the rows of an iDMA transfer
+ *
+ * This walks the 1D rows of a transfer with up to IDMA_MAX_DIMS dimensions. It is shared by the
+ * middle-ends so that all of them split transfers the same way.
+ */
+class IdmaRowIterator
+{
+public:
+    /**
+     * @brief Start iterating over a transfer
+     *
+     * The first dimension is the row itself, which is done in one repetition. The second one is
+     * given by the 2D fields and the others by the ND ones.
+     *
+     * @param transfer The transfer to iterate over
+     */
+    void init(IdmaTransfer *transfer)
+    {
+        this->nb_dims = std::max(transfer->nb_dims, 1);
+        this->reps[0] = 1;
+        this->src_strides[0] = 0;
+        this->dst_strides[0] = 0;
+        if (this->nb_dims > 1)
+        {
+            this->reps[1] = transfer->reps;
+            this->src_strides[1] = transfer->src_stride;
+            this->dst_strides[1] = transfer->dst_stride;
+        }
+        for (int dim=2; dim<this->nb_dims; dim++)
+        {
+            this->reps[dim] = transfer->reps_nd[dim - 2];
+            this->src_strides[dim] = transfer->src_stride_nd[dim - 2];
+            this->dst_strides[dim] = transfer->dst_stride_nd[dim - 2];
+        }
+
+        for (int dim=0; dim<this->nb_dims; dim++)
+        {
+            this->current_src[dim] = transfer->src;
+            this->current_dst[dim] = transfer->dst;
+            this->current_reps[dim] = this->reps[dim];
+        }
+    }
+
+    /**
+     * @brief Source address of the current row
+     */
+    uint64_t get_src() { return this->current_src[0]; }
+
+    /**
+     * @brief Destination address of the current row
+     */
+    uint64_t get_dst() { return this->current_dst[0]; }
+
+    /**
+     * @brief Move to the next row
+     *
+     * @return False if the transfer is done
+     */
+    bool next()
+    {
+        // Look for the first dimension which still has repetitions, starting from the rows
+        for (int dim=0; dim<this->nb_dims; dim++)
+        {
+            this->current_reps[dim]--;
+
+            if (this->current_reps[dim] != 0)
+            {
+                // Move this dimension to its next iteration
+                this->current_src[dim] += this->src_strides[dim];
+                this->current_dst[dim] += this->dst_strides[dim];
+
+                // And restart all lower dimensions from there
+                for (int lower_dim=dim-1; lower_dim>=0; lower_dim--)
+                {
+                    this->current_src[lower_dim] = this->current_src[dim];
+                    this->current_dst[lower_dim] = this->current_dst[dim];
+                    this->current_reps[lower_dim] = this->reps[lower_dim];
+                }
+                return true;
+            }
+        }
+
+        // All dimensions are done
+        return false;
+    }
+
+private:
+    // Number of dimensions of the transfer
+    int nb_dims;
+    // Source address of the current iteration of each dimension, updated each time a row is
+    // done. Index 0 is the first dimension, whose source address is the one of the current row.
+    uint64_t current_src[IDMA_MAX_DIMS];
+    // Destination address of the current iteration of each dimension
+    uint64_t current_dst[IDMA_MAX_DIMS];
+    // Remaining repetitions of each dimension, including the current one
+    uint64_t current_reps[IDMA_MAX_DIMS];
+    // Source stride of each dimension
+    uint64_t src_strides[IDMA_MAX_DIMS];
+    // Destination stride of each dimension
+    uint64_t dst_strides[IDMA_MAX_DIMS];
+    // Repetitions of each dimension
+    uint64_t reps[IDMA_MAX_DIMS];
 };
 
 
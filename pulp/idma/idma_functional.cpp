@@ -24,6 +24,7 @@
 #include <vp/register.hpp>
 #include <stdio.h>
 #include <string.h>
+#include <vector>
 #include <cpu/iss/include/offload.hpp>
 
 
@@ -52,6 +53,10 @@ private:
     vp::Register<uint64_t> dst;
     vp::Register<uint64_t> stride;
     vp::Register<uint32_t> reps;
+
+    // Buffer used to hold the data of a copy between the read and the write. It is kept
+    // across copies and only grows when a bigger copy is done.
+    std::vector<uint8_t> copy_buffer;
 };
 
 
@@ -84,11 +89,16 @@ void IDma::trigger_copy(uint32_t config, uint32_t size)
 {
     vp::IoReq req;
 
+    if (this->copy_buffer.size() < size)
+    {
+        this->copy_buffer.resize(size);
+    }
+
     req.init();
 
     req.set_addr(this->src.get());
     req.set_size(size);
-    req.set_data(new uint8_t[size]);
+    req.set_data(this->copy_buffer.data());
     req.set_is_write(false);
 
     int err = this->ico_itf.req(&req);
@@ -119,9 +129,6 @@ void IDma::trigger_copy(uint32_t config, uint32_t size)
     {
         this->trace.fatal("Unsupported pending or denied access (addr: 0x%lx, size: 0x%lx)\n", this->src.get(), size);
     }
-
-    delete[] req.get_data();
-
 }
 
 uint32_t IDma::get_status(uint32_t status)
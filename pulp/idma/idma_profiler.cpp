@@ -0,0 +1,140 @@
+/*
+ * Copyright (C) 2024 ETH Zurich and University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Authors: Germain Haugou, ETH Zurich (germain.haugou@iis.ee.ethz.ch)
+ */
+#include <algorithm>
+#include <vp/vp.hpp>
+#include "idma_profiler.hpp"
+
+
+
+IdmaProfiler::IdmaProfiler(vp::Component *idma, vp::Block *fe)
+{
+    this->fe = fe;
+    this->file = NULL;
+
+    idma->traces.new_trace("profiler/trace", &this->trace, vp::DEBUG);
+
+    // Local area is used to report which backend is used for source and destination
+    this->loc_base = idma->get_js_config()->get_int("loc_base");
+    this->loc_size = idma->get_js_config()->get_int("loc_size");
+
+    std::string path = idma->get_js_config()->get_child_str("profile_file");
+    if (path != "")
+    {
+        this->binary = path.size() >= 4 && path.substr(path.size() - 4) == ".bin";
+
+        // Insert the component path before the extension, several iDMAs may be given the same
+        // file, e.g. one per cluster
+        std::string idma_path = idma->get_path();
+        std::replace(idma_path.begin(), idma_path.end(), '/', '.');
+        size_t ext = path.find_last_of('.');
+        size_t dir = path.find_last_of('/');
+        if (ext == std::string::npos || (dir != std::string::npos && ext < dir))
+        {
+            ext = path.size();
+        }
+        path.insert(ext, idma_path[0] == '.' ? idma_path : "." + idma_path);
+
+        this->file = fopen(path.c_str(), this->binary ? "wb" : "w");
+        if (this->file == NULL)
+        {
+            this->trace.fatal("Unable to open iDMA profiling file (path: %s)\n", path.c_str());
+            return;
+        }
+
+        if (!this->binary)
+        {
+            fprintf(this->file, "id,src,dst,size,total_size,nb_dims,reps,src_stride,dst_stride,"
+                "enqueue_cycle,start_cycle,end_cycle,bytes_per_cycle,src_be,dst_be\n");
+        }
+    }
+}
+
+
+
+IdmaProfiler::~IdmaProfiler()
+{
+    if (this->file != NULL)
+    {
+        fclose(this->file);
+    }
+}
+
+
+
+void IdmaProfiler::transfer_enqueued(IdmaTransfer *transfer, uint64_t id)
+{
+    transfer->id = id;
+    transfer->enqueue_cycle = this->fe->clock.get_cycles();
+    // Transfers which are terminated directly are never started
+    transfer->start_cycle = transfer->enqueue_cycle;
+}
+
+
+
+void IdmaProfiler::transfer_started(IdmaTransfer *transfer)
+{
+    transfer->start_cycle = this->fe->clock.get_cycles();
+}
+
+
+
+void IdmaProfiler::transfer_done(IdmaTransfer *transfer)
+{
+    if (this->file == NULL)
+    {
+        return;
+    }
+
+    IdmaTransferRecord record;
+    record.id = transfer->id;
+    record.src = transfer->src;
+    record.dst = transfer->dst;
+    record.size = transfer->size;
+    record.nb_dims = transfer->nb_dims;
+    record.reps = transfer->nb_dims > 1 ? transfer->reps : 1;
+    record.src_stride = transfer->src_stride;
+    record.dst_stride = transfer->dst_stride;
+    record.enqueue_cycle = transfer->enqueue_cycle;
+    record.start_cycle = transfer->start_cycle;
+    record.end_cycle = this->fe->clock.get_cycles();
+    record.src_is_loc = transfer->src >= this->loc_base && transfer->src < this->loc_base + this->loc_size;
+    record.dst_is_loc = transfer->dst >= this->loc_base && transfer->dst < this->loc_base + this->loc_size;
+
+    record.total_size = transfer->size * record.reps;
+    for (int dim=2; dim<transfer->nb_dims; dim++)
+    {
+        record.total_size *= transfer->reps_nd[dim - 2];
+    }
+
+    if (this->binary)
+    {
+        fwrite(&record, sizeof(record), 1, this->file);
+    }
+    else
+    {
+        int64_t duration = record.end_cycle - record.start_cycle;
+        fprintf(this->file, "%ld,0x%lx,0x%lx,%ld,%ld,%d,%ld,%ld,%ld,%ld,%ld,%ld,%f,%s,%s\n",
+            record.id, record.src, record.dst, record.size, record.total_size, record.nb_dims,
+            record.reps, record.src_stride, record.dst_stride, record.enqueue_cycle,
+            record.start_cycle, record.end_cycle,
+            duration > 0 ? (double)record.total_size / duration : 0.0,
+            record.src_is_loc ? "loc" : "ext", record.dst_is_loc ? "loc" : "ext");
+    }
+}
@@ -0,0 +1,119 @@
+/*
+ * Copyright (C) 2024 ETH Zurich and University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Authors: Germain Haugou, ETH Zurich (germain.haugou@iis.ee.ethz.ch)
+ */
+#pragma once
+
+#include <stdio.h>
+#include <vp/vp.hpp>
+#include "idma.hpp"
+
+
+
+/**
+ * @brief Transfer record
+ *
+ * This is the layout of each record in binary profiling files. All fields are little-endian
+ * and the record is packed.
+ */
+struct __attribute__((packed)) IdmaTransferRecord
+{
+    uint64_t id;
+    uint64_t src;
+    uint64_t dst;
+    // Size of each row
+    uint64_t size;
+    // Total number of bytes of the transfer, for all rows
+    uint64_t total_size;
+    uint64_t src_stride;
+    uint64_t dst_stride;
+    uint64_t reps;
+    int64_t enqueue_cycle;
+    int64_t start_cycle;
+    int64_t end_cycle;
+    uint8_t nb_dims;
+    // 1 if the source is in the local area, 0 otherwise
+    uint8_t src_is_loc;
+    // 1 if the destination is in the local area, 0 otherwise
+    uint8_t dst_is_loc;
+};
+
+
+
+/**
+ * @brief Transfer profiler
+ *
+ * This is used by front-ends to record every transfer and dump them to the file given by the
+ * top parameter profile_file, as CSV, or as binary records if the file name ends with .bin.
+ * The path of the iDMA component is inserted before the extension so that each iDMA of the system
+ * has its own file.
+ * Records are written as soon as transfers are done so that nothing is kept in memory.
+ * Nothing is done if no file is given.
+ */
+class IdmaProfiler
+{
+public:
+    /**
+     * @brief Construct a new profiler
+     *
+     * @param idma The top iDMA block.
+     * @param fe The front-end, used to get the current cycle.
+     */
+    IdmaProfiler(vp::Component *idma, vp::Block *fe);
+
+    /**
+     * @brief Destroy the profiler and close the file
+     */
+    ~IdmaProfiler();
+
+    /**
+     * @brief Notify that the front-end received a transfer
+     *
+     * @param transfer The transfer
+     * @param id The transfer ID
+     */
+    void transfer_enqueued(IdmaTransfer *transfer, uint64_t id);
+
+    /**
+     * @brief Notify that the middle-end accepted a transfer
+     *
+     * @param transfer The transfer
+     */
+    void transfer_started(IdmaTransfer *transfer);
+
+    /**
+     * @brief Notify that a transfer is done and record it
+     *
+     * @param transfer The transfer
+     */
+    void transfer_done(IdmaTransfer *transfer);
+
+private:
+    // Front-end, used to get the current cycle
+    vp::Block *fe;
+    // Trace for the profiler, used to report errors
+    vp::Trace trace;
+    // File where the records are dumped, NULL if profiling is disabled
+    FILE *file;
+    // True if records are dumped in binary format
+    bool binary;
+    // Base address of the local area
+    uint64_t loc_base;
+    // Size of the local area
+    uint64_t loc_size;
+};
@@ -18,6 +18,7 @@
  * Authors: Germain Haugou, ETH Zurich (germain.haugou@iis.ee.ethz.ch)
  */
 
+#include <algorithm>
 #include <vp/vp.hpp>
 #include "idma_me_2d.hpp"
 
@@ -35,6 +36,40 @@ IDmaMe2D::IDmaMe2D(vp::Component *idma, IdmaTransferProducer *fe, IdmaTransferCo
 
     // Get the top parameter giving the maximum number of enqueued transfers
     this->transfer_queue_size = idma->get_js_config()->get_int("transfer_queue_size");
+
+    // Preallocate row descriptors for the usual number of rows pending in the back-end
+    int burst_queue_size = idma->get_js_config()->get_int("burst_queue_size");
+    for (int i=0; i<burst_queue_size; i++)
+    {
+        this->rows.push_back(new IdmaTransfer());
+    }
+}
+
+
+
+IDmaMe2D::~IDmaMe2D()
+{
+    for (IdmaTransfer *row: this->rows)
+    {
+        delete row;
+    }
+}
+
+
+
+IdmaTransfer *IDmaMe2D::alloc_row()
+{
+    if (this->free_rows.size() == 0)
+    {
+        // All descriptors are pending, allocate a new one. It will be kept and reused afterwards.
+        IdmaTransfer *row = new IdmaTransfer();
+        this->rows.push_back(row);
+        return row;
+    }
+
+    IdmaTransfer *row = this->free_rows.back();
+    this->free_rows.pop_back();
+    return row;
 }
 
 
@@ -77,7 +112,8 @@ void IDmaMe2D::ack_transfer(IdmaTransfer *transfer)
         this->fe->ack_transfer(transfer->parent);
     }
 
-    delete transfer;
+    // The row descriptor can now be reused
+    this->free_rows.push_back(transfer);
 }
 
 
@@ -97,6 +133,9 @@ void IDmaMe2D::reset(bool active)
 
         // Clear current transfer
         this->current_transfer = NULL;
+
+        // Mark all row descriptors as free
+        this->free_rows = this->rows;
     }
 }
 
@@ -109,34 +148,26 @@ void IDmaMe2D::fsm_handler(vp::Block *__this, vp::ClockEvent *event)
     // Check if one of the queued transfer can become the current one
     if (_this->transfer_queue.size() > 0 && _this->current_transfer == NULL)
     {
-        // Extract transfer information to keep track of current burst
-        _this->current_transfer = _this->transfer_queue.front();
-        _this->current_src = _this->current_transfer->src;
-        _this->current_dst = _this->current_transfer->dst;
-        _this->current_reps = _this->current_transfer->reps;
-
-        // In case it is a 1D transfer, turn it into a 2D transfer to simplify control
-        if (((_this->current_transfer->config >> 1) & 1) == 0)
-        {
-            _this->current_reps = 1;
-        }
+        IdmaTransfer *transfer = _this->transfer_queue.front();
+        _this->current_transfer = transfer;
+
+        // Extract transfer information to keep track of current row
+        _this->current_row.init(transfer);
     }
 
-    // Check if we can extract a burst from the current transfer
+    // Check if we can extract a row from the current transfer
     if (_this->current_transfer != NULL && _this->be->can_accept_transfer())
     {
-        // Create a burst
-        IdmaTransfer *burst = new IdmaTransfer();
+        IdmaTransfer *row = _this->alloc_row();
 
-        // Extract one line from current transfer info
-        burst->parent = _this->current_transfer;
+        // Extract one row from current transfer info
+        row->parent = _this->current_transfer;
         _this->current_transfer->nb_bursts++;
-        burst->src = _this->current_src;
-        burst->dst = _this->current_dst;
-        burst->size = _this->current_transfer->size;
-        _this->current_reps--;
+        row->src = _this->current_row.get_src();
+        row->dst = _this->current_row.get_dst();
+        row->size = _this->current_transfer->size;
 
-        if (_this->current_reps == 0)
+        if (!_this->current_row.next())
         {
             // End of transfer, mark it as fully sent
             _this->current_transfer->bursts_sent = true;
@@ -148,17 +179,11 @@ void IDmaMe2D::fsm_handler(vp::Block *__this, vp::ClockEvent *event)
             // Update frontend in case it has a transfer to queue
             _this->fe->update();
         }
-        else
-        {
-            // Otherwise, switch to next line
-            _this->current_src += _this->current_transfer->src_stride;
-            _this->current_dst += _this->current_transfer->dst_stride;
-        }
 
-        // Enqueue line to backend
-        _this->be->enqueue_transfer(burst);
+        // Enqueue row to backend
+        _this->be->enqueue_transfer(row);
 
-        // And trigger again FSM for next line
+        // And trigger again FSM for next row
         _this->fsm_event.enqueue();
     }
 }
@@ -20,6 +20,8 @@
 
 #pragma once
 
+#include <queue>
+#include <vector>
 #include <vp/vp.hpp>
 #include "../idma.hpp"
 
@@ -28,7 +30,8 @@
 /**
  * @brief 2D middle-end
  *
- * This front-end can be used to get support for 2D transfers
+ * This middle-end can be used to get support for 2D transfers, as well as ND transfers up to
+ * IDMA_MAX_DIMS dimensions. Transfers are split into 1D rows which are pushed to the back-end.
  */
 class IDmaMe2D : public vp::Block, public IdmaTransferConsumer, public IdmaTransferProducer
 {
@@ -42,6 +45,11 @@ public:
      */
     IDmaMe2D(vp::Component *idma, IdmaTransferProducer *fe, IdmaTransferConsumer *be);
 
+    /**
+     * @brief Destroy a 2D middle-end
+     */
+    ~IDmaMe2D();
+
     void reset(bool active) override;
 
     bool can_accept_transfer() override;
@@ -53,6 +61,8 @@ public:
 private:
     // FSM handler, called to check if any action should be taken after something was updated
     static void fsm_handler(vp::Block *__this, vp::ClockEvent *event);
+    // Get a free row descriptor
+    IdmaTransfer *alloc_row();
 
     // Pointer to frontend
     IdmaTransferProducer *fe;
@@ -69,10 +79,11 @@ private:
     vp::ClockEvent fsm_event;
     // Current transfer being processed
     IdmaTransfer *current_transfer;
-    // Current source address of the current transfer, updated each time a burst is sent
-    uint64_t current_src;
-    // Current destination address of the current transfer, updated each time a burst is sent
-    uint64_t current_dst;
-    // Current replication of the current transfer, updated each time a burst is sent
-    uint64_t current_reps;
+    // Position of the current transfer, giving the next row to be sent
+    IdmaRowIterator current_row;
+    // All row descriptors. They are allocated once and reused to avoid allocating a descriptor
+    // for each row. More descriptors are allocated only if all of them are pending in the back-end.
+    std::vector<IdmaTransfer *> rows;
+    // Row descriptors which are not used
+    std::vector<IdmaTransfer *> free_rows;
 };
@@ -0,0 +1,231 @@
+/*
+ * Copyright (C) 2024 ETH Zurich and University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Authors: Germain Haugou, ETH Zurich (germain.haugou@iis.ee.ethz.ch)
+ */
+#include <algorithm>
+#include <vp/vp.hpp>
+#include "idma_me_ff.hpp"
+
+
+IDmaMeFf::IDmaMeFf(vp::Component *idma, IdmaTransferProducer *fe, IdmaTransferConsumer *me,
+    IDmaBe *be)
+:   Block(idma, "me_ff"),
+    fsm_event(this, &IDmaMeFf::fsm_handler)
+{
+    // Frontend, middle-end and backend will be used later for interaction
+    this->fe = fe;
+    this->me = me;
+    this->be = be;
+
+    // Declare our own trace so that we can individually activate traces
+    this->traces.new_trace("trace", &this->trace, vp::DEBUG);
+
+    // Declare the interface used to change the mode at runtime
+    this->fast_forward_itf.set_sync_meth(&IDmaMeFf::fast_forward_sync);
+    idma->new_slave_port("fast_forward", &this->fast_forward_itf, this);
+
+    // Get the top parameters giving the initial mode and the analytical latency
+    this->fast_forward_reset = idma->get_js_config()->get_child_bool("fast_forward");
+    this->ff_latency = idma->get_js_config()->get_int("ff_latency");
+    this->ff_bandwidth = idma->get_js_config()->get_int("ff_bandwidth");
+    if (this->ff_bandwidth == 0)
+    {
+        this->trace.fatal("Fast-forward bandwidth must not be 0\n");
+    }
+}
+
+
+
+void IDmaMeFf::fast_forward_sync(vp::Block *__this, bool active)
+{
+    IDmaMeFf *_this = (IDmaMeFf *)__this;
+
+    _this->trace.msg(vp::Trace::LEVEL_INFO, "Setting fast-forward mode (active: %d)\n", active);
+
+    _this->fast_forward = active;
+
+    // The front-end may have a transfer blocked which can now be accepted
+    _this->fe->update();
+}
+
+
+
+bool IDmaMeFf::can_accept_transfer()
+{
+    // Transfers of one mode are accepted only once the ones of the other mode are done, to keep
+    // them acknowledged in order
+    if (this->fast_forward)
+    {
+        return this->nb_timed_transfers == 0;
+    }
+    else
+    {
+        return this->copy_queue.empty() && this->ff_transfers.empty() &&
+            this->me->can_accept_transfer();
+    }
+}
+
+
+
+void IDmaMeFf::copy_transfers()
+{
+    // Rows are copied one after the other. When an access is answered asynchronously, the
+    // backend updates this stage once it is done, and the copy continues from there.
+    while (!this->copy_queue.empty() && !this->be->is_copy_pending())
+    {
+        IdmaTransfer *transfer = this->copy_queue.front();
+
+        if (this->copy_started)
+        {
+            // The previous row is copied, move to the next one
+            if (!this->copy_row.next())
+            {
+                this->copy_started = false;
+                this->copy_queue.pop();
+                this->copy_done(transfer, this->copy_size);
+                continue;
+            }
+        }
+        else
+        {
+            this->copy_row.init(transfer);
+            this->copy_started = true;
+            this->copy_size = 0;
+        }
+
+        this->be->copy(this->copy_row.get_src(), this->copy_row.get_dst(), transfer->size, this);
+        this->copy_size += transfer->size;
+    }
+}
+
+
+
+void IDmaMeFf::copy_done(IdmaTransfer *transfer, uint64_t size)
+{
+    // The transfer is acknowledged once the analytical latency has elapsed, counted from the
+    // end of the copy
+    int64_t cycles = this->clock.get_cycles();
+    int64_t start = std::max(cycles, this->ff_last_timestamp);
+    int64_t duration = this->ff_latency + (size + this->ff_bandwidth - 1) / this->ff_bandwidth;
+    this->ff_last_timestamp = start + duration;
+
+    this->trace.msg(vp::Trace::LEVEL_TRACE, "Fast-forwarded transfer (transfer: %p, size: 0x%lx, end_cycle: %ld)\n",
+        transfer, size, this->ff_last_timestamp);
+
+    this->ff_transfers.push(transfer);
+    this->ff_timestamps.push(this->ff_last_timestamp);
+
+    if (!this->fsm_event.is_enqueued())
+    {
+        this->fsm_event.enqueue(std::max(this->ff_last_timestamp - cycles, (int64_t)1));
+    }
+}
+
+
+
+void IDmaMeFf::enqueue_transfer(IdmaTransfer *transfer)
+{
+    if (!this->fast_forward)
+    {
+        // Timed mode, the 2D middle-end takes care of the transfer
+        this->nb_timed_transfers++;
+        this->me->enqueue_transfer(transfer);
+        return;
+    }
+
+    // Fast-forward mode, the data is copied now, or as soon as the previous copies are done
+    this->copy_queue.push(transfer);
+    this->copy_transfers();
+}
+
+
+
+void IDmaMeFf::fsm_handler(vp::Block *__this, vp::ClockEvent *event)
+{
+    IDmaMeFf *_this = (IDmaMeFf *)__this;
+    int64_t cycles = _this->clock.get_cycles();
+
+    // Acknowledge all transfers whose latency has elapsed
+    while (!_this->ff_transfers.empty() && _this->ff_timestamps.front() <= cycles)
+    {
+        IdmaTransfer *transfer = _this->ff_transfers.front();
+        _this->ff_transfers.pop();
+        _this->ff_timestamps.pop();
+        _this->fe->ack_transfer(transfer);
+    }
+
+    if (!_this->ff_transfers.empty())
+    {
+        _this->fsm_event.enqueue(_this->ff_timestamps.front() - cycles);
+    }
+    else if (_this->copy_queue.empty())
+    {
+        // The front-end may be waiting to switch back to timed mode
+        _this->fe->update();
+    }
+}
+
+
+
+void IDmaMeFf::update()
+{
+    // Either the 2D middle-end may accept a new transfer, or the backend finished a pending copy
+    this->copy_transfers();
+
+    // Forward to the front-end in case it has a transfer to push
+    this->fe->update();
+}
+
+
+
+void IDmaMeFf::ack_transfer(IdmaTransfer *transfer)
+{
+    this->nb_timed_transfers--;
+    this->fe->ack_transfer(transfer);
+
+    if (this->nb_timed_transfers == 0 && this->fast_forward)
+    {
+        // The front-end may be waiting to switch to fast-forward mode
+        this->fe->update();
+    }
+}
+
+
+
+void IDmaMeFf::reset(bool active)
+{
+    if (active)
+    {
+        this->fast_forward = this->fast_forward_reset;
+        this->nb_timed_transfers = 0;
+        this->ff_last_timestamp = 0;
+        this->copy_started = false;
+        while (!this->copy_queue.empty())
+        {
+            delete this->copy_queue.front();
+            this->copy_queue.pop();
+        }
+        while (!this->ff_transfers.empty())
+        {
+            // Each transfer needs to be freed since we are owning them
+            delete this->ff_transfers.front();
+            this->ff_transfers.pop();
+            this->ff_timestamps.pop();
+        }
+    }
+}
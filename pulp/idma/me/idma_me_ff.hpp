@@ -0,0 +1,112 @@
+/*
+ * Copyright (C) 2024 ETH Zurich and University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Authors: Germain Haugou, ETH Zurich (germain.haugou@iis.ee.ethz.ch)
+ */
+#pragma once
+
+#include <queue>
+#include <vector>
+#include <vp/vp.hpp>
+#include <vp/itf/wire.hpp>
+#include "../idma.hpp"
+#include "../be/idma_be.hpp"
+
+
+
+/**
+ * @brief Fast-forward middle-end
+ *
+ * This middle-end sits between the front-end and the 2D middle-end. In timed mode, it just
+ * forwards transfers to the 2D middle-end.
+ * In fast-forward mode, each transfer is copied row by row through direct accesses from the
+ * back-end, and is acknowledged after an analytical latency, given by a fixed overhead plus the
+ * transfer size divided by the bandwidth. Rows are copied immediately, unless the interconnect
+ * replies asynchronously, in which case the copy continues when the response is received.
+ * The mode can be changed at any time through the fast_forward wire interface. Transfers are
+ * always acknowledged in order, so when the mode changes, new transfers are accepted only once
+ * the transfers of the other mode are done.
+ */
+class IDmaMeFf : public vp::Block, public IdmaTransferConsumer, public IdmaTransferProducer
+{
+public:
+    /**
+     * @brief Construct a new fast-forward middle-end
+     *
+     * @param idma The top iDMA block.
+     * @param fe The front end.
+     * @param me The 2D middle end, used in timed mode.
+     * @param be The back end, used for direct accesses in fast-forward mode.
+     */
+    IDmaMeFf(vp::Component *idma, IdmaTransferProducer *fe, IdmaTransferConsumer *me, IDmaBe *be);
+
+    void reset(bool active) override;
+
+    bool can_accept_transfer() override;
+    void enqueue_transfer(IdmaTransfer *transfer) override;
+    void update() override;
+    void ack_transfer(IdmaTransfer *transfer) override;
+
+private:
+    // FSM handler, called to acknowledge fast-forward transfers once their latency has elapsed
+    static void fsm_handler(vp::Block *__this, vp::ClockEvent *event);
+    // Called when the fast-forward mode is changed
+    static void fast_forward_sync(vp::Block *__this, bool active);
+    // Copy the rows of the pending transfers through direct accesses, until one of the copies is
+    // waiting for an asynchronous response or all transfers are copied
+    void copy_transfers();
+    // Schedule the acknowledgement of a fast-forward transfer once it is fully copied
+    void copy_done(IdmaTransfer *transfer, uint64_t size);
+
+    // Pointer to frontend
+    IdmaTransferProducer *fe;
+    // Pointer to the 2D middle-end
+    IdmaTransferConsumer *me;
+    // Pointer to backend
+    IDmaBe *be;
+    // Trace for this block, messages will be displayed with this block's name
+    vp::Trace trace;
+    // Block FSM event, used to acknowledge fast-forward transfers
+    vp::ClockEvent fsm_event;
+    // Interface for changing the mode at runtime
+    vp::WireSlave<bool> fast_forward_itf;
+    // Top parameter giving the mode at reset
+    bool fast_forward_reset;
+    // Current mode, true if transfers are fast-forwarded
+    bool fast_forward;
+    // Top parameter giving the fixed latency of fast-forward transfers, in cycles
+    int64_t ff_latency;
+    // Top parameter giving the bandwidth of fast-forward transfers, in bytes per cycle
+    uint64_t ff_bandwidth;
+    // Number of transfers forwarded to the 2D middle-end and not yet acknowledged
+    int nb_timed_transfers;
+    // Fast-forward transfers waiting to be copied, in order. The first one is being copied.
+    std::queue<IdmaTransfer *> copy_queue;
+    // Current row of the transfer being copied
+    IdmaRowIterator copy_row;
+    // True if the copy of the first transfer of the queue has started
+    bool copy_started;
+    // Number of bytes copied for the transfer being copied
+    uint64_t copy_size;
+    // Fast-forward transfers waiting for their latency to elapse, in order
+    std::queue<IdmaTransfer *> ff_transfers;
+    // Cycle at which each fast-forward transfer can be acknowledged, in the same order
+    std::queue<int64_t> ff_timestamps;
+    // Cycle at which the last fast-forward transfer is done. Transfers are processed one after
+    // the other so that the bandwidth is shared
+    int64_t ff_last_timestamp;
+};
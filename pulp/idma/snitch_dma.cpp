@@ -21,6 +21,7 @@
 #include <vp/vp.hpp>
 #include "fe/idma_fe_xdma.hpp"
 #include "me/idma_me_2d.hpp"
+#include "me/idma_me_ff.hpp"
 #include "be/idma_be.hpp"
 #include "be/idma_be_axi.hpp"
 #include "be/idma_be_tcdm.hpp"
@@ -32,6 +33,7 @@
  *
  * This puts together:
  *   - Xdma front-end to handle xdma custom instructions from snitch core
+ *   - Fast-forward middle end to optionally do transfers functionally with an analytical latency
  *   - 2D middle end to add support for 2D transfers
  *   - AXI and TCDM backend protocols to interact with external AXI interconnect and local
  *   TCDM memory
@@ -43,6 +45,7 @@ public:
 
 private:
     IDmaFeXdma fe;
+    IDmaMeFf me_ff;
     IDmaMe2D me;
     IDmaBeAxi be_axi_read;
     IDmaBeAxi be_axi_write;
@@ -55,8 +58,9 @@ private:
 
 SnitchDma::SnitchDma(vp::ComponentConf &config)
     : vp::Component(config),
-    fe(this, &this->me),
-    me(this, &this->fe, &this->be),
+    fe(this, &this->me_ff),
+    me_ff(this, &this->fe, &this->me, &this->be),
+    me(this, &this->me_ff, &this->be),
     be_axi_read(this, "axi_read", &this->be), be_axi_write(this, "axi_write", &this->be),
     be_tcdm_read(this, "tcdm_read", &this->be), be_tcdm_write(this, "tcdm_write", &this->be),
     be(this, &this->me, &this->be_tcdm_read, &this->be_tcdm_write,
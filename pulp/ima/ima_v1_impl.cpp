@@ -22,6 +22,8 @@
 #include <vp/itf/io.hpp>
 #include <stdio.h>
 #include <string.h>
+#include <math.h>
+#include <float.h>
 #include <archi/ima/ima_v1.h>
 #include "ima_v1_impl.hpp"
 
@@ -66,11 +68,7 @@ ima_v1::ima_v1(vp::ComponentConf &config)
   this->buffer_in = new int8_t[this->xbar_y];
   this->buffer_out = new int8_t[this->xbar_x];
 
-  this->crossbar = new int8_t*[this->xbar_y];
-  for(int i=0; i<this->xbar_y; i++)
-  {
-    this->crossbar[i] = new int8_t[this->xbar_x];
-  }
+  this->crossbar = new int8_t[this->xbar_x * this->xbar_y];
 
   this->job = new ima_job_t;
   this->pw_req = new ima_pw_t;
@@ -88,15 +86,10 @@ void ima_v1::reset(bool active)
     memset(this->buffer_out, 0, sizeof(int8_t)*this->xbar_x);
     memset(this->regs, 0, sizeof(unsigned int)*IMA_NB_REGS);
 
-    for(int j=0; j<this->xbar_y; j++)
+    memset(this->crossbar, 0, sizeof(int8_t)*this->xbar_x*this->xbar_y);
+    for(int j=0; j<this->xbar_y && j<this->xbar_x; j++)
     {
-      for(int i=0; i<this->xbar_x; i++)
-      {
-        if(i == j)
-          this->crossbar[j][i] = 1;
-        else
-          this->crossbar[j][i] = 0;
-      }
+      this->crossbar_cell(j, j) = 1;
     }
 
     /* Event cycles depend on analog time to perform the specific task and on the cluster frequency */
@@ -740,25 +733,58 @@ int8_t ima_v1::adc_clipping(float value)
 }
 
 
-/* Matrix-Vector Multiplication (MVM) */
+/* Reference single-precision accumulation of one column, as done by the original model */
+float ima_v1::exec_column_ref(int8_t *in, int8_t *column, int height)
+{
+  float sum = 0;
+
+  for(int j=0; j<height; j++)
+  {
+    sum += ((float) in[j] / ((1 << (DAC_PRECISION - 1)) - 1)) * ((float) column[j]) / ((1 << (STOR_DWIDTH - 1)) - 1);
+  }
+
+  return sum;
+}
+
+
+/* Matrix-Vector Multiplication (MVM)
+ * Each column is computed as an exact int8 dot product (contiguous, so the compiler vectorises it) followed by
+ * a single scale. The reference accumulation rounds every term in single precision, so its sum can only differ
+ * from the exact one by (height + 3) roundings of the sum of magnitudes. The ADC transfer function is monotonic,
+ * so if both ends of this interval give the same code, it is the reference one. Otherwise the value sits on a
+ * decision boundary and the reference accumulation is replayed to stay bit-identical. */
 void ima_v1::exec_job()
 {
+  const double scale = 1.0 / ((double) ((1 << (DAC_PRECISION - 1)) - 1) * ((1 << (STOR_DWIDTH - 1)) - 1));
+  const bool monotonic = this->job->adc_high + this->job->adc_low > 0;
+  int8_t *in = &this->buffer_in[this->job->start_y];
+  int height = this->job->height;
+
   for(int i=0; i<this->job->width; i++)
   {
-    float sum = 0;
+    int8_t *column = &this->crossbar_cell(this->job->start_y, this->job->start_x + i);
+    int32_t acc = 0;
+    int32_t acc_abs = 0;
 
-    for(int j=0; j<this->job->height; j++)
+    for(int j=0; j<height; j++)
     {
-      sum += ((float) this->buffer_in[this->job->start_y + j] / ((1 << (DAC_PRECISION - 1)) - 1)) * ((float) this->crossbar[this->job->start_y + j][this->job->start_x + i]) / ((1 << (STOR_DWIDTH - 1)) - 1);
-      //sum += this->buffer_in[this->job->start_y + j] * this->crossbar[this->job->start_y + j][this->job->start_x + i];
-      //printf("in=%d, scaled_in=%f, cb=%d, scaled_cb=%f, sum=%f, scaled_sum=%f, ind_x=%d, ind_y=%d\n", this->buffer_in[this->job->start_y + j], \
-              (float) this->buffer_in[this->job->start_y + j] / ((1 << (DAC_PRECISION - 1)) - 1), \
-              this->crossbar[this->job->start_y + j][this->job->start_x + i], \
-              (float) this->crossbar[this->job->start_y + j][this->job->start_x + i] / ((1 << (STOR_DWIDTH - 1)) - 1), \
-              sum, (float) this->adc_clipping(sum), this->job->start_x + i, this->job->start_y + j);
+      int32_t prod = (int32_t) in[j] * column[j];
+      acc += prod;
+      acc_abs += prod >= 0 ? prod : -prod;
     }
-    this->buffer_out[this->job->start_x + i] = this->adc_clipping(sum);
-    //this->buffer_out[this->job->start_x + i] = sum;
+
+    double exact = acc * scale;
+    double error = (height + 4) * (double) FLT_EPSILON * acc_abs * scale;
+    float sum = (float) exact;
+    int8_t out = this->adc_clipping(nextafterf((float) (exact - error), -INFINITY));
+
+    if(!monotonic || out != this->adc_clipping(nextafterf((float) (exact + error), INFINITY)))
+    {
+      sum = this->exec_column_ref(in, column, height);
+      out = this->adc_clipping(sum);
+    }
+
+    this->buffer_out[this->job->start_x + i] = out;
     this->trace.msg("Written in output buffer at index %d (sum: %f, out: %x)\n", this->job->start_x + i, sum, this->buffer_out[this->job->start_x + i]);
   }
 
@@ -771,14 +797,14 @@ void ima_v1::exec_write_plot()
   ima_pw_t *plot = pw_req;
 
   /* Crossbar values are 4-bit signed in range [-7, 7] */
-  this->crossbar[plot->index_y][plot->index_x + 0] = (int8_t) (((((plot->pending_plot & 0x0000000F) >> 0)  & 0x8) == 0x8) ? (((plot->pending_plot & 0x0000000F) >> 0)  | 0xF0) : (((plot->pending_plot & 0x0000000F) >> 0)));
-  this->crossbar[plot->index_y][plot->index_x + 1] = (int8_t) (((((plot->pending_plot & 0x000000F0) >> 4)  & 0x8) == 0x8) ? (((plot->pending_plot & 0x000000F0) >> 4)  | 0xF0) : (((plot->pending_plot & 0x000000F0) >> 4)));
-  this->crossbar[plot->index_y][plot->index_x + 2] = (int8_t) (((((plot->pending_plot & 0x00000F00) >> 8)  & 0x8) == 0x8) ? (((plot->pending_plot & 0x00000F00) >> 8)  | 0xF0) : (((plot->pending_plot & 0x00000F00) >> 8)));
-  this->crossbar[plot->index_y][plot->index_x + 3] = (int8_t) (((((plot->pending_plot & 0x0000F000) >> 12) & 0x8) == 0x8) ? (((plot->pending_plot & 0x0000F000) >> 12) | 0xF0) : (((plot->pending_plot & 0x0000F000) >> 12)));
-  this->crossbar[plot->index_y][plot->index_x + 4] = (int8_t) (((((plot->pending_plot & 0x000F0000) >> 16) & 0x8) == 0x8) ? (((plot->pending_plot & 0x000F0000) >> 16) | 0xF0) : (((plot->pending_plot & 0x000F0000) >> 16)));
-  this->crossbar[plot->index_y][plot->index_x + 5] = (int8_t) (((((plot->pending_plot & 0x00F00000) >> 20) & 0x8) == 0x8) ? (((plot->pending_plot & 0x00F00000) >> 20) | 0xF0) : (((plot->pending_plot & 0x00F00000) >> 20)));
-  this->crossbar[plot->index_y][plot->index_x + 6] = (int8_t) (((((plot->pending_plot & 0x0F000000) >> 24) & 0x8) == 0x8) ? (((plot->pending_plot & 0x0F000000) >> 24) | 0xF0) : (((plot->pending_plot & 0x0F000000) >> 24)));
-  this->crossbar[plot->index_y][plot->index_x + 7] = (int8_t) (((((plot->pending_plot & 0xF0000000) >> 28) & 0x8) == 0x8) ? (((plot->pending_plot & 0xF0000000) >> 28) | 0xF0) : (((plot->pending_plot & 0xF0000000) >> 28)));
+  this->crossbar_cell(plot->index_y, plot->index_x + 0) = (int8_t) (((((plot->pending_plot & 0x0000000F) >> 0)  & 0x8) == 0x8) ? (((plot->pending_plot & 0x0000000F) >> 0)  | 0xF0) : (((plot->pending_plot & 0x0000000F) >> 0)));
+  this->crossbar_cell(plot->index_y, plot->index_x + 1) = (int8_t) (((((plot->pending_plot & 0x000000F0) >> 4)  & 0x8) == 0x8) ? (((plot->pending_plot & 0x000000F0) >> 4)  | 0xF0) : (((plot->pending_plot & 0x000000F0) >> 4)));
+  this->crossbar_cell(plot->index_y, plot->index_x + 2) = (int8_t) (((((plot->pending_plot & 0x00000F00) >> 8)  & 0x8) == 0x8) ? (((plot->pending_plot & 0x00000F00) >> 8)  | 0xF0) : (((plot->pending_plot & 0x00000F00) >> 8)));
+  this->crossbar_cell(plot->index_y, plot->index_x + 3) = (int8_t) (((((plot->pending_plot & 0x0000F000) >> 12) & 0x8) == 0x8) ? (((plot->pending_plot & 0x0000F000) >> 12) | 0xF0) : (((plot->pending_plot & 0x0000F000) >> 12)));
+  this->crossbar_cell(plot->index_y, plot->index_x + 4) = (int8_t) (((((plot->pending_plot & 0x000F0000) >> 16) & 0x8) == 0x8) ? (((plot->pending_plot & 0x000F0000) >> 16) | 0xF0) : (((plot->pending_plot & 0x000F0000) >> 16)));
+  this->crossbar_cell(plot->index_y, plot->index_x + 5) = (int8_t) (((((plot->pending_plot & 0x00F00000) >> 20) & 0x8) == 0x8) ? (((plot->pending_plot & 0x00F00000) >> 20) | 0xF0) : (((plot->pending_plot & 0x00F00000) >> 20)));
+  this->crossbar_cell(plot->index_y, plot->index_x + 6) = (int8_t) (((((plot->pending_plot & 0x0F000000) >> 24) & 0x8) == 0x8) ? (((plot->pending_plot & 0x0F000000) >> 24) | 0xF0) : (((plot->pending_plot & 0x0F000000) >> 24)));
+  this->crossbar_cell(plot->index_y, plot->index_x + 7) = (int8_t) (((((plot->pending_plot & 0xF0000000) >> 28) & 0x8) == 0x8) ? (((plot->pending_plot & 0xF0000000) >> 28) | 0xF0) : (((plot->pending_plot & 0xF0000000) >> 28)));
 
   this->trace.msg("Written in crossbar starting from row: %d and column: %d\n", plot->index_x, plot->index_y);
 }
@@ -788,14 +814,14 @@ void ima_v1::exec_read_plot()
 {
   ima_pr_t *plot = pr_req;
 
-  plot->pending_plot = ((this->crossbar[plot->addr_y][plot->addr_x + 0] & 0x0000000F) << 0)   |     \
-                       ((this->crossbar[plot->addr_y][plot->addr_x + 1] & 0x0000000F) << 4)   |     \
-                       ((this->crossbar[plot->addr_y][plot->addr_x + 2] & 0x0000000F) << 8)   |     \
-                       ((this->crossbar[plot->addr_y][plot->addr_x + 3] & 0x0000000F) << 12)  |     \
-                       ((this->crossbar[plot->addr_y][plot->addr_x + 4] & 0x0000000F) << 16)  |     \
-                       ((this->crossbar[plot->addr_y][plot->addr_x + 5] & 0x0000000F) << 20)  |     \
-                       ((this->crossbar[plot->addr_y][plot->addr_x + 6] & 0x0000000F) << 24)  |     \
-                       ((this->crossbar[plot->addr_y][plot->addr_x + 7] & 0x0000000F) << 28);
+  plot->pending_plot = ((this->crossbar_cell(plot->addr_y, plot->addr_x + 0) & 0x0000000F) << 0)   |     \
+                       ((this->crossbar_cell(plot->addr_y, plot->addr_x + 1) & 0x0000000F) << 4)   |     \
+                       ((this->crossbar_cell(plot->addr_y, plot->addr_x + 2) & 0x0000000F) << 8)   |     \
+                       ((this->crossbar_cell(plot->addr_y, plot->addr_x + 3) & 0x0000000F) << 12)  |     \
+                       ((this->crossbar_cell(plot->addr_y, plot->addr_x + 4) & 0x0000000F) << 16)  |     \
+                       ((this->crossbar_cell(plot->addr_y, plot->addr_x + 5) & 0x0000000F) << 20)  |     \
+                       ((this->crossbar_cell(plot->addr_y, plot->addr_x + 6) & 0x0000000F) << 24)  |     \
+                       ((this->crossbar_cell(plot->addr_y, plot->addr_x + 7) & 0x0000000F) << 28);
 
   this->trace.msg("Read in crossbar starting from row: %d and column: %d (read %x)\n", plot->index_x, plot->index_y, plot->pending_plot);
 }
@@ -159,6 +159,7 @@ private:
   void exec_write_plot();
   void exec_read_plot();
   void exec_job();
+  float exec_column_ref(int8_t *in, int8_t *column, int height);
   int8_t adc_clipping(float value);
 
   void job_update();
@@ -169,7 +170,9 @@ private:
   unsigned int *regs;
   int8_t *buffer_in;
   int8_t *buffer_out;
-  int8_t **crossbar;
+  /* Stored transposed: the cells of a column are contiguous so that a MVM walks them linearly */
+  int8_t *crossbar;
+  inline int8_t &crossbar_cell(int y, int x) { return this->crossbar[x * this->xbar_y + y]; }
 
   ima_job_t *job;
   int remaining_jobs;
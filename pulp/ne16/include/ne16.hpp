@@ -39,6 +39,7 @@
 #include "xtensor/xadapt.hpp"
 #include "xtensor/xvectorize.hpp"
 #include "xtensor/xpad.hpp"
+#include "ne16_binconv.hpp"
 
 #define NE16_REG_WEIGHTS_PTR       0
 #define NE16_REG_INFEAT_PTR        1
@@ -160,6 +161,7 @@ class Ne16VectorLoad : public Ne16StreamAccess {
     );
     Ne16VectorLoad();
     xt::xarray<T> ex(int width, int64_t& cycles);
+    void ex(int width, int64_t& cycles, T *data);
     void foo();
 };
 
@@ -374,8 +376,8 @@ private:
     bool matrixvec_to_load_idx();
     bool matrixvec_to_matrixvec_idx();
     // internal functions
-    void __BinConvArray(xt::xarray<uint8_t>&, int, int, xt::xarray<int32_t>, xt::xarray<int32_t>, xt::xarray<int32_t>, bool=false, bool=false, bool=false, bool=false, bool=false);
-    void __weightoffs(int, xt::xarray<int32_t>, xt::xarray<int32_t>);
+    void __BinConvArray(uint8_t [NE16_WEIGHT_ROWS][NE16_BLOCK_SIZE], int, int, int32_t [NE16_NR_COLUMN][NE16_COLUMN_SIZE], const xt::xarray<int32_t>&, const xt::xarray<int32_t>&, bool=false, bool=false, bool=false, bool=false, bool=false);
+    void __weightoffs(int, const xt::xarray<int32_t>&, const xt::xarray<int32_t>&);
     
     // NORMQUANT
     void normquant_shift_setup();
@@ -0,0 +1,122 @@
+/*
+ * Copyright (C) 2024 ETH Zurich and University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __NE16_BINCONV_HPP__
+#define __NE16_BINCONV_HPP__
+
+// Datapath of the BinConv array. It does not depend on the rest of the model so that it can be
+// checked on the host against the original xtensor implementation, see test/binconv_check.cpp.
+
+#include <stdint.h>
+
+// Datapath dimensions, used to size the fixed buffers of the BinConv array
+#define NE16_TP_IN        16
+#define NE16_NR_COLUMN    9
+#define NE16_COLUMN_SIZE  9
+#define NE16_BLOCK_SIZE   16
+// Unpacked weight rows: 16-bit linear mode reads 16 words, i.e. 32 bytes
+#define NE16_WEIGHT_ROWS  32
+
+// Unpacks the weight stream into one bit per byte. A row holds the 16 bits of a weight word,
+// or in 16-bit mode the 8 bits of a single byte, repeated twice. Returns the number of rows.
+static inline int __WeightUnpack(
+  const uint8_t *w,
+  int            size,
+  bool           mode16,
+  uint8_t        wu[NE16_WEIGHT_ROWS][NE16_BLOCK_SIZE]
+) {
+  if(mode16) {
+    for(auto r=0; r<size*2; r++) {
+      for(auto t=0; t<NE16_BLOCK_SIZE; t++) {
+        wu[r][t] = (w[r] >> (t & 0x7)) & 0x1;
+      }
+    }
+    return size*2;
+  }
+  for(auto r=0; r<size; r++) {
+    uint32_t word = w[r*2] | (w[r*2+1] << 8);
+    for(auto t=0; t<NE16_BLOCK_SIZE; t++) {
+      wu[r][t] = (word >> t) & 0x1;
+    }
+  }
+  return size;
+}
+
+// In 16-bit linear mode, only the blocks fed with one of the load_fbuf_lim input channels are enabled
+static inline void __BlockEnableLinear(
+  bool    mode16,
+  bool    mode_linear,
+  int     load_fbuf_lim,
+  int32_t block_enable_linear[NE16_NR_COLUMN][NE16_COLUMN_SIZE]
+) {
+  for(auto rr=0; rr<NE16_NR_COLUMN; rr++) {
+    for(auto cc=0; cc<NE16_COLUMN_SIZE; cc++) {
+      if(mode16 && mode_linear) {
+        auto i_kin_16bit = (cc<8 && rr<4) ? rr*8+cc : -1;
+        block_enable_linear[rr][cc] = (i_kin_16bit != -1 && i_kin_16bit < load_fbuf_lim) ? 1 : 0;
+      }
+      else {
+        block_enable_linear[rr][cc] = 1;
+      }
+    }
+  }
+}
+
+// Selects the weight bits seen by the block of column c and row r, masked by the MAC enables
+static inline void __BinConvWeight(
+  uint8_t        weight[NE16_WEIGHT_ROWS][NE16_BLOCK_SIZE],
+  int            c,
+  int            r,
+  const int32_t *mac_enable,
+  int32_t        block_enable_linear[NE16_NR_COLUMN][NE16_COLUMN_SIZE],
+  bool           mode16,
+  bool           mode_linear,
+  int32_t        w[NE16_BLOCK_SIZE]
+) {
+  if (!mode_linear) {
+    for(auto t=0; t<NE16_BLOCK_SIZE; t++) {
+      w[t] = weight[r][t] * mac_enable[t];
+    }
+    return;
+  }
+  // each column only sees its own group of 8 weight rows, the other rows are zero
+  auto lin_row = c*8 + r;
+  auto lin_valid = r < 8 && (c < 2 || (c < 4 && mode16));
+  for(auto t=0; t<NE16_BLOCK_SIZE; t++) {
+    w[t] = lin_valid ? weight[lin_row][t] * mac_enable[t] * block_enable_linear[c][r] : 0;
+  }
+}
+
+static inline int64_t __BinConvBlock(
+  const int32_t *w,
+  const uint8_t *x,
+  int scale=0,
+  bool mode16=false
+) {
+  int64_t sum = 0;
+  if(mode16) {
+    for(auto t=0; t<8; t++) {
+      sum += (int64_t) w[t] * x[t*2+1] * 256 + (int64_t) w[t] * x[t*2];
+    }
+    return sum * scale;
+  }
+  for(auto t=0; t<NE16_BLOCK_SIZE; t++) {
+    sum += (int64_t) w[t] * x[t];
+  }
+  return sum * scale;
+}
+
+#endif /* __NE16_BINCONV_HPP__ */
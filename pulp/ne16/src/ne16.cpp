@@ -27,13 +27,13 @@ Ne16::Ne16(vp::ComponentConf &config)
     : vp::Component(config)
 {
     // FIXME these parameters might be settable through config, later...
-    this->TP_IN           = 16;
+    this->TP_IN           = NE16_TP_IN;
     this->TP_OUT          = 32;
     this->QA_IN           = 8;
     this->QA_OUT          = 8;
-    this->NR_COLUMN       = 9;
-    this->COLUMN_SIZE     = 9;
-    this->BLOCK_SIZE      = 16;
+    this->NR_COLUMN       = NE16_NR_COLUMN;
+    this->COLUMN_SIZE     = NE16_COLUMN_SIZE;
+    this->BLOCK_SIZE      = NE16_BLOCK_SIZE;
     this->F_BUFFER_SIZE   = 5;
     this->FILTER_SIZE     = 3;
     this->SHIFT_CYCLES    = 2;
@@ -18,125 +18,67 @@
  * Authors: Francesco Conti, University of Bologna & GreenWaves Technologies (f.conti@unibo.it)
  */
 
+#include <cstring>
 #include <ne16.hpp>
 
-// as the internal max precision of NE16 is 32 bits, this is emulated by casting x to 32 bits here
-xt::xarray<int64_t> __NormQuant(
-  xt::xarray<int64_t> x,
-  xt::xarray<int32_t> kappa_bn,
-  xt::xarray<int32_t> lambda_bn,
-  int32_t shift_reqnt,
-  int clip_min,
-  int clip_max,
-  bool use_rounding,
-  bool use_clip,
-  bool use_cast
-) {
-  if(use_clip) {
-    if(use_cast)
-      return xt::clip((xt::cast<int32_t>(x) * kappa_bn + lambda_bn + (use_rounding ? 1<<(shift_reqnt-1) : 0)) >> shift_reqnt, clip_min, clip_max);
-    else
-      return xt::clip((x * kappa_bn + lambda_bn + (use_rounding ? 1<<(shift_reqnt-1) : 0)) >> shift_reqnt, clip_min, clip_max);
-  }
-  else
-    return (xt::cast<int32_t>(x) * kappa_bn + lambda_bn + (use_rounding ? 1<<(shift_reqnt-1) : 0)) >> shift_reqnt;
-}
-
-xt::xarray<uint8_t> __WeightUnpack(
-  xt::xarray<uint8_t> w,
-  int                 size,
-  bool                mode16
-) {
-  w = w.reshape({size,2,1});
-  xt::xarray<uint8_t> wu = xt::zeros<uint8_t>({size,2,8});
-  xt::view(wu, xt::all(), xt::all()) = xt::view(w, xt::all(), xt::all());
-  wu = (wu >> xt::linspace(0, 7, 8).reshape({1, 1, 8})) & 0x1;
-  if(mode16) {
-    return xt::hstack(xt::xtuple(wu.reshape({size*2, 8}), wu.reshape({size*2, 8})));
-  }
-  return wu.reshape({size, 2*8});
-}
-
-xt::xarray<int64_t> __BinConvBlock(
-  xt::xarray<uint8_t> w,
-  xt::xarray<uint8_t> x,
-  int scale=0,
-  bool mode16=false
-) {
-  if(mode16) {
-    
-    xt::xarray<int64_t> wx_lo = xt::view(w, xt::range(0, 8)) * xt::view(x, xt::range(0, 16, 2)); // FIXME size
-    xt::xarray<int64_t> wx_hi = xt::view(w, xt::range(0, 8)) * xt::view(x, xt::range(1, 17, 2)); // FIXME size
-    auto wx = wx_hi * 256 + wx_lo;
-    return xt::sum(wx, 0) * scale;
-  }
-  return xt::sum(w * x, 0) * scale;
-}
-
 void Ne16::__BinConvArray(
-  xt::xarray<uint8_t>& weight,
-  int                  scale,
-  int                  idx,
-  xt::xarray<int32_t>  block_enable_linear,
-  xt::xarray<int32_t>  row_enable,
-  xt::xarray<int32_t>  mac_enable,
-  bool                 weight_shift,
-  bool                 weight_invert,
-  bool                 use_row_as_scale,
-  bool                 mode16,
-  bool                 mode_linear
+  uint8_t                    weight[NE16_WEIGHT_ROWS][NE16_BLOCK_SIZE],
+  int                        scale,
+  int                        idx,
+  int32_t                    block_enable_linear[NE16_NR_COLUMN][NE16_COLUMN_SIZE],
+  const xt::xarray<int32_t>& row_enable,
+  const xt::xarray<int32_t>& mac_enable,
+  bool                       weight_shift,
+  bool                       weight_invert,
+  bool                       use_row_as_scale,
+  bool                       mode16,
+  bool                       mode_linear
 ) {
+  int32_t w[NE16_BLOCK_SIZE];
   for(auto c=0; c<this->NR_COLUMN; c++) { // spatial loop - over columns
-    xt::view(this->psum_column, c) = 0;
+    this->psum_column(c) = 0;
     for(auto r=0; r<this->COLUMN_SIZE; r++) { // spatial loop - over blocks in a column
       if(row_enable(r) == 0) // row disabling to implement filter masks
         continue;
       auto scale_loc = use_row_as_scale ? 1 << r : scale;
-      auto activ = xt::view(this->x_array, c, r, xt::all()); // 16x channels of 8-bit
+      const uint8_t *activ = &this->x_array(c, r, 0); // 16x channels of 8-bit
+      __BinConvWeight(weight, c, r, mac_enable.data(), block_enable_linear, mode16, mode_linear, w);
+      int64_t psum = __BinConvBlock(w, activ, scale_loc, mode16);
       if(this->binconv_traces) {
+        std::vector<int32_t> weight_v(weight[r], weight[r] + NE16_BLOCK_SIZE);
+        std::vector<int32_t> mac_v(mac_enable.begin(), mac_enable.end());
+        std::vector<uint8_t> activ_v(activ, activ + NE16_BLOCK_SIZE);
+        auto weight_masked = xt::adapt(weight_v) * xt::adapt(mac_v);
         std::ostringstream stringStream;
-        stringStream << "binconv: weight=" << xt::view(weight, r)*mac_enable << "activ=" << activ << " scale=" << scale_loc << " ==> " << xt::view(weight, r)*mac_enable * activ << " ==> " << std::hex << xt::sum(xt::view(weight, r)*mac_enable*activ, 0)*scale << std::dec << "\n";
+        stringStream << "binconv: weight=" << weight_masked << "activ=" << xt::adapt(activ_v) << " scale=" << scale_loc << " ==> " << weight_masked * xt::adapt(activ_v) << " ==> " << std::hex << xt::sum(weight_masked*xt::adapt(activ_v), 0)*scale << std::dec << "\n";
         std::string copyOfStr = stringStream.str();
         this->trace.msg(vp::Trace::LEVEL_DEBUG, copyOfStr.c_str());
       }
-      if (!mode_linear) {
-        xt::view(this->psum_block, c, r) = __BinConvBlock(xt::view(weight, r) * mac_enable, activ, scale_loc, mode16);
-      }
-      else {
-        xt::xarray<uint8_t> weight_lin = xt::zeros_like(weight);
-        if(c==0) {
-          xt::view(weight_lin, xt::range(0, 8)) = xt::view(weight, xt::range(0, 8));
-        }
-        else if(c==1){
-          xt::view(weight_lin, xt::range(0, 8)) = xt::view(weight, xt::range(8, 16));
-        }
-        else if(c==2 && mode16){
-          xt::view(weight_lin, xt::range(0, 8)) = xt::view(weight, xt::range(16, 24));
-        }
-        else if(c==3 && mode16){
-          xt::view(weight_lin, xt::range(0, 8)) = xt::view(weight, xt::range(24, 32));
-        }
-        xt::view(this->psum_block, c, r) = __BinConvBlock(xt::view(weight_lin, r) * mac_enable * xt::view(block_enable_linear, c, r), activ, scale_loc, mode16);
-      }
       if(weight_shift && weight_invert) {
-        xt::view(this->psum_block, c, r) = -xt::view(this->psum_block, c, r);
+        psum = -psum;
       }
-      xt::view(this->psum_column, c) += xt::view(this->psum_block, c, r);
+      this->psum_block(c, r) = psum;
+      this->psum_column(c) += psum;
     }
     if(!mode_linear) {
       if(weight_shift) {
-        xt::view(this->accum, xt::all(), c) += xt::view(this->psum_column, c);
+        for(auto k=0; k<this->TP_OUT; k++) {
+          this->accum(k, c) += this->psum_column(c);
+        }
       }
       else {
-        xt::view(this->accum, idx, c) += xt::view(this->psum_column, c);
+        this->accum(idx, c) += this->psum_column(c);
       }
     }
     else if(c==3) {
+      auto psum_linear = this->psum_column(0) + this->psum_column(1) + this->psum_column(2) + this->psum_column(3);
       if(weight_shift) {
-        xt::view(this->accum, xt::all(), 0) += xt::view(this->psum_column, 0) + xt::view(this->psum_column, 1) + xt::view(this->psum_column, 2) + xt::view(this->psum_column, 3);
+        for(auto k=0; k<this->TP_OUT; k++) {
+          this->accum(k, 0) += psum_linear;
+        }
       }
       else {
-        xt::view(this->accum, idx, 0) += xt::view(this->psum_column, 0) + xt::view(this->psum_column, 1) + xt::view(this->psum_column, 2) + xt::view(this->psum_column, 3);
+        this->accum(idx, 0) += psum_linear;
       }
     }
   }
@@ -144,35 +86,29 @@ void Ne16::__BinConvArray(
 
 void Ne16::__weightoffs(
   int dw_iter,
-  xt::xarray<int32_t> row_enable,
-  xt::xarray<int32_t> mac_enable
+  const xt::xarray<int32_t>& row_enable,
+  const xt::xarray<int32_t>& mac_enable
 ) {
+  uint8_t weight_ld[NE16_WEIGHT_ROWS*2];
+  uint8_t weight[NE16_WEIGHT_ROWS][NE16_BLOCK_SIZE];
+  int32_t block_enable_linear[NE16_NR_COLUMN][NE16_COLUMN_SIZE];
+
+  __BlockEnableLinear(this->mode16, this->mode_linear, this->load_fbuf_lim, block_enable_linear);
+
   auto start_s = 1;
   for(auto s=start_s; s<this->SHIFT_CYCLES; s++) { // temporal loop - fake weight for Wmin offsetting // FIXME: how to properly do this in 1x1 mode?
 
     // fake-load and unpack weight bits
     auto read_size = (this->mode_linear) ? (this->mode16 ? 32 : 16) : this->FILTER_SIZE*this->FILTER_SIZE;
-    xt::xarray<uint8_t> weight_ld = xt::zeros<uint8_t>({read_size, 2});
+    memset(weight_ld, 0, read_size*2);
     if(this->fs == 3 || this->mode_linear)
-      xt::view(weight_ld, xt::all()) = 0xff;
+      memset(weight_ld, 0xff, read_size*2);
     else
-      xt::view(weight_ld, 0, xt::all()) = 0xff;
+      memset(weight_ld, 0xff, 2);
     
-    auto weight = __WeightUnpack(weight_ld, read_size, false); //this->mode16 & this->mode_linear);
+    __WeightUnpack(weight_ld, read_size, false, weight); //this->mode16 & this->mode_linear);
     auto scale = this->Wmin;
 
-    xt::xarray<int32_t> block_enable_linear = xt::ones<int32_t>({this->NR_COLUMN, this->COLUMN_SIZE});
-    if(this->mode16 && this->mode_linear) {
-      for(auto rr=0; rr<this->NR_COLUMN; rr++) {
-        for(auto cc=0; cc<this->COLUMN_SIZE; cc++) {
-          auto i_kin_16bit = (cc<8 && rr<4) ? rr*8+cc : -1;
-          auto load_fbuf_lim = this->load_fbuf_lim;
-          xt::view(block_enable_linear, rr, cc) = ((i_kin_16bit != -1 && i_kin_16bit < load_fbuf_lim) ? 1 : 0);
-        }
-      }
-      // std::cout << "block_enable_linear=" << block_enable_linear << "\n";
-    }
-
     this->__BinConvArray(weight, scale, this->depthwise ? dw_iter : 0, block_enable_linear, row_enable, mac_enable, !this->depthwise, false, false, this->mode16, this->mode_linear);
     
   }
@@ -277,23 +213,18 @@ int Ne16::matrixvec_cycle() {
 
   // load and unpack weight bits
   int64_t cycles = 0;
-  xt::xarray<uint8_t> weight_ld = vld_W.ex(read_size*2, cycles); // each packet is composed of read_size x 16 bit
-  auto weight = __WeightUnpack(weight_ld, read_size, this->mode16);
+  uint8_t weight_ld[NE16_WEIGHT_ROWS*2];
+  uint8_t weight[NE16_WEIGHT_ROWS][NE16_BLOCK_SIZE];
+  vld_W.ex(read_size*2, cycles, weight_ld); // each packet is composed of read_size x 16 bit
+  auto nb_rows = __WeightUnpack(weight_ld, read_size, this->mode16, weight);
+  // rows which are not fed by the stream (e.g. 1x1 mode with qw < 9) only see zero activations
+  for(auto r=nb_rows; r<this->COLUMN_SIZE; r++) {
+    memset(weight[r], 0, NE16_BLOCK_SIZE);
+  }
   auto scale = 1 << this->mv_qw_iter;
 
-  xt::xarray<int32_t> space = xt::logspace(0, 7, 8, 2);
-  space = xt::reshape_view(space, {8, 1});
-
-  xt::xarray<int32_t> block_enable_linear = xt::ones<int32_t>({NR_COLUMN, COLUMN_SIZE});
-  if(this->mode16 && this->mode_linear) {
-    for(auto rr=0; rr<this->NR_COLUMN; rr++) {
-      for(auto cc=0; cc<this->COLUMN_SIZE; cc++) {
-        auto i_kin_16bit = (cc<8 && rr<4) ? rr*8+cc : -1;
-        auto load_fbuf_lim = this->load_fbuf_lim;
-        xt::view(block_enable_linear, rr, cc) = ((i_kin_16bit != -1 && i_kin_16bit < load_fbuf_lim) ? 1 : 0);
-      }
-    }
-  }
+  int32_t block_enable_linear[NE16_NR_COLUMN][NE16_COLUMN_SIZE];
+  __BlockEnableLinear(this->mode16, this->mode_linear, this->load_fbuf_lim, block_enable_linear);
   
   this->__BinConvArray(weight, scale, k_out, block_enable_linear, this->row_enable, this->mac_enable, false, false, this->fs==1 && !this->mode_linear, this->mode16, this->mode_linear);
 
@@ -40,7 +40,7 @@ void Ne16::normquant_shift_setup() {
 
 int  Ne16::normquant_shift_cycle() {
   int64_t cycles = 0;
-  xt::view(this->nqs, xt::all()) = this->vld_nqs.ex(this->TP_OUT, cycles);
+  this->vld_nqs.ex(this->TP_OUT, cycles, this->nqs.data());
   return (int) cycles;
 }
 
@@ -72,32 +72,32 @@ void Ne16::normquant_mult_setup() {
 
 int  Ne16::normquant_mult_cycle() {
   int64_t cycles = 0;
-  xt::xarray<uint8_t> nq = this->vld_nq.ex(4, cycles);
+  uint8_t nq[4];
+  this->vld_nq.ex(4, cycles, nq);
   // FIXME casting --> 1) load NQS; 2) load NQ and compute MULT; 3) load NQB and compute shift+bias
   if(this->normalization_bits == 8) {
     auto nmult = 4;
     for(auto i=0; i<nmult; i++) {
       for(auto col=0; col<this->NR_COLUMN; col++) {
-        xt::view(this->accum, this->nq_iter*nmult+i, col) = xt::view(this->accum, this->nq_iter*nmult+i, col) * xt::view(nq, i);
+        this->accum(this->nq_iter*nmult+i, col) *= nq[i];
       }
     }
   }
   else if(this->normalization_bits == 16) {
     auto nmult = 2;
-    xt::xarray<uint16_t> nq16 = xt::zeros<uint16_t>({2});
-    xt::view(nq16, 0) = xt::view(nq, 0) + (xt::view(nq, 1) << 8);
-    xt::view(nq16, 1) = xt::view(nq, 2) + (xt::view(nq, 3) << 8);
+    uint16_t nq16[2];
+    nq16[0] = nq[0] + (nq[1] << 8);
+    nq16[1] = nq[2] + (nq[3] << 8);
     for(auto i=0; i<2; i++) {
       for(auto col=0; col<this->NR_COLUMN; col++) {
-        xt::view(this->accum, this->nq_iter*nmult+i, col) = xt::view(this->accum, this->nq_iter*nmult+i, col) * xt::view(nq16, i);
+        this->accum(this->nq_iter*nmult+i, col) *= nq16[i];
       }
     }
   }
   else if(this->normalization_bits == 32) {
-    xt::xarray<uint32_t> nq32 = xt::zeros<uint32_t>({1});
-    xt::view(nq32, 0) = xt::view(nq, 0) + (xt::view(nq, 1) << 8) + (xt::view(nq, 2) << 16) + (xt::view(nq, 3) << 24);
+    uint32_t nq32 = nq[0] + (nq[1] << 8) + (nq[2] << 16) + ((uint32_t) nq[3] << 24);
     for(auto col=0; col<this->NR_COLUMN; col++) {
-      xt::view(this->accum, this->nq_iter, col) = xt::view(this->accum, this->nq_iter, col) * xt::view(nq32, 0);
+      this->accum(this->nq_iter, col) *= nq32;
     }
   }
   return (int) cycles;
@@ -142,35 +142,31 @@ void Ne16::normquant_bias_setup() {
 
 int  Ne16::normquant_bias_cycle() {
   int64_t cycles = 0;
-  xt::xarray<int32_t> nqb32 = xt::zeros<int32_t>({8});
+  auto k_first = this->nqb_iter*8;
   if(this->norm_option_bias) {
-    xt::xarray<uint8_t> nqb = this->vld_nqb.ex(32, cycles);
+    uint8_t nqb[32];
+    int32_t nqb32[8];
+    this->vld_nqb.ex(32, cycles, nqb);
     for(auto i=0; i<8; i++) {
-      xt::view(nqb32, i) = xt::cast<int32_t>(xt::view(nqb, i*4) + (xt::view(nqb, i*4+1) << 8) + (xt::view(nqb, i*4+2) << 16) + (xt::view(nqb, i*4+3) << 24));
+      nqb32[i] = (int32_t) (nqb[i*4] + (nqb[i*4+1] << 8) + (nqb[i*4+2] << 16) + ((uint32_t) nqb[i*4+3] << 24));
     }
     for(auto col=0; col<this->NR_COLUMN; col++) {
-      xt::view(this->accum, xt::range(this->nqb_iter*8, (this->nqb_iter+1)*8), col) = (xt::view(this->accum, xt::range(this->nqb_iter*8, (this->nqb_iter+1)*8), col) + nqb32);
-    }
-    if(this->norm_option_shift) {
-      for(auto col=0; col<this->NR_COLUMN; col++) {
-        xt::view(this->accum, xt::range(this->nqb_iter*8, (this->nqb_iter+1)*8), col) = xt::cast<int32_t>(xt::view(this->accum, xt::range(this->nqb_iter*8, (this->nqb_iter+1)*8), col)) >> xt::view(this->nqs, xt::range(this->nqb_iter*8, (this->nqb_iter+1)*8));
+      for(auto i=0; i<8; i++) {
+        this->accum(k_first+i, col) += nqb32[i];
       }
     }
-    else {
-      for(auto col=0; col<this->NR_COLUMN; col++) {
-        xt::view(this->accum, xt::range(this->nqb_iter*8, (this->nqb_iter+1)*8), col) = xt::cast<int32_t>(xt::view(this->accum, xt::range(this->nqb_iter*8, (this->nqb_iter+1)*8), col)) >> this->quantization_right_shift;
+    for(auto col=0; col<this->NR_COLUMN; col++) {
+      for(auto i=0; i<8; i++) {
+        auto shift = this->norm_option_shift ? this->nqs(k_first+i) : this->quantization_right_shift;
+        this->accum(k_first+i, col) = (int32_t) this->accum(k_first+i, col) >> shift;
       }
     }
   }
   else {
-    if(this->norm_option_shift) {
-      for(auto col=0; col<this->NR_COLUMN; col++) {
-        xt::view(this->accum, xt::range(this->nqb_iter*8, (this->nqb_iter+1)*8), col) = (xt::view(this->accum, xt::range(this->nqb_iter*8, (this->nqb_iter+1)*8), col)) >> xt::view(this->nqs, xt::range(this->nqb_iter*8, (this->nqb_iter+1)*8));
-      }
-    }
-    else {
-      for(auto col=0; col<this->NR_COLUMN; col++) {
-        xt::view(this->accum, xt::range(this->nqb_iter*8, (this->nqb_iter+1)*8), col) = (xt::view(this->accum, xt::range(this->nqb_iter*8, (this->nqb_iter+1)*8), col)) >> this->quantization_right_shift;
+    for(auto col=0; col<this->NR_COLUMN; col++) {
+      for(auto i=0; i<8; i++) {
+        auto shift = this->norm_option_shift ? this->nqs(k_first+i) : this->quantization_right_shift;
+        this->accum(k_first+i, col) = this->accum(k_first+i, col) >> shift;
       }
     }
   }
@@ -21,6 +21,7 @@
 #include <iostream>
 #include <cstdlib>
 #include <assert.h>
+#include <cstring>
 #include "xtensor/xarray.hpp"
 #include "xtensor/xio.hpp"
 #include "xtensor/xview.hpp"
@@ -157,7 +158,7 @@ Ne16VectorLoad<T>::Ne16VectorLoad() : Ne16StreamAccess((Ne16 *) NULL, 0, 0, 0, 0
 }
 
 template <class T>
-xt::xarray<T> Ne16VectorLoad<T>::ex(int width, int64_t& cycles) {
+void Ne16VectorLoad<T>::ex(int width, int64_t& cycles, T *data) {
   auto addr = this->iterate();
   uint8_t load_data[STREAM_MAX_WIDTH_BYTES];
   auto width_padded = width + 4;
@@ -199,22 +200,25 @@ xt::xarray<T> Ne16VectorLoad<T>::ex(int width, int64_t& cycles) {
       this->ne16->trace.fatal("Unsupported asynchronous reply\n");
     }
   }
-  std::ostringstream stringStream;
-
+  memcpy(data, load_data + (addr & 0x3), width*sizeof(T));
+  // the data dump is only formatted when it is going to be printed
   if (this->ne16->trace_level == L3_ALL) {
     this->ne16->trace.msg(vp::Trace::LEVEL_DEBUG, "Issuing read request (addr=0x%08x, size=%dB, latency=%d)\n", addr & NE16_STREAM_L1_MASK, width*sizeof(T), cycles+1);
-  }
-  xt::xarray<T> x = xt::zeros<T>({width});
-  for(auto i=0; i<width; i++) {
-    xt::view(x, i) = *(T *)(load_data + (addr & 0x3) + i*sizeof(T));
-  }
-  xt::print_options::set_line_width(1000);
-  stringStream << "Read data: " << (this->ne16->trace_format?std::hex:std::dec) << x << std::dec << "\n";
-  string s = stringStream.str();
-  if (this->ne16->trace_level == L3_ALL) {
+    std::array<std::size_t, 1> shape = {(std::size_t) width};
+    auto x = xt::adapt(data, width, xt::no_ownership(), shape);
+    std::ostringstream stringStream;
+    xt::print_options::set_line_width(1000);
+    stringStream << "Read data: " << (this->ne16->trace_format?std::hex:std::dec) << x << std::dec << "\n";
+    string s = stringStream.str();
     this->ne16->trace.msg(vp::Trace::LEVEL_DEBUG, s.c_str());
   }
   cycles += max_latency + 1;
+}
+
+template <class T>
+xt::xarray<T> Ne16VectorLoad<T>::ex(int width, int64_t& cycles) {
+  xt::xarray<T> x = xt::zeros<T>({width});
+  this->ex(width, cycles, x.data());
   return x;
 }
 
@@ -240,24 +244,28 @@ template <class T>
 xt::xarray<T> Ne16VectorStore<T>::ex(xt::xarray<T> data, int width, int64_t& cycles, int32_t enable) {
   auto addr = this->iterate();
   uint8_t store_data[STREAM_MAX_WIDTH_BYTES];
-  for(auto i=0; i<STREAM_MAX_WIDTH_BYTES; i++) {
-    store_data[i] = 0;
-  }
   for(auto i=0; i<width; i++) {
     *(T *)(store_data + i*sizeof(T)) = data(i);
   }
-  auto width_bytes = width*sizeof(T);
+  int width_bytes = width*sizeof(T);
   int64_t max_latency = 0;
   if(enable) {
-    for(auto i=0; i<width_bytes; i++) {
+    // One request per bank word touched by the stream: a partial word at a misaligned
+    // head, full words in the middle and a partial word for the tail.
+    int i = 0;
+    while(i < width_bytes) {
+      int size = 4 - ((addr+i) & 0x3);
+      if(size > width_bytes - i) {
+        size = width_bytes - i;
+      }
       this->ne16->io_req.init();
-      this->ne16->io_req.set_addr(addr+i & NE16_STREAM_L1_MASK);
-      this->ne16->io_req.set_size(1);
+      this->ne16->io_req.set_addr((addr+i) & NE16_STREAM_L1_MASK);
+      this->ne16->io_req.set_size(size);
       this->ne16->io_req.set_data(store_data+i);
       this->ne16->io_req.set_is_write(true);
       int err = this->ne16->out.req(&this->ne16->io_req);
       if (err == vp::IO_REQ_OK) {
-        if(i%4 == 0) {  // apparently, for non-aligned bytes we get garbage latency
+        if(((addr+i) & 0x3) == 0) {  // apparently, for non-aligned bytes we get garbage latency
           int64_t latency = this->ne16->io_req.get_latency();
           if (latency > max_latency) {
             max_latency = latency;
@@ -267,25 +275,20 @@ xt::xarray<T> Ne16VectorStore<T>::ex(xt::xarray<T> data, int width, int64_t& cyc
       else {
         this->ne16->trace.fatal("Unsupported asynchronous reply\n");
       }
+      i += size;
     }
   }
-  std::ostringstream stringStream;
   if (this->ne16->trace_level == L3_ALL) {
     this->ne16->trace.msg(vp::Trace::LEVEL_DEBUG, "Issuing write request (addr=0x%08x, size=%dB, latency=%d)\n", addr & NE16_STREAM_L1_MASK, width*sizeof(T), cycles+max_latency+1);
-  }
-  xt::print_options::set_line_width(1000);
-  if(enable) {
-    stringStream << "Write data: " << (this->ne16->trace_format?std::hex:std::dec) << data << std::dec << "\n";
-    string s = stringStream.str();
-    if (this->ne16->trace_level == L3_ALL) {
+    if(enable) {
+      std::ostringstream stringStream;
+      xt::print_options::set_line_width(1000);
+      stringStream << "Write data: " << (this->ne16->trace_format?std::hex:std::dec) << data << std::dec << "\n";
+      string s = stringStream.str();
       this->ne16->trace.msg(vp::Trace::LEVEL_DEBUG, s.c_str());
     }
-  }
-  else {
-    stringStream << "Write disabled" << "\n";
-    string s = stringStream.str();
-    if (this->ne16->trace_level == L3_ALL) {
-      this->ne16->trace.msg(vp::Trace::LEVEL_DEBUG, s.c_str());
+    else {
+      this->ne16->trace.msg(vp::Trace::LEVEL_DEBUG, "Write disabled\n");
     }
   }
   cycles += max_latency + 1;
@@ -0,0 +1,281 @@
+/*
+ * Copyright (C) 2024 ETH Zurich and University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Host check of the BinConv array datapath.
+//
+// The functions of include/ne16_binconv.hpp are compared with the xtensor implementation the
+// model used before, which is kept here as reference. Both compute the partial sums of the
+// 9x9 blocks for the same weight stream, activations and enables, in every mode of the
+// matrixvec and weight offset stages:
+// - 3x3 mode, 8-bit and 16-bit, the weights being scaled by the current weight bit
+// - 1x1 mode, each row being scaled by its own weight bit, with 1 to 8 weight bits
+// - linear mode, 8-bit and 16-bit, with all numbers of loaded input channels
+// - weight offsets with Wmin, where the weights are all ones
+// The inputs are random, generated from fixed seeds so that failures can be reproduced.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <vector>
+
+#include "xtensor/xarray.hpp"
+#include "xtensor/xio.hpp"
+#include "xtensor/xview.hpp"
+#include "xtensor/xadapt.hpp"
+#include "xtensor/xbuilder.hpp"
+#include "xtensor/xmath.hpp"
+
+#include <ne16_binconv.hpp>
+
+static uint32_t random_state = 0x12345678;
+static int nb_errors = 0;
+static int nb_blocks = 0;
+
+static uint32_t random_next() {
+  // Xorshift generator
+  uint32_t x = random_state;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  random_state = x;
+  return x;
+}
+
+// Reference implementation, as in the model before the fixed-size rewrite
+
+static xt::xarray<uint8_t> reference_weight_unpack(
+  xt::xarray<uint8_t> w,
+  int                 size,
+  bool                mode16
+) {
+  w = w.reshape({size,2,1});
+  xt::xarray<uint8_t> wu = xt::zeros<uint8_t>({size,2,8});
+  xt::view(wu, xt::all(), xt::all()) = xt::view(w, xt::all(), xt::all());
+  wu = (wu >> xt::linspace(0, 7, 8).reshape({1, 1, 8})) & 0x1;
+  if(mode16) {
+    return xt::hstack(xt::xtuple(wu.reshape({size*2, 8}), wu.reshape({size*2, 8})));
+  }
+  return wu.reshape({size, 2*8});
+}
+
+static xt::xarray<int64_t> reference_binconv_block(
+  xt::xarray<uint8_t> w,
+  xt::xarray<uint8_t> x,
+  int scale=0,
+  bool mode16=false
+) {
+  if(mode16) {
+    xt::xarray<int64_t> wx_lo = xt::view(w, xt::range(0, 8)) * xt::view(x, xt::range(0, 16, 2));
+    xt::xarray<int64_t> wx_hi = xt::view(w, xt::range(0, 8)) * xt::view(x, xt::range(1, 17, 2));
+    auto wx = wx_hi * 256 + wx_lo;
+    return xt::sum(wx, 0) * scale;
+  }
+  return xt::sum(w * x, 0) * scale;
+}
+
+static xt::xarray<int32_t> reference_block_enable_linear(bool mode16, bool mode_linear, int load_fbuf_lim) {
+  xt::xarray<int32_t> block_enable_linear = xt::ones<int32_t>({NE16_NR_COLUMN, NE16_COLUMN_SIZE});
+  if(mode16 && mode_linear) {
+    for(auto rr=0; rr<NE16_NR_COLUMN; rr++) {
+      for(auto cc=0; cc<NE16_COLUMN_SIZE; cc++) {
+        auto i_kin_16bit = (cc<8 && rr<4) ? rr*8+cc : -1;
+        xt::view(block_enable_linear, rr, cc) = ((i_kin_16bit != -1 && i_kin_16bit < load_fbuf_lim) ? 1 : 0);
+      }
+    }
+  }
+  return block_enable_linear;
+}
+
+// Block loop of the former Ne16::__BinConvArray, without the traces and the accumulation
+static void reference_binconv_array(
+  xt::xarray<uint8_t>& weight,
+  int                  scale,
+  xt::xarray<int32_t>  block_enable_linear,
+  xt::xarray<int32_t>  row_enable,
+  xt::xarray<int32_t>  mac_enable,
+  bool                 use_row_as_scale,
+  bool                 mode16,
+  bool                 mode_linear,
+  xt::xarray<uint8_t>& x_array,
+  xt::xarray<int64_t>& psum_block
+) {
+  for(auto c=0; c<NE16_NR_COLUMN; c++) {
+    for(auto r=0; r<NE16_COLUMN_SIZE; r++) {
+      if(row_enable(r) == 0)
+        continue;
+      auto scale_loc = use_row_as_scale ? 1 << r : scale;
+      auto activ = xt::view(x_array, c, r, xt::all());
+      if (!mode_linear) {
+        xt::view(psum_block, c, r) = reference_binconv_block(xt::view(weight, r) * mac_enable, activ, scale_loc, mode16);
+      }
+      else {
+        xt::xarray<uint8_t> weight_lin = xt::zeros_like(weight);
+        if(c==0) {
+          xt::view(weight_lin, xt::range(0, 8)) = xt::view(weight, xt::range(0, 8));
+        }
+        else if(c==1){
+          xt::view(weight_lin, xt::range(0, 8)) = xt::view(weight, xt::range(8, 16));
+        }
+        else if(c==2 && mode16){
+          xt::view(weight_lin, xt::range(0, 8)) = xt::view(weight, xt::range(16, 24));
+        }
+        else if(c==3 && mode16){
+          xt::view(weight_lin, xt::range(0, 8)) = xt::view(weight, xt::range(24, 32));
+        }
+        xt::view(psum_block, c, r) = reference_binconv_block(xt::view(weight_lin, r) * mac_enable * xt::view(block_enable_linear, c, r), activ, scale_loc, mode16);
+      }
+    }
+  }
+}
+
+// Runs both implementations on the weight stream weight_ld, made of read_size words, and
+// compares the partial sums of all blocks
+static void check_array(
+  const char*                 what,
+  const std::vector<uint8_t>& weight_ld,
+  int                         read_size,
+  int                         scale,
+  int                         load_fbuf_lim,
+  const std::vector<int32_t>& row_enable,
+  const std::vector<int32_t>& mac_enable,
+  bool                        use_row_as_scale,
+  bool                        unpack_mode16,
+  bool                        mode16,
+  bool                        mode_linear
+) {
+  std::vector<uint8_t> x(NE16_NR_COLUMN * NE16_COLUMN_SIZE * NE16_BLOCK_SIZE);
+  for(auto& value: x) {
+    value = random_next();
+  }
+
+  // Reference
+  xt::xarray<uint8_t> x_array = xt::adapt(x, {NE16_NR_COLUMN, NE16_COLUMN_SIZE, NE16_BLOCK_SIZE});
+  xt::xarray<uint8_t> weight_ld_ref = xt::adapt(weight_ld, {read_size*2});
+  xt::xarray<uint8_t> weight_ref = reference_weight_unpack(weight_ld_ref, read_size, unpack_mode16);
+  // Rows not fed by the stream (1x1 mode with qw < 9) were read out of bounds, they are zero
+  // in the new implementation
+  if(weight_ref.shape()[0] < NE16_COLUMN_SIZE) {
+    xt::xarray<uint8_t> padding = xt::zeros<uint8_t>({NE16_COLUMN_SIZE - (int) weight_ref.shape()[0], NE16_BLOCK_SIZE});
+    weight_ref = xt::vstack(xt::xtuple(weight_ref, padding));
+  }
+  xt::xarray<int64_t> psum_ref = xt::zeros<int64_t>({NE16_NR_COLUMN, NE16_COLUMN_SIZE});
+  reference_binconv_array(weight_ref, scale, reference_block_enable_linear(mode16, mode_linear, load_fbuf_lim),
+    xt::adapt(row_enable, {NE16_COLUMN_SIZE}), xt::adapt(mac_enable, {NE16_TP_IN}), use_row_as_scale, mode16,
+    mode_linear, x_array, psum_ref);
+
+  // Model, as done by Ne16::matrixvec_cycle and Ne16::__BinConvArray
+  uint8_t weight[NE16_WEIGHT_ROWS][NE16_BLOCK_SIZE];
+  int32_t block_enable_linear[NE16_NR_COLUMN][NE16_COLUMN_SIZE];
+  int32_t w[NE16_BLOCK_SIZE];
+  auto nb_rows = __WeightUnpack(weight_ld.data(), read_size, unpack_mode16, weight);
+  for(auto r=nb_rows; r<NE16_COLUMN_SIZE; r++) {
+    memset(weight[r], 0, NE16_BLOCK_SIZE);
+  }
+  __BlockEnableLinear(mode16, mode_linear, load_fbuf_lim, block_enable_linear);
+
+  for(auto c=0; c<NE16_NR_COLUMN; c++) {
+    for(auto r=0; r<NE16_COLUMN_SIZE; r++) {
+      if(row_enable[r] == 0)
+        continue;
+      auto scale_loc = use_row_as_scale ? 1 << r : scale;
+      const uint8_t *activ = &x[(c*NE16_COLUMN_SIZE + r)*NE16_BLOCK_SIZE];
+      __BinConvWeight(weight, c, r, mac_enable.data(), block_enable_linear, mode16, mode_linear, w);
+      int64_t psum = __BinConvBlock(w, activ, scale_loc, mode16);
+
+      nb_blocks++;
+      if(psum != psum_ref(c, r)) {
+        if(nb_errors < 16) {
+          printf("%s mismatch (read_size: %d, scale: %d, load_fbuf_lim: %d, column: %d, row: %d, expected: %ld, got: %ld)\n",
+            what, read_size, scale, load_fbuf_lim, c, r, (long) psum_ref(c, r), (long) psum);
+        }
+        nb_errors++;
+      }
+    }
+  }
+}
+
+static std::vector<uint8_t> random_weights(int read_size) {
+  std::vector<uint8_t> weight_ld(read_size*2);
+  for(auto& value: weight_ld) {
+    value = random_next();
+  }
+  return weight_ld;
+}
+
+static std::vector<int32_t> random_enable(int size) {
+  std::vector<int32_t> enable(size);
+  for(auto& value: enable) {
+    value = (random_next() & 0x7) != 0;
+  }
+  return enable;
+}
+
+int main() {
+  const std::vector<int32_t> all_rows(NE16_COLUMN_SIZE, 1);
+  const std::vector<int32_t> all_macs(NE16_TP_IN, 1);
+
+  for(auto iter=0; iter<64; iter++) {
+    for(auto mode16=0; mode16<2; mode16++) {
+      // 3x3 mode, scaled by the current weight bit, with the filter mask of the borders
+      for(auto qw_iter=0; qw_iter<8; qw_iter++) {
+        check_array("3x3", random_weights(9), 9, 1 << qw_iter, 0, iter & 1 ? random_enable(NE16_COLUMN_SIZE) : all_rows,
+          all_macs, false, mode16, mode16, false);
+      }
+
+      // Depthwise, only one MAC enabled
+      std::vector<int32_t> dw_macs(NE16_TP_IN, 0);
+      dw_macs[iter % NE16_TP_IN] = 1;
+      check_array("Depthwise", random_weights(9), 9, 1, 0, all_rows, dw_macs, false, mode16, mode16, false);
+
+      // Linear mode, with all numbers of input channels loaded into the feature buffer
+      for(auto load_fbuf_lim=0; load_fbuf_lim<=32; load_fbuf_lim++) {
+        check_array("Linear", random_weights(16), 16, 1 << (iter & 0x7), load_fbuf_lim, all_rows,
+          iter & 1 ? random_enable(NE16_TP_IN) : all_macs, false, mode16, mode16, true);
+      }
+
+      // Weight offsets, the weights are all ones and the scale is Wmin
+      for(auto fs3=0; fs3<2; fs3++) {
+        int mode_linear = iter & 1;
+        auto read_size = mode_linear ? (mode16 ? 32 : 16) : 9;
+        std::vector<uint8_t> weight_ld(read_size*2, 0);
+        if(fs3 || mode_linear) {
+          std::fill(weight_ld.begin(), weight_ld.end(), 0xff);
+        }
+        else {
+          weight_ld[0] = weight_ld[1] = 0xff;
+        }
+        int wmin = -(int) (random_next() & 0xff);
+        check_array("Weight offset", weight_ld, read_size, wmin, iter % 33, all_rows, all_macs, false, false, mode16,
+          mode_linear);
+      }
+    }
+
+    // 1x1 mode, each row scaled by its own weight bit
+    for(auto qw=1; qw<=8; qw++) {
+      check_array("1x1", random_weights(qw), qw, 1, 0, all_rows, iter & 1 ? random_enable(NE16_TP_IN) : all_macs,
+        true, false, false, false);
+    }
+  }
+
+  if(nb_errors) {
+    printf("FAILED: %d mismatches out of %d blocks\n", nb_errors, nb_blocks);
+    return 1;
+  }
+
+  printf("OK: %d blocks identical to the xtensor implementation\n", nb_blocks);
+  return 0;
+}
@@ -289,10 +289,12 @@ int Neureka::matrixvec_cycle() {
     weight_ld = xt::view(this->dw_weight_buffer, this->mv_qw_iter, xt::all());
   }
 
-  std::ostringstream stringStream;
-  stringStream << "Weight Read =" << xt::view(weight_ld, xt::all())<<"\n";
-  std::string copyOfStr = stringStream.str();
-  this->trace.msg(vp::Trace::LEVEL_DEBUG, copyOfStr.c_str());
+  if(this->trace_level == L3_ALL) {
+    std::ostringstream stringStream;
+    stringStream << "Weight Read =" << xt::view(weight_ld, xt::all())<<"\n";
+    std::string copyOfStr = stringStream.str();
+    this->trace.msg(vp::Trace::LEVEL_DEBUG, copyOfStr.c_str());
+  }
 
   auto shape = xt::adapt(weight_ld.shape());
 
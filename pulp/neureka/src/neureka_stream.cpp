@@ -22,6 +22,7 @@
 #include <iostream>
 #include <cstdlib>
 #include <assert.h>
+#include <cstring>
 #include "xtensor/xarray.hpp"
 #include "xtensor/xio.hpp"
 #include "xtensor/xview.hpp"
@@ -206,19 +207,17 @@ xt::xarray<T> NeurekaVectorLoad<T>::ex(int width, bool w_demux, int64_t& cycles)
       this->neureka->trace.fatal("Unsupported asynchronous reply\n");
     }
   }
-  std::ostringstream stringStream;
-
   // if (this->neureka->trace_level == L3_ALL) {
     this->neureka->trace.msg(vp::Trace::LEVEL_DEBUG, "Issuing read request (addr=0x%08x, size=%dB, latency=%d)\n", addr & NE16_STREAM_L1_MASK, width*sizeof(T), cycles+1);
   // }
   xt::xarray<T> x = xt::zeros<T>({width});
-  for(auto i=0; i<width; i++) {
-    xt::view(x, i) = *(T *)(load_data + (addr & 0x3) + i*sizeof(T));
-  }
-  xt::print_options::set_line_width(1000);
-  stringStream << "Read data: " << (this->neureka->trace_format?std::hex:std::dec) << x << std::dec << "\n";
-  string s = stringStream.str();
+  memcpy(x.data(), load_data + (addr & 0x3), width*sizeof(T));
+  // the data dump is only formatted when it is going to be printed
   if (this->neureka->trace_level == L3_ALL) {
+    std::ostringstream stringStream;
+    xt::print_options::set_line_width(1000);
+    stringStream << "Read data: " << (this->neureka->trace_format?std::hex:std::dec) << x << std::dec << "\n";
+    string s = stringStream.str();
     this->neureka->trace.msg(vp::Trace::LEVEL_DEBUG, s.c_str());
   }
   cycles += max_latency + 1;
@@ -247,62 +246,28 @@ template <class T>
 xt::xarray<T> NeurekaVectorStore<T>::ex(xt::xarray<T> data, int width, int64_t& cycles, int32_t enable) {
   auto addr = this->iterate();
   uint8_t store_data[STREAM_MAX_WIDTH_BYTES];
-  for(auto i=0; i<STREAM_MAX_WIDTH_BYTES; i++) {
-    store_data[i] = 0;
-  }
   for(auto i=0; i<width; i++) {
     *(T *)(store_data + i*sizeof(T)) = data(i);
   }
-
-  auto width_bytes = width*sizeof(T);
-  /* To handle misaligned address*/
-  auto addr_start = addr;
-  auto addr_end   = addr + width_bytes;
-
-  auto addr_start_aligned = 4*((addr_start+(addr_start%4 ? 4:0))/4);
-  auto addr_end_aligned   = 4*(addr_end/4);
-
-  auto misaligned_start_byte =  (width_bytes < 4 ) ? width_bytes : addr_start_aligned - addr_start;
-  auto misaligned_end_byte = (width_bytes < 4 ) ?  0 : addr_end - addr_end_aligned;
-
-  auto width_words = (addr_end_aligned> addr_start_aligned) ? (addr_end_aligned - addr_start_aligned)/4 : 0;
-
-  // std::cout<<std::hex<<"addr_start_aligned="<<addr_start_aligned<<", addr_end_aligned="<<addr_end_aligned<<std::endl;
-  // std::cout<<std::hex<<"addr_start="<<addr_start<<", addr_end="<<addr_end<<std::endl;
-
-  // std::cout<<std::hex<<"misaligned_start_byte="<<misaligned_start_byte<<", misaligned_end_byte="<<misaligned_end_byte<<std::endl;
-
+  int width_bytes = width*sizeof(T);
   int64_t max_latency = 0;
   if(enable) {
-    // std::cout<<std::dec<<"Width="<<width<<", width_bytes="<<width_bytes<<", width_words="<<width_words<<", addr="<<addr<<", sizeof(T)="<<sizeof(T)<<std::endl;
-    for(auto i=0; i<width_words+misaligned_start_byte+misaligned_end_byte; i++) {
-      this->neureka->io_req.init();
-
-      // if((i<misaligned_start_byte) ||((i>=width_words+misaligned_start_byte)))
-      if((i<misaligned_start_byte))
-      {
-        // std::cout<<i<<" Head of misaligned "<<((addr_start+i) & NE16_STREAM_L1_MASK)<<std::endl;
-        this->neureka->io_req.set_addr((addr_start+i) & NE16_STREAM_L1_MASK);
-        this->neureka->io_req.set_size(1);
-        this->neureka->io_req.set_data(store_data+i);
-      }
-      else if(i>=misaligned_start_byte+width_words){
-        // std::cout<<i<<" Tail of misaligned "<<((addr_start+misaligned_start_byte + 4*width_words+(i- misaligned_start_byte - width_words)) & NE16_STREAM_L1_MASK)<<std::endl;
-        this->neureka->io_req.set_addr((addr_start+misaligned_start_byte + 4*width_words+(i- misaligned_start_byte - width_words)) & NE16_STREAM_L1_MASK);
-        this->neureka->io_req.set_size(1);
-        this->neureka->io_req.set_data(store_data+misaligned_start_byte + 4*width_words+(i- misaligned_start_byte - width_words));
+    // One request per bank word touched by the stream: a partial word at a misaligned
+    // head, full words in the middle and a partial word for the tail.
+    int i = 0;
+    while(i < width_bytes) {
+      int size = 4 - ((addr+i) & 0x3);
+      if(size > width_bytes - i) {
+        size = width_bytes - i;
       }
-      else
-      {
-        // std::cout<<i<<" Aligned "<<((addr_start_aligned+4*(i - misaligned_start_byte)) & NE16_STREAM_L1_MASK)<<std::endl;
-        this->neureka->io_req.set_addr((addr_start_aligned+4*( i- misaligned_start_byte)) & NE16_STREAM_L1_MASK);
-        this->neureka->io_req.set_size(4);
-        this->neureka->io_req.set_data(store_data+misaligned_start_byte+4*(i-misaligned_start_byte));
-      } 
+      this->neureka->io_req.init();
+      this->neureka->io_req.set_addr((addr+i) & NE16_STREAM_L1_MASK);
+      this->neureka->io_req.set_size(size);
+      this->neureka->io_req.set_data(store_data+i);
       this->neureka->io_req.set_is_write(true);
       int err = this->neureka->out.req(&this->neureka->io_req);
       if (err == vp::IO_REQ_OK) {
-        if((i>=misaligned_start_byte) && (i<width_words+misaligned_start_byte)) {  // apparently, for non-aligned bytes we get garbage latency
+        if(((addr+i) & 0x3) == 0) {  // apparently, for non-aligned bytes we get garbage latency
           int64_t latency = this->neureka->io_req.get_latency();
           if (latency > max_latency) {
             max_latency = latency;
@@ -312,25 +277,20 @@ xt::xarray<T> NeurekaVectorStore<T>::ex(xt::xarray<T> data, int width, int64_t&
       else {
         this->neureka->trace.fatal("Unsupported asynchronous reply\n");
       }
+      i += size;
     }
   }
-  std::ostringstream stringStream;
   if (this->neureka->trace_level == L3_ALL) {
     this->neureka->trace.msg(vp::Trace::LEVEL_DEBUG, "Issuing write request (addr=0x%08x, size=%dB, latency=%d)\n", addr & NE16_STREAM_L1_MASK, width*sizeof(T), cycles+max_latency+1);
-  }
-  xt::print_options::set_line_width(1000);
-  if(enable) {
-    stringStream << "Write data: " << (this->neureka->trace_format?std::hex:std::dec) << data << std::dec << "\n";
-    string s = stringStream.str();
-    if (this->neureka->trace_level == L3_ALL) {
+    if(enable) {
+      std::ostringstream stringStream;
+      xt::print_options::set_line_width(1000);
+      stringStream << "Write data: " << (this->neureka->trace_format?std::hex:std::dec) << data << std::dec << "\n";
+      string s = stringStream.str();
       this->neureka->trace.msg(vp::Trace::LEVEL_DEBUG, s.c_str());
     }
-  }
-  else {
-    stringStream << "Write disabled" << "\n";
-    string s = stringStream.str();
-    if (this->neureka->trace_level == L3_ALL) {
-      this->neureka->trace.msg(vp::Trace::LEVEL_DEBUG, s.c_str());
+    else {
+      this->neureka->trace.msg(vp::Trace::LEVEL_DEBUG, "Write disabled\n");
     }
   }
   cycles += max_latency + 1;
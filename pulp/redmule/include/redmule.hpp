@@ -3,8 +3,9 @@
 
 #include <vp/vp.hpp>
 #include <vp/itf/io.hpp>
+#include <vector>
 #include "archi_redmule.h"
-#include "config.h"
+#include "redmule_fmt.hpp"
 
 enum redmule_state {
 	IDLE,
@@ -17,22 +18,9 @@ enum redmule_state {
 
 typedef uint64_t strobe_t;
 
-class RedMule;
-
-class RedMule_Engine {
-	public:
-		RedMule_Engine();
-		void compute_next();
+#define REDMULE_BUFFER_ALIGN 64
 
-	private:
-		dst_fmt_t z_buffer [ARRAY_HEIGHT * (PIPE_REGS + 1)] [ARRAY_WIDTH];
-		dst_fmt_t x_buffer  [ARRAY_HEIGHT * 2] [ARRAY_WIDTH];
-		dst_fmt_t w_buffer [ARRAY_HEIGHT] [ARRAY_HEIGHT * (PIPE_REGS + 1)];
-
-		dst_fmt_t* get_next_z();
-		dst_fmt_t* get_next_x();
-		dst_fmt_t* get_next_w();
-};
+class RedMule;
 
 class RedMule_Buffers {
 	public:
@@ -42,16 +30,22 @@ class RedMule_Buffers {
 		void alloc_buffers(uint32_t n, uint8_t x_rows_lftovr, uint8_t x_cols_lftovr, uint8_t w_rows_lftovr, uint8_t w_cols_lftovr);
 		void free_buffers();
 
-		dst_fmt_t* get_next_w();
-		dst_fmt_t* get_next_x();
-		dst_fmt_t* get_next_y();
-		dst_fmt_t* get_next_z();
+		float* get_next_w();
+		float* get_next_x();
+		float* get_next_y();
+		float* get_next_z();
 
 		void compute_z();
 
 	private:
 		RedMule* redmule;
 
+		// Geometry, copied from the component
+		int array_width;
+		int array_height;
+		int pipe_regs;
+		int row_len;
+
 		uint32_t w_pointer;
 		uint32_t x_pointer;
 		uint32_t y_pointer;
@@ -74,19 +68,28 @@ class RedMule_Buffers {
 		uint32_t z_iters;
 
 		int x_row_offs(int k);
+		int x_row_len();
+
+		template<int DST> void compute_z_fmt();
+		template<int DST, int ROW_LEN> void compute_z_rows();
+		void dump_buffers();
 
-		dst_fmt_t** w;
-		dst_fmt_t** x;
+		// x rows are x_stride elements apart so that each one starts on a cache line, w rows
+		// are packed one after the other. Both are allocated with REDMULE_BUFFER_ALIGN.
+		float* w;
+		float* x;
+		int x_stride;
 
-		dst_fmt_t y [ARRAY_WIDTH * 2] [(PIPE_REGS + 1) * ARRAY_HEIGHT];
-		dst_fmt_t z [ARRAY_WIDTH] [(PIPE_REGS + 1) * ARRAY_HEIGHT];
+		// y holds 2 * array_width rows and z array_width rows of row_len elements
+		std::vector<float> y;
+		std::vector<float> z;
 };
 
 class RedMule_Streamer {
 	public:
 		RedMule_Streamer(RedMule* redmule, bool is_write);
 		RedMule_Streamer();
-		int iterate(void* buf, strobe_t strb);
+		int iterate(float* buf, strobe_t strb);
 		void configure(
 			uint32_t	base_addr	,
 			uint32_t 	tot_len 	,
@@ -123,6 +126,11 @@ class RedMule_Streamer {
 		uint32_t	d3_stride	;
 		bool		is_write	;
 
+		// Row conversions between the memory format and the buffers, selected
+		// once from the configured formats
+		void (*load_row)(float* buf, int len);
+		void (*store_row)(float* buf, int len);
+
 		int rw_data(int width, void* buf, strobe_t strb);
 };
 
@@ -143,6 +151,19 @@ class RedMule : public vp::component {
 		vp::trace trace;
 		vp::reg_32 state;
 
+		// Array geometry and formats, taken from the JSON config
+		int array_height;
+		int pipe_regs;
+		int array_width;
+		int row_len;		// (pipe_regs + 1) * array_height elements
+		int src_fmt;
+		int dst_fmt;
+		int src_size;
+		int dst_size;
+
+		// Send aligned and fully enabled rows as single requests instead of one per bank
+		bool wide_accesses;
+
 	private:
 		static vp::io_req_status_e hwpe_slave(void *__this, vp::io_req *req);
 
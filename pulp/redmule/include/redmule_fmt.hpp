@@ -0,0 +1,112 @@
+#ifndef __REDMULE_FMT_HPP__
+#define __REDMULE_FMT_HPP__
+
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include "archi_redmule.h"
+
+// Internally every buffer element is kept as a float holding a value which is exactly
+// representable in the destination format, so that the same binary can model any
+// src/dst format pair. The helpers below convert between this representation and the
+// raw encodings found in memory.
+
+// FP8 is the upper byte of an FP16 value (E5M2)
+static inline float redmule_fp8_to_float(uint8_t value) {
+    uint16_t bits = ((uint16_t) value) << 8;
+    _Float16 tmp;
+    memcpy(&tmp, &bits, sizeof(tmp));
+    return (float) tmp;
+}
+
+static inline uint8_t redmule_float_to_fp8(float value) {
+    _Float16 tmp = (_Float16) value;
+    uint16_t bits;
+    memcpy(&bits, &tmp, sizeof(bits));
+    return bits >> 8;
+}
+
+// Decode one element of format FMT from memory
+template<int FMT> static inline float redmule_load(const uint8_t *data);
+
+template<> inline float redmule_load<FP32>(const uint8_t *data) {
+    float value;
+    memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+template<> inline float redmule_load<FP16>(const uint8_t *data) {
+    _Float16 value;
+    memcpy(&value, data, sizeof(value));
+    return (float) value;
+}
+
+template<> inline float redmule_load<FP8>(const uint8_t *data) {
+    return redmule_fp8_to_float(*data);
+}
+
+// Encode one element into format FMT in memory
+template<int FMT> static inline void redmule_store(uint8_t *data, float value);
+
+template<> inline void redmule_store<FP32>(uint8_t *data, float value) {
+    memcpy(data, &value, sizeof(value));
+}
+
+template<> inline void redmule_store<FP16>(uint8_t *data, float value) {
+    _Float16 tmp = (_Float16) value;
+    memcpy(data, &tmp, sizeof(tmp));
+}
+
+template<> inline void redmule_store<FP8>(uint8_t *data, float value) {
+    *data = redmule_float_to_fp8(value);
+}
+
+// Round a value to what format FMT can hold. FP8 truncates the FP16 mantissa as the
+// hardware does.
+template<int FMT> static inline float redmule_round(float value);
+
+template<> inline float redmule_round<FP32>(float value) {
+    return value;
+}
+
+template<> inline float redmule_round<FP16>(float value) {
+    return (float) (_Float16) value;
+}
+
+template<> inline float redmule_round<FP8>(float value) {
+    return redmule_fp8_to_float(redmule_float_to_fp8(value));
+}
+
+static inline int redmule_fmt_size(int fmt) {
+    switch (fmt) {
+        case FP8:  return 1;
+        case FP16: return 2;
+        case FP32: return 4;
+        default:   return 0;
+    }
+}
+
+// Returns -1 if the format is not supported by the model
+static inline int redmule_fmt_parse(std::string name) {
+    if (name == "FP8")  return FP8;
+    if (name == "FP16") return FP16;
+    if (name == "FP32") return FP32;
+    return -1;
+}
+
+// Raw bits of a value in format FMT, for traces
+static inline uint32_t redmule_fmt_bits(int fmt, float value) {
+    uint8_t data[4] = {0, 0, 0, 0};
+    uint32_t bits = 0;
+
+    switch (fmt) {
+        case FP8:  redmule_store<FP8>(data, value);  break;
+        case FP16: redmule_store<FP16>(data, value); break;
+        default:   redmule_store<FP32>(data, value); break;
+    }
+
+    memcpy(&bits, data, sizeof(bits));
+    return bits;
+}
+
+#endif
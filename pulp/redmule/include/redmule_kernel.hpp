@@ -0,0 +1,86 @@
+#ifndef __REDMULE_KERNEL_HPP__
+#define __REDMULE_KERNEL_HPP__
+
+// Multiply-accumulate kernel computing the Z tiles. It does not depend on the rest of the model so
+// that it can be checked on the host against the golden model, see test/host.
+
+#include <cmath>
+#include <memory.h>
+
+// Generic vectors let the compiler pick AVX2, NEON or SSE depending on the host, other
+// compilers use the scalar loop
+#if defined(__clang__) || (defined(__GNUC__) && __GNUC__ >= 9)
+#define REDMULE_VECTOR_KERNEL
+typedef float redmule_v4f __attribute__((vector_size(16)));
+typedef double redmule_v4d __attribute__((vector_size(32)));
+#endif
+
+// One accumulation step. The product of two floats is exact in double, so this is the same
+// as doing the multiply and the add in double and rounding once to float, which is what the
+// vector kernel does.
+static inline float redmule_mac(float x, float w, float acc) {
+    return (float) fma((double) x, (double) w, (double) acc);
+}
+
+#ifdef REDMULE_VECTOR_KERNEL
+// Accumulates n rows of w, weighted by x, into NV * 4 consecutive elements of acc, which are
+// kept in registers for the whole reduction
+template<int NV>
+static inline void redmule_mac_block(float* acc, const float* x, const float* w, int w_stride, int n) {
+    redmule_v4f a[NV];
+
+    for (int v = 0; v < NV; v++) {
+        memcpy(&a[v], acc + 4 * v, sizeof(redmule_v4f));
+    }
+
+    for (int k = 0; k < n; k++) {
+        double x_k = x[k];
+        const float* w_k = w + k * w_stride;
+
+        for (int v = 0; v < NV; v++) {
+            redmule_v4f w_v;
+            memcpy(&w_v, w_k + 4 * v, sizeof(redmule_v4f));
+
+            redmule_v4d res = __builtin_convertvector(w_v, redmule_v4d) * x_k + __builtin_convertvector(a[v], redmule_v4d);
+            a[v] = __builtin_convertvector(res, redmule_v4f);
+        }
+    }
+
+    for (int v = 0; v < NV; v++) {
+        memcpy(acc + 4 * v, &a[v], sizeof(redmule_v4f));
+    }
+}
+#endif
+
+// acc[j] += sum over k of x[k] * w[k][j], accumulated in k order for each j so that the
+// result does not depend on the kernel being used
+template<int ROW_LEN>
+static void redmule_mac_rows(float* acc, const float* x, const float* w, int row_len, int n) {
+    if (ROW_LEN) {
+        row_len = ROW_LEN;
+    }
+
+    int j = 0;
+
+#ifdef REDMULE_VECTOR_KERNEL
+    for (; j + 16 <= row_len; j += 16) {
+        redmule_mac_block<4>(acc + j, x, w + j, row_len, n);
+    }
+
+    for (; j + 4 <= row_len; j += 4) {
+        redmule_mac_block<1>(acc + j, x, w + j, row_len, n);
+    }
+#endif
+
+    for (; j < row_len; j++) {
+        float tmp_z = acc[j];
+
+        for (int k = 0; k < n; k++) {
+            tmp_z = redmule_mac(x[k], w[k * row_len + j], tmp_z);
+        }
+
+        acc[j] = tmp_z;
+    }
+}
+
+#endif
@@ -2,13 +2,41 @@ import gvsoc.systree as st
 import gvsoc
 
 class RedMule(st.Component):
-
-    def __init__(self, parent, name):
+    """RedMulE GEMM accelerator
+
+    Attributes
+    ----------
+    array_height: int
+        Number of rows of the computing array.
+    pipe_regs: int
+        Number of pipeline registers of each computing element. The array has
+        array_height * pipe_regs columns.
+    src_fmt: str
+        Format of the matrices in memory, one of FP8, FP16, FP32.
+    dst_fmt: str
+        Format used for the computation, one of FP8, FP16, FP32. Must be at least as wide as
+        src_fmt.
+    wide_accesses: bool
+        True if aligned rows with all bytes enabled are accessed with one request instead of one
+        per bank word. The memory behind the output port must then accept requests spanning
+        several banks, like the cluster L1 interleaver which splits them into bank accesses.
+    """
+
+    def __init__(self, parent, name, array_height: int=4, pipe_regs: int=3,
+            src_fmt: str='FP16', dst_fmt: str='FP32', wide_accesses: bool=False):
 
         super(RedMule, self).__init__(parent, name)
 
         self.set_component('pulp.redmule.redmule')
 
+        self.add_properties({
+            'array_height': array_height,
+            'pipe_regs': pipe_regs,
+            'src_fmt': src_fmt,
+            'dst_fmt': dst_fmt,
+            'wide_accesses': wide_accesses,
+        })
+
 
     def i_INPUT(self) -> gvsoc.systree.SlaveItf:
         return gvsoc.systree.SlaveItf(self, 'input', signature='io')
@@ -78,6 +78,37 @@ int RedMule::build() {
 	this->in.set_req_meth(&RedMule::hwpe_slave);
     this->new_slave_port("input", &this->in);
 
+	this->array_height = this->get_js_config()->get_child_int("array_height");
+	this->pipe_regs = this->get_js_config()->get_child_int("pipe_regs");
+	this->array_width = this->pipe_regs * this->array_height;
+	this->row_len = (this->pipe_regs + 1) * this->array_height;
+
+	if (this->array_height <= 0 || this->pipe_regs <= 0) {
+		this->trace.fatal("Invalid array geometry (array_height: %d, pipe_regs: %d)\n", this->array_height, this->pipe_regs);
+		return -1;
+	}
+
+	this->src_fmt = redmule_fmt_parse(this->get_js_config()->get_child_str("src_fmt"));
+	this->dst_fmt = redmule_fmt_parse(this->get_js_config()->get_child_str("dst_fmt"));
+
+	if (this->src_fmt == -1 || this->dst_fmt == -1) {
+		this->trace.fatal("Unsupported formats (src_fmt: %s, dst_fmt: %s)\n",
+			this->get_js_config()->get_child_str("src_fmt").c_str(), this->get_js_config()->get_child_str("dst_fmt").c_str());
+		return -1;
+	}
+
+	this->src_size = redmule_fmt_size(this->src_fmt);
+	this->dst_size = redmule_fmt_size(this->dst_fmt);
+
+	// Strobes are 64 bits masks with one bit per byte of a row
+	int max_size = this->src_size > this->dst_size ? this->src_size : this->dst_size;
+	if (this->row_len * max_size > 64) {
+		this->trace.fatal("Array row is too wide for the strobes (%d bytes)\n", this->row_len * max_size);
+		return -1;
+	}
+
+	this->wide_accesses = this->get_js_config()->get_child_bool("wide_accesses");
+
 	this->w_stream = RedMule_Streamer(this, false);
 	this->x_stream = RedMule_Streamer(this, false);
 	this->y_stream = RedMule_Streamer(this, false);
@@ -1,15 +1,16 @@
 #include <redmule.hpp>
+#include <redmule_kernel.hpp>
 
+#include <algorithm>
 #include <cmath>
+#include <cstdlib>
 #include <memory.h>
 
-#if DST_FMT==FP32
-    typedef uint32_t print_t;
-#elif DST_FMT==FP16
-    typedef uint16_t print_t;
-#else
-    typedef uint8_t print_t;
-#endif
+static float* redmule_buffer_alloc(int nb_elems) {
+    size_t size = nb_elems * sizeof(float);
+    size = (size + REDMULE_BUFFER_ALIGN - 1) / REDMULE_BUFFER_ALIGN * REDMULE_BUFFER_ALIGN;
+    return (float *) aligned_alloc(REDMULE_BUFFER_ALIGN, size > 0 ? size : REDMULE_BUFFER_ALIGN);
+}
 
 RedMule_Buffers::RedMule_Buffers() {
     this->redmule = (RedMule *) NULL;
@@ -18,6 +19,11 @@ RedMule_Buffers::RedMule_Buffers() {
 RedMule_Buffers::RedMule_Buffers(RedMule* redmule) {
     this->redmule = redmule;
 
+    this->array_width = redmule->array_width;
+    this->array_height = redmule->array_height;
+    this->pipe_regs = redmule->pipe_regs;
+    this->row_len = redmule->row_len;
+
     this->w_pointer = 0;
 	this->x_pointer = 0;
 	this->y_pointer = 0;
@@ -41,73 +47,68 @@ RedMule_Buffers::RedMule_Buffers(RedMule* redmule) {
 
 	this->w = NULL;
 	this->x = NULL;
+	this->x_stride = 0;
 
-	memset(this->y, 0, sizeof(this->y));
-	memset(this->z, 0, sizeof(this->z));
+	this->y.assign(2 * this->array_width * this->row_len, 0.0f);
+	this->z.assign(this->array_width * this->row_len, 0.0f);
 }
 
-void RedMule_Buffers::alloc_buffers(uint32_t n, uint8_t x_rows_lftovr, uint8_t x_cols_lftovr, uint8_t w_rows_lftovr, uint8_t w_cols_lftovr) {
-    this->x = new dst_fmt_t*[ARRAY_WIDTH]; 
-    
-    for (int i = 0; i < ARRAY_WIDTH; i++) {
-        this->x[i] = new dst_fmt_t[n + ((PIPE_REGS + 1) * ARRAY_HEIGHT - x_cols_lftovr ) % ((PIPE_REGS + 1) * ARRAY_HEIGHT) + 2 * ARRAY_HEIGHT * (PIPE_REGS + 1)];
-    }
-                 
-    this->w = new dst_fmt_t*[n];
-
-    for (int i = 0; i < n; i++) {
-        this->w[i] = new dst_fmt_t[(PIPE_REGS + 1) * ARRAY_HEIGHT];
-    }
+int RedMule_Buffers::x_row_len() {
+    return this->n + (this->row_len - this->x_cols_lftovr) % this->row_len + 2 * this->row_len;
+}
 
+void RedMule_Buffers::alloc_buffers(uint32_t n, uint8_t x_rows_lftovr, uint8_t x_cols_lftovr, uint8_t w_rows_lftovr, uint8_t w_cols_lftovr) {
     this->n = n;
 
     this->x_cols_lftovr = x_cols_lftovr;
     this->x_rows_lftovr = x_rows_lftovr;
     this->w_cols_lftovr = w_cols_lftovr;
     this->w_rows_lftovr = w_rows_lftovr;
+
+    int align = REDMULE_BUFFER_ALIGN / sizeof(float);
+    this->x_stride = (this->x_row_len() + align - 1) / align * align;
+
+    this->x = redmule_buffer_alloc(this->array_width * this->x_stride);
+    this->w = redmule_buffer_alloc(n * this->row_len);
 }
 
 void RedMule_Buffers::free_buffers() {
-    for (int i = 0; i < ARRAY_WIDTH; i++) {
-        delete this->x[i];
-    }
-    delete this->x;
+    free(this->x);
+    free(this->w);
 
-    for (int i = 0; i < n; i++) {
-        delete this->w[i];
-    }
-    delete this->w;
+    this->x = NULL;
+    this->w = NULL;
 
     this->x_offs = 0;
     this->y_offs = 0;
 
-    memset(this->y, 0, sizeof(this->y));
-	memset(this->z, 0, sizeof(this->z));
+    std::fill(this->y.begin(), this->y.end(), 0.0f);
+    std::fill(this->z.begin(), this->z.end(), 0.0f);
 }
 
-dst_fmt_t* RedMule_Buffers::get_next_w() {
-    dst_fmt_t* res = this->w_iters < this->n ? this->w[w_iters] : NULL;
+float* RedMule_Buffers::get_next_w() {
+    float* res = this->w_iters < this->n ? &this->w[w_iters * this->row_len] : NULL;
 
     this->w_iters++;
 
-    if (this->w_iters == this->n + ((ARRAY_HEIGHT - this->w_rows_lftovr ) % ARRAY_HEIGHT)) {
+    if (this->w_iters == this->n + ((this->array_height - this->w_rows_lftovr ) % this->array_height)) {
         this->w_iters = 0;
     }
 
     return res;
 }
 
-dst_fmt_t* RedMule_Buffers::get_next_x() {
-    dst_fmt_t* res = &this->x[x_d0_iters][x_pointer];
+float* RedMule_Buffers::get_next_x() {
+    float* res = &this->x[x_d0_iters * this->x_stride + x_pointer];
 
     this->x_d0_iters++;
 
-    if (this->x_d0_iters == ARRAY_WIDTH) {
+    if (this->x_d0_iters == this->array_width) {
         this->x_d0_iters = 0;
         this->x_d1_iters++;
-        this->x_pointer += ARRAY_HEIGHT * (PIPE_REGS + 1);
+        this->x_pointer += this->row_len;
 
-        if (this->x_d1_iters == (this->n + ((PIPE_REGS + 1) * ARRAY_HEIGHT - this->x_cols_lftovr ) % ((PIPE_REGS + 1) * ARRAY_HEIGHT)) / (ARRAY_HEIGHT * (PIPE_REGS + 1)) + 2) {
+        if (this->x_d1_iters == (this->n + (this->row_len - this->x_cols_lftovr ) % this->row_len) / this->row_len + 2) {
             this->x_d1_iters = 0;
             this->x_pointer = 0;
         }
@@ -116,31 +117,31 @@ dst_fmt_t* RedMule_Buffers::get_next_x() {
     return res;
 }
 
-dst_fmt_t* RedMule_Buffers::get_next_y() {
-    dst_fmt_t* res = this->y[y_iters];
+float* RedMule_Buffers::get_next_y() {
+    float* res = &this->y[y_iters * this->row_len];
 
     this->y_iters++;
 
-    if (this->y_iters == 2 * ARRAY_WIDTH) {
+    if (this->y_iters == 2 * this->array_width) {
         this->y_pointer = 0;
         this->y_iters = 0;
     } else {
-        this->y_pointer += sizeof(dst_fmt_t) * (PIPE_REGS + 1) * ARRAY_HEIGHT;
+        this->y_pointer += this->redmule->dst_size * this->row_len;
     }
 
     return res;
 }
 
-dst_fmt_t* RedMule_Buffers::get_next_z() {
-    dst_fmt_t* res = this->z[z_iters];
+float* RedMule_Buffers::get_next_z() {
+    float* res = &this->z[z_iters * this->row_len];
 
     this->z_iters++;
 
-    if (this->z_iters == ARRAY_WIDTH) {
+    if (this->z_iters == this->array_width) {
         this->z_pointer = 0;
         this->z_iters = 0;
     } else {
-        this->z_pointer += sizeof(dst_fmt_t) * (PIPE_REGS + 1) * ARRAY_HEIGHT;
+        this->z_pointer += this->redmule->dst_size * this->row_len;
     }
 
     return res;
@@ -149,68 +150,76 @@ dst_fmt_t* RedMule_Buffers::get_next_z() {
 int RedMule_Buffers::x_row_offs(int k) {
     int res = this->x_offs + k;
 
-    if (res >= this->n + ((PIPE_REGS + 1) * ARRAY_HEIGHT - this->x_cols_lftovr ) % ((PIPE_REGS + 1) * ARRAY_HEIGHT) + 2 * ARRAY_HEIGHT * (PIPE_REGS + 1)) {
-        res -= this->n + ((PIPE_REGS + 1) * ARRAY_HEIGHT - this->x_cols_lftovr ) % ((PIPE_REGS + 1) * ARRAY_HEIGHT) + 2 * ARRAY_HEIGHT * (PIPE_REGS + 1);
+    if (res >= this->x_row_len()) {
+        res -= this->x_row_len();
     }
 
     return res;
 }
 
-void RedMule_Buffers::compute_z() {
-    for (int i = 0; i < ARRAY_WIDTH; i++) {
-        for (int j = 0; j < (PIPE_REGS + 1) * ARRAY_HEIGHT; j++) {
-        #if DST_FMT!=FP8
-            float tmp_z;
+// ROW_LEN is 0 for geometries without a dedicated instance, the row length is then
+// read at runtime
+template<int DST, int ROW_LEN>
+void RedMule_Buffers::compute_z_rows() {
+    const int row_len = ROW_LEN ? ROW_LEN : this->row_len;
+    const int x_len = this->x_row_len();
 
-            tmp_z = (float) this->y[i + this->y_offs][j];
+    // The n x elements used by a row start at x_offs in a ring of x_len elements, they are
+    // consumed in at most 2 contiguous chunks
+    int first = std::min((int) this->n, x_len - (int) this->x_offs);
 
-            for (int k = 0; k < this->n; k++) {
-                tmp_z = fma((float) this->x[i][this->x_row_offs(k)], (float) this->w[k][j], tmp_z);
-            }
+    for (int i = 0; i < this->array_width; i++) {
+        const float *x_row = &this->x[i * this->x_stride];
+        float *z_row = &this->z[i * row_len];
 
-            this->z[i][j] = (dst_fmt_t) tmp_z;
-        #else
-            uint16_t x_buf, w_buf, z_buf;
-            float tmp_z, tmp_x, tmp_w;
-            _Float16 z16 = 0.0f;
+        memcpy(z_row, &this->y[(i + this->y_offs) * row_len], row_len * sizeof(float));
 
-            z_buf = ((uint16_t) this->y[i + this->y_offs][j]) << 8;
-            tmp_z = (float) * (_Float16 *) &z_buf;
+        redmule_mac_rows<ROW_LEN>(z_row, x_row + this->x_offs, this->w, row_len, first);
 
-            for (int k = 0; k < this->n; k++) {
-                x_buf = ((uint16_t) this->x[i][this->x_row_offs(k)]) << 8;
-                tmp_x = (float) * (_Float16 *) &x_buf;
+        if (first < this->n) {
+            redmule_mac_rows<ROW_LEN>(z_row, x_row, &this->w[first * row_len], row_len, this->n - first);
+        }
 
-                w_buf = ((uint16_t) this->w[k][j]) << 8;
-                tmp_w = (float) * (_Float16 *) &w_buf;
+        for (int j = 0; j < row_len; j++) {
+            z_row[j] = redmule_round<DST>(z_row[j]);
+        }
+    }
+}
 
-                tmp_z = fma(tmp_x, tmp_w, tmp_z);
-            }
+template<int DST>
+void RedMule_Buffers::compute_z_fmt() {
+    switch (this->row_len) {
+        case 16:
+            this->compute_z_rows<DST, 16>();
+            break;
 
-            z16 = (_Float16) tmp_z;
-            z_buf = * (uint16_t *) &z16;
+        case 32:
+            this->compute_z_rows<DST, 32>();
+            break;
 
-            this->z[i][j] = z_buf >> 8;
-        #endif
-        }
+        default:
+            this->compute_z_rows<DST, 0>();
     }
+}
 
+void RedMule_Buffers::dump_buffers() {
+    int fmt = this->redmule->dst_fmt;
 
     this->redmule->trace.msg("COMPUTED:\n\n");
 
     this->redmule->trace.msg("Y:\n");
-    for (int i = 0; i < 12; i++) {
-        for (int j = 0; j < 16; j++) {
-            this->redmule->trace.msg("0x%x, ", * (print_t *) &(this->y[this->y_offs + i][j]));
+    for (int i = 0; i < this->array_width; i++) {
+        for (int j = 0; j < this->row_len; j++) {
+            this->redmule->trace.msg("0x%x, ", redmule_fmt_bits(fmt, this->y[(this->y_offs + i) * this->row_len + j]));
         }
         this->redmule->trace.msg("\n");
     }
     this->redmule->trace.msg("\n\n");
 
     this->redmule->trace.msg("X:\n");
-    for (int i = 0; i < ARRAY_WIDTH; i++) {
+    for (int i = 0; i < this->array_width; i++) {
         for (int j = 0; j < this->n; j++) {
-            this->redmule->trace.msg("0x%x, ", * (print_t *) &(x[i][this->x_row_offs(j)]));
+            this->redmule->trace.msg("0x%x, ", redmule_fmt_bits(fmt, this->x[i * this->x_stride + this->x_row_offs(j)]));
         }
         this->redmule->trace.msg("\n");
     }
@@ -218,27 +227,44 @@ void RedMule_Buffers::compute_z() {
 
     this->redmule->trace.msg("W:\n");
     for (int i = 0; i < this->n; i++) {
-        for (int j = 0; j < 16; j++) {
-            this->redmule->trace.msg("0x%x, ", * (print_t *) &(this->w[i][j]));
+        for (int j = 0; j < this->row_len; j++) {
+            this->redmule->trace.msg("0x%x, ", redmule_fmt_bits(fmt, this->w[i * this->row_len + j]));
         }
         this->redmule->trace.msg("\n");
     }
     this->redmule->trace.msg("\n\n");
 
     this->redmule->trace.msg("Z:\n");
-    for (int i = 0; i < 12; i++) {
-        for (int j = 0; j < 16; j++) {
-            this->redmule->trace.msg("0x%x, ", * (print_t *) &(this->z[i][j]));
+    for (int i = 0; i < this->array_width; i++) {
+        for (int j = 0; j < this->row_len; j++) {
+            this->redmule->trace.msg("0x%x, ", redmule_fmt_bits(fmt, this->z[i * this->row_len + j]));
         }
         this->redmule->trace.msg("\n");
     }
     this->redmule->trace.msg("\n\n");
+}
 
-    this->x_offs += this->n + ((PIPE_REGS + 1) * ARRAY_HEIGHT - this->x_cols_lftovr ) % ((PIPE_REGS + 1) * ARRAY_HEIGHT);
+void RedMule_Buffers::compute_z() {
+    switch (this->redmule->dst_fmt) {
+        case FP8:
+            this->compute_z_fmt<FP8>();
+            break;
 
-    if (this->x_offs >= this->n + ((PIPE_REGS + 1) * ARRAY_HEIGHT - this->x_cols_lftovr ) % ((PIPE_REGS + 1) * ARRAY_HEIGHT) + 2 * ARRAY_HEIGHT * (PIPE_REGS + 1)) {
-        this->x_offs -= this->n + ((PIPE_REGS + 1) * ARRAY_HEIGHT - this->x_cols_lftovr ) % ((PIPE_REGS + 1) * ARRAY_HEIGHT) + 2 * ARRAY_HEIGHT * (PIPE_REGS + 1);
+        case FP16:
+            this->compute_z_fmt<FP16>();
+            break;
+
+        default:
+            this->compute_z_fmt<FP32>();
+    }
+
+    this->dump_buffers();
+
+    this->x_offs += this->n + (this->row_len - this->x_cols_lftovr ) % this->row_len;
+
+    if (this->x_offs >= this->x_row_len()) {
+        this->x_offs -= this->x_row_len();
     }
 
-    this->y_offs = this->y_offs == 0 ? ARRAY_WIDTH : 0;
-}
\ No newline at end of file
+    this->y_offs = this->y_offs == 0 ? this->array_width : 0;
+}
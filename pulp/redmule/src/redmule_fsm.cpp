@@ -2,8 +2,6 @@
 
 #include <memory.h>
 
-#define JMP ARRAY_HEIGHT * (PIPE_REGS + 1) * sizeof(src_fmt_t)
-
 void RedMule::fsm_start_handler(void *__this, vp::clock_event *event) {
     RedMule* _this = (RedMule *) __this;
 
@@ -24,15 +22,18 @@ void RedMule::fsm_start_handler(void *__this, vp::clock_event *event) {
 	_this->trace.msg("\tW TOT LEN:\t%d\n", _this->register_file [REDMULE_REG_W_TOT_LEN_PTR>>2]);
 	_this->trace.msg("\tX TOT LEN:\t%d\n", _this->register_file [REDMULE_REG_X_TOT_LEN_PTR>>2]);
 
+	// Distance between two consecutive row blocks in memory
+	uint32_t jmp = _this->row_len * _this->src_size;
+
 	_this->trace.msg("Configuring z_stream:\n");
 
 	_this->z_stream.configure(
 		_this->register_file [REDMULE_REG_Z_PTR>>2],							//base_addr
 		_this->register_file [REDMULE_REG_YZ_TOT_LEN_PTR>>2],					//tot_len
-		ARRAY_WIDTH,															//d0_len
+		_this->array_width,														//d0_len
 		_this->register_file [REDMULE_REG_YZ_D0_STRIDE_PTR>>2],					//d0_stride
 		_this->register_file [REDMULE_REG_W_ITER_PTR >> 2] & 0x0000ffff,		//d1_len
-		JMP,																	//d1_stride
+		jmp,																	//d1_stride
 		0,																		//d2_len
 		_this->register_file [REDMULE_REG_YZ_D2_STRIDE_PTR >> 2],				//d2_stride
 		0																		//d3_stride
@@ -43,13 +44,13 @@ void RedMule::fsm_start_handler(void *__this, vp::clock_event *event) {
 	_this->x_stream.configure(
 		_this->register_file [REDMULE_REG_X_PTR>>2],							//base_addr	
 		_this->register_file [REDMULE_REG_X_TOT_LEN_PTR>>2],					//tot_len 	
-		ARRAY_WIDTH,															//d0_len 		
+		_this->array_width,														//d0_len 		
 		_this->register_file [REDMULE_REG_X_D1_STRIDE_PTR>>2],					//d0_stride	
 		_this->register_file [REDMULE_REG_X_ITER_PTR>>2] & 0x0000ffff,			//d1_len 		
-		JMP,																	//d1_stride 	
+		jmp,																	//d1_stride 	
 		_this->register_file [REDMULE_REG_W_ITER_PTR>>2] & 0x0000ffff,			//d2_len
 		0,																		//d2_stride
-		_this->register_file [REDMULE_REG_X_D1_STRIDE_PTR>>2] * ARRAY_WIDTH		//d3_stride
+		_this->register_file [REDMULE_REG_X_D1_STRIDE_PTR>>2] * _this->array_width	//d3_stride
 	);
 
 	_this->trace.msg("Configuring y_stream:\n");
@@ -57,10 +58,10 @@ void RedMule::fsm_start_handler(void *__this, vp::clock_event *event) {
 	_this->y_stream.configure(
 		_this->register_file [REDMULE_REG_Y_PTR>>2],							//base_addr
 		_this->register_file [REDMULE_REG_YZ_TOT_LEN_PTR>>2],					//tot_len
-		ARRAY_WIDTH,															//d0_len
+		_this->array_width,														//d0_len
 		_this->register_file [REDMULE_REG_YZ_D0_STRIDE_PTR>>2],					//d0_stride
 		_this->register_file [REDMULE_REG_W_ITER_PTR >> 2] & 0x0000ffff,		//d1_len
-		JMP,																	//d1_stride
+		jmp,																	//d1_stride
 		0,																		//d2_len
 		_this->register_file [REDMULE_REG_YZ_D2_STRIDE_PTR >> 2],				//d2_stride
 		0																		//d3_stride
@@ -74,14 +75,14 @@ void RedMule::fsm_start_handler(void *__this, vp::clock_event *event) {
 		_this->register_file [REDMULE_REG_W_ITER_PTR>>2]>>16,					//d0_len
 		_this->register_file [REDMULE_REG_W_D0_STRIDE_PTR>>2],					//d0_stride
 		_this->register_file [REDMULE_REG_W_ITER_PTR>>2] & 0x0000ffff,			//d1_len
-		JMP,																	//d1_stride
+		jmp,																	//d1_stride
 		0,																		//d2_len
 		0,																		//d2_stride
 		0																		//d3_stride
 	);
 
 	_this->buffers.alloc_buffers(
-		_this->register_file [REDMULE_REG_X_D1_STRIDE_PTR>>2]/sizeof(src_fmt_t),
+		_this->register_file [REDMULE_REG_X_D1_STRIDE_PTR>>2]/_this->src_size,
 		(_this->register_file [REDMULE_REG_LEFTOVERS_PTR>>2] >> 24) & 0x000000ff,
 		(_this->register_file [REDMULE_REG_LEFTOVERS_PTR>>2] >> 16) & 0x000000ff,
 		(_this->register_file [REDMULE_REG_LEFTOVERS_PTR>>2] >> 8) & 0x000000ff,
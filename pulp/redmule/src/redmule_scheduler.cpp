@@ -20,7 +20,7 @@ void RedMule::reset_sched() {
 }
 
 bool RedMule::preload_iter(int* latency) {
-    if (this->preload_cnt < ARRAY_WIDTH) {
+    if (this->preload_cnt < this->array_width) {
         *latency = this->buf_disamb(Y_BUF, -1);
     } else {
         *latency = this->buf_disamb(X_BUF, -1);
@@ -28,7 +28,7 @@ bool RedMule::preload_iter(int* latency) {
 
     this->preload_cnt++;
 
-    if (this->preload_cnt == 3 * ARRAY_WIDTH) {
+    if (this->preload_cnt == 3 * this->array_width) {
         this->preload_cnt = 0;
 
         return true;
@@ -79,11 +79,11 @@ int RedMule::buf_disamb(int label, strobe_t strb) {
 int RedMule::subcycle_routine(bool skip_w, int label, strobe_t strb) {
     int latency = 0;
 
-    int cycle_mod = this->subcycle_cnt % (PIPE_REGS + 1);
+    int cycle_mod = this->subcycle_cnt % (this->pipe_regs + 1);
 
     if (cycle_mod == 0) {
         latency = skip_w ? this->buf_disamb(SKIP, strb) : this->buf_disamb(W_BUF, strb);
-    } else if (cycle_mod < ARRAY_WIDTH / ARRAY_HEIGHT + 1) {
+    } else if (cycle_mod < this->array_width / this->array_height + 1) {
         latency = this->buf_disamb(label, strb);
     } else {
         latency = this->buf_disamb(SKIP, strb);
@@ -91,7 +91,7 @@ int RedMule::subcycle_routine(bool skip_w, int label, strobe_t strb) {
 
     this->subcycle_cnt++;
 
-    if (this->subcycle_cnt == ARRAY_HEIGHT * (PIPE_REGS + 1)) {
+    if (this->subcycle_cnt == this->row_len) {
         this->subcycle_cnt = 0;
         this->cycle_cnt++;
 
@@ -101,29 +101,23 @@ int RedMule::subcycle_routine(bool skip_w, int label, strobe_t strb) {
     return latency;
 }
 
+// The array height is only known at runtime, so cycles are matched in the same order a
+// switch on them would
 void RedMule::first_iter_routine(int* latency) {
-    switch (cycle_cnt) {
-        case 1:
-            *latency = this->subcycle_routine(false, Y_BUF, -1);
-            break;
-
-        case ARRAY_HEIGHT - 1:
-            *latency = this->subcycle_routine(false, X_BUF, -1);
-            break;
-
-        default:
-            *latency = this->subcycle_routine(false, SKIP, -1);
+    if (this->cycle_cnt == 1) {
+        *latency = this->subcycle_routine(false, Y_BUF, -1);
+    } else if (this->cycle_cnt == this->array_height - 1) {
+        *latency = this->subcycle_routine(false, X_BUF, -1);
+    } else {
+        *latency = this->subcycle_routine(false, SKIP, -1);
     }
 }
 
 void RedMule::standard_iter_routine(int* latency) {
-    switch (cycle_cnt) {
-        case ARRAY_HEIGHT - 1:
-            *latency = this->subcycle_routine(false, X_BUF, -1);
-            break;
-
-        default:
-            *latency = this->subcycle_routine(false, SKIP, -1);
+    if (this->cycle_cnt == this->array_height - 1) {
+        *latency = this->subcycle_routine(false, X_BUF, -1);
+    } else {
+        *latency = this->subcycle_routine(false, SKIP, -1);
     }
 }
 
@@ -138,12 +132,12 @@ bool RedMule::compute_iter(int* latency) {
         this->standard_iter_routine(latency);
     }
 
-    if (this->cycle_cnt == ARRAY_HEIGHT) {
+    if (this->cycle_cnt == this->array_height) {
         this->cycle_cnt = 0;
         this->hypercycle_cnt++;
     }
 
-    if (this->hypercycle_cnt == this->register_file [REDMULE_REG_X_D1_STRIDE_PTR>>2] / sizeof(src_fmt_t) / ARRAY_WIDTH - 1) {
+    if (this->hypercycle_cnt == this->register_file [REDMULE_REG_X_D1_STRIDE_PTR>>2] / this->src_size / this->array_width - 1) {
         this->buffers.compute_z();
         return true;
     }
@@ -162,9 +156,9 @@ bool RedMule::store_iter(int* latency) {
             if ((this->register_file [REDMULE_REG_LEFTOVERS_PTR>>2] & 0x000000ff) != 0) {
                 this->z_strb = 0;
                 
-                uint64_t msk = 2 * sizeof(dst_fmt_t) - 1;
+                uint64_t msk = 2 * this->dst_size - 1;
 
-                switch (sizeof(dst_fmt_t)) {
+                switch (this->dst_size) {
                     case 1:
                         msk = 0x1;
                         break;
@@ -181,7 +175,7 @@ bool RedMule::store_iter(int* latency) {
                 for (int i = 0; i < (this->register_file [REDMULE_REG_LEFTOVERS_PTR>>2] & 0x000000ff); i++) {
                     this->z_strb = this->z_strb | msk;
 
-                    msk = msk << sizeof(dst_fmt_t);
+                    msk = msk << this->dst_size;
                 }
             }
 
@@ -196,24 +190,17 @@ bool RedMule::store_iter(int* latency) {
     }
 
 
-    switch (cycle_cnt) {
-        case 0:
-            *latency = this->subcycle_routine(false, Z_BUF, -1);
-            break;
-
-        case 1:
-            *latency = this->subcycle_routine(false, Y_BUF, -1);
-            break;
-
-        case ARRAY_HEIGHT - 1:
-            *latency = this->subcycle_routine(false, X_BUF, -1);
-            break;
-
-        default:
-            *latency = this->subcycle_routine(false, SKIP, -1);
+    if (this->cycle_cnt == 0) {
+        *latency = this->subcycle_routine(false, Z_BUF, -1);
+    } else if (this->cycle_cnt == 1) {
+        *latency = this->subcycle_routine(false, Y_BUF, -1);
+    } else if (this->cycle_cnt == this->array_height - 1) {
+        *latency = this->subcycle_routine(false, X_BUF, -1);
+    } else {
+        *latency = this->subcycle_routine(false, SKIP, -1);
     }
 
-    if (this->cycle_cnt == ARRAY_HEIGHT) {
+    if (this->cycle_cnt == this->array_height) {
         this->cycle_cnt = 0;
         this->hypercycle_cnt = 1;
 
@@ -2,6 +2,32 @@
 
 #define BYTES_PER_BANK 4
 
+// Rows are converted in place: memory elements are never wider than the float buffer
+// elements, so loads are expanded from the end and stores are packed from the start.
+template<int SRC, int DST>
+static void redmule_load_row(float* buf, int len) {
+	for (int i = len - 1; i >= 0; i--) {
+		buf[i] = redmule_round<DST>(redmule_load<SRC>((uint8_t *) buf + i * redmule_fmt_size(SRC)));
+	}
+}
+
+template<int SRC>
+static void redmule_store_row(float* buf, int len) {
+	for (int i = 0; i < len; i++) {
+		float value = buf[i];
+		redmule_store<SRC>((uint8_t *) buf + i * redmule_fmt_size(SRC), value);
+	}
+}
+
+template<int SRC>
+static void (*redmule_get_load_row(int dst_fmt))(float*, int) {
+	switch (dst_fmt) {
+		case FP8:  return &redmule_load_row<SRC, FP8>;
+		case FP16: return &redmule_load_row<SRC, FP16>;
+		default:   return &redmule_load_row<SRC, FP32>;
+	}
+}
+
 RedMule_Streamer::RedMule_Streamer(RedMule* redmule, bool is_write) {
     this->redmule = redmule;
 	
@@ -21,6 +47,22 @@ RedMule_Streamer::RedMule_Streamer(RedMule* redmule, bool is_write) {
 	this->d2_iters	= 0;
 	this->req		= this->redmule->out.req_new(0, 0, 0, is_write);
 	this->is_write	= is_write;
+
+	switch (redmule->src_fmt) {
+		case FP8:
+			this->load_row = redmule_get_load_row<FP8>(redmule->dst_fmt);
+			this->store_row = &redmule_store_row<FP8>;
+			break;
+
+		case FP16:
+			this->load_row = redmule_get_load_row<FP16>(redmule->dst_fmt);
+			this->store_row = &redmule_store_row<FP16>;
+			break;
+
+		default:
+			this->load_row = redmule_get_load_row<FP32>(redmule->dst_fmt);
+			this->store_row = &redmule_store_row<FP32>;
+	}
 }
 
 RedMule_Streamer::RedMule_Streamer() {
@@ -127,9 +169,20 @@ int RedMule_Streamer::rw_data(int width, void* buf, strobe_t strb) {
 
 			if (i + BYTES_PER_BANK <= width) {
 				if ((strb & 0xF) == 0xF) {
+					int size = BYTES_PER_BANK;
+
+					// Merge the next words into the same request as long as they are
+					// complete and fully enabled, the interconnect reports the latency
+					// of the slowest bank
+					if (this->redmule->wide_accesses) {
+						while (size < 64 && i + size + BYTES_PER_BANK <= width && ((strb >> size) & 0xF) == 0xF) {
+							size += BYTES_PER_BANK;
+						}
+					}
+
 					this->req->set_addr(offs + i);
 					this->req->set_data(((uint8_t *) buf) + i);
-					this->req->set_size(BYTES_PER_BANK);
+					this->req->set_size(size);
 
 					vp::io_req_status_e err = this->redmule->out.req(this->req);
 
@@ -140,7 +193,8 @@ int RedMule_Streamer::rw_data(int width, void* buf, strobe_t strb) {
 
 					latency = req->get_latency();
 
-					strb = strb >> BYTES_PER_BANK;
+					strb = size < 64 ? strb >> size : 0;
+					i += size - BYTES_PER_BANK;
 				} else {
 					if (this->is_write) {	//TODO: does not support strobes with 0s at the beginning
 						int ones = sizeof(uint64_t) * 8 - __builtin_clzll (strb);
@@ -243,50 +297,23 @@ int RedMule_Streamer::rw_data(int width, void* buf, strobe_t strb) {
 	return (int) max_latency + 1;
 }
 
-int RedMule_Streamer::iterate(void* buf, strobe_t strb) {
+int RedMule_Streamer::iterate(float* buf, strobe_t strb) {
 	int latency = 1;
-
-#if SRC_FMT!=DST_FMT
+	int row_len = this->redmule->row_len;
 
 	if (this->is_write) {
 		if (buf != NULL) {
-			for (int i = 0; i < ARRAY_HEIGHT * (PIPE_REGS + 1); i++) {		//ASSUMPTION: dst_fmt_t is greater than src_fmt_t
-				#if SRC_FMT!=FP8
-					* (src_fmt_t *) (buf + i * sizeof(src_fmt_t)) = (src_fmt_t) * (dst_fmt_t *) (buf + i * sizeof(dst_fmt_t));
-				#else
-					_Float16 tmp = (_Float16) * (dst_fmt_t *) (buf + i * sizeof(dst_fmt_t));
-
-					* (src_fmt_t *) (buf + i * sizeof(src_fmt_t)) = (* (uint16_t *) &tmp) >> 8;
-				#endif
-			}
+			this->store_row(buf, row_len);
 		}
 
-		latency = this->rw_data(sizeof(src_fmt_t) * (ARRAY_HEIGHT) * (PIPE_REGS + 1), buf, strb);
+		latency = this->rw_data(this->redmule->src_size * row_len, buf, strb);
 	} else {
-		latency = this->rw_data(sizeof(src_fmt_t) * (ARRAY_HEIGHT) * (PIPE_REGS + 1), buf, strb);
+		latency = this->rw_data(this->redmule->src_size * row_len, buf, strb);
 
 		if (buf != NULL) {
-			for (int i = ARRAY_HEIGHT * (PIPE_REGS + 1) - 1; i >= 0; i--) {
-				#if SRC_FMT!=FP8
-					* (dst_fmt_t *) (buf + i * sizeof(dst_fmt_t)) = (dst_fmt_t) * (src_fmt_t *) (buf + i * sizeof(src_fmt_t));
-				#else
-					uint16_t tmp = 0;
-
-					* (uint8_t *) &tmp = * (uint8_t *) (buf + i * sizeof(src_fmt_t));
-
-					tmp = tmp << 8;
-
-					* (dst_fmt_t *) (buf + i * sizeof(dst_fmt_t)) = (dst_fmt_t) * (_Float16 *) &tmp;
-				#endif
-			}
+			this->load_row(buf, row_len);
 		}
 	}
 
-#else
-
-	latency = this->rw_data(sizeof(src_fmt_t) * (ARRAY_HEIGHT) * (PIPE_REGS + 1), buf, strb);
-
-#endif
-
 	return latency;
-}
\ No newline at end of file
+}
@@ -0,0 +1,164 @@
+// Host check of the Z tile kernel used by the model.
+//
+// The golden-model tensors of ../inc are fed to the kernel of include/redmule_kernel.hpp the way
+// RedMule_Buffers::compute_z does, with several tile widths and with the x ring split at several
+// places. Each tile is compared bit for bit with the scalar per-element fma loop the model used
+// before the vector kernel, before and after the destination rounding. The FP16 result is then
+// compared with the golden Z using the threshold of redmule_test.c.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+#include <redmule_fmt.hpp>
+#include <redmule_kernel.hpp>
+
+#include "../inc/tensor_dim.h"
+#include "../inc/x_input.h"
+#include "../inc/w_input.h"
+#include "../inc/y_input.h"
+#include "../inc/z_output.h"
+
+#define ERROR_THRES 0x05
+
+static const uint16_t x_bits[M_SIZE * N_SIZE] = X;
+static const uint16_t w_bits[N_SIZE * K_SIZE] = W;
+static const uint16_t y_bits[M_SIZE * K_SIZE] = Y;
+static const uint16_t z_gold[M_SIZE * K_SIZE] = Z;
+
+static int nb_errors = 0;
+
+// Scalar loop of the model before the vector kernel, one fma per element and per k
+static void reference_mac_rows(float* acc, const float* x, const float* w, int row_len, int n) {
+    for (int j = 0; j < row_len; j++) {
+        float tmp_z = acc[j];
+
+        for (int k = 0; k < n; k++) {
+            tmp_z = (float) fma((double) x[k], (double) w[k * row_len + j], (double) tmp_z);
+        }
+
+        acc[j] = tmp_z;
+    }
+}
+
+static uint32_t float_bits(float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+static void compare(const char* what, int row_len, int split, int i, int j, float value, float expected) {
+    if (float_bits(value) != float_bits(expected)) {
+        if (nb_errors < 16) {
+            printf("%s mismatch (row_len: %d, split: %d, row: %d, col: %d, expected: 0x%x, got: 0x%x)\n",
+                what, row_len, split, i, j, float_bits(expected), float_bits(value));
+        }
+        nb_errors++;
+    }
+}
+
+// Run the model kernel on the columns [col, col + ROW_LEN) with the reduction split in two chunks
+// at split, as done when the x ring wraps, and store the FP16 result into z
+template<int ROW_LEN>
+static void check_tile(const std::vector<float>& x, const std::vector<float>& w, const std::vector<float>& y,
+        int row_len, int col, int split, std::vector<float>& z) {
+    std::vector<float> w_tile(N_SIZE * row_len);
+    std::vector<float> acc(row_len), ref(row_len);
+
+    for (int k = 0; k < N_SIZE; k++) {
+        for (int j = 0; j < row_len; j++) {
+            w_tile[k * row_len + j] = w[k * K_SIZE + col + j];
+        }
+    }
+
+    for (int i = 0; i < M_SIZE; i++) {
+        const float* x_row = &x[i * N_SIZE];
+
+        for (int j = 0; j < row_len; j++) {
+            acc[j] = ref[j] = y[i * K_SIZE + col + j];
+        }
+
+        redmule_mac_rows<ROW_LEN>(acc.data(), x_row, w_tile.data(), row_len, split);
+        if (split < N_SIZE) {
+            redmule_mac_rows<ROW_LEN>(acc.data(), x_row + split, &w_tile[split * row_len], row_len, N_SIZE - split);
+        }
+
+        reference_mac_rows(ref.data(), x_row, w_tile.data(), row_len, N_SIZE);
+
+        for (int j = 0; j < row_len; j++) {
+            compare("Accumulator", row_len, split, i, col + j, acc[j], ref[j]);
+            compare("FP16 result", row_len, split, i, col + j, redmule_round<FP16>(acc[j]), redmule_round<FP16>(ref[j]));
+            compare("FP8 result", row_len, split, i, col + j, redmule_round<FP8>(acc[j]), redmule_round<FP8>(ref[j]));
+
+            z[i * K_SIZE + col + j] = redmule_round<FP16>(acc[j]);
+        }
+    }
+}
+
+template<int ROW_LEN>
+static void check_geometry(const std::vector<float>& x, const std::vector<float>& w, const std::vector<float>& y,
+        int row_len) {
+    const int splits[] = { N_SIZE, N_SIZE / 3, 1 };
+
+    for (int split: splits) {
+        std::vector<float> z(M_SIZE * K_SIZE);
+
+        for (int col = 0; col + row_len <= K_SIZE; col += row_len) {
+            check_tile<ROW_LEN>(x, w, y, row_len, col, split, z);
+        }
+
+        if (K_SIZE % row_len != 0) {
+            continue;
+        }
+
+        for (int i = 0; i < M_SIZE * K_SIZE; i++) {
+            uint8_t bytes[2];
+            redmule_store<FP16>(bytes, z[i]);
+            uint16_t value = bytes[0] | (bytes[1] << 8);
+
+            if (abs((int) z_gold[i] - (int) value) >= ERROR_THRES) {
+                if (nb_errors < 16) {
+                    printf("Golden mismatch (row_len: %d, split: %d, index: %d, expected: 0x%x, got: 0x%x)\n",
+                        row_len, split, i, z_gold[i], value);
+                }
+                nb_errors++;
+            }
+        }
+    }
+}
+
+int main() {
+    std::vector<float> x(M_SIZE * N_SIZE), w(N_SIZE * K_SIZE), y(M_SIZE * K_SIZE);
+
+    for (int i = 0; i < M_SIZE * N_SIZE; i++) {
+        x[i] = redmule_load<FP16>((const uint8_t*) &x_bits[i]);
+    }
+    for (int i = 0; i < N_SIZE * K_SIZE; i++) {
+        w[i] = redmule_load<FP16>((const uint8_t*) &w_bits[i]);
+    }
+    for (int i = 0; i < M_SIZE * K_SIZE; i++) {
+        y[i] = redmule_load<FP16>((const uint8_t*) &y_bits[i]);
+    }
+
+    // Same instances as RedMule_Buffers::compute_z_fmt, the generic one with the whole Z width
+    // and with a width which is not a multiple of the vector blocks
+    check_geometry<16>(x, w, y, 16);
+    check_geometry<32>(x, w, y, 32);
+    check_geometry<0>(x, w, y, K_SIZE);
+    check_geometry<0>(x, w, y, 6);
+
+#ifdef REDMULE_VECTOR_KERNEL
+    const char* kernel = "vector";
+#else
+    const char* kernel = "scalar";
+#endif
+
+    if (nb_errors) {
+        printf("FAILED: %d mismatches (%s kernel)\n", nb_errors, kernel);
+        return 1;
+    }
+
+    printf("OK: %dx%dx%d golden tensors, %s kernel bit-exact with the scalar loop\n", M_SIZE, N_SIZE, K_SIZE, kernel);
+    return 0;
+}
@@ -18,7 +18,7 @@ import gvsoc.systree
 from memory.memory import Memory
 from interco.router import Router
 from interco.converter import Converter
-from interco.interleaver import Interleaver
+from pulp.cluster.l1_interleaver import L1_interleaver
 from pulp.snitch.snitch_cluster.dma_interleaver import DmaInterleaver
 import math
 
@@ -91,7 +91,7 @@ class L1_subsystem(gvsoc.systree.Component):
 
         # L1 interleaver
         # TCDM interconnection, one port per bank, 8 ports per superbank
-        interleaver = Interleaver(self, 'interleaver', nb_slaves=nb_l1_banks, nb_masters=l1_interleaver_nb_masters, 
+        interleaver = L1_interleaver(self, 'interleaver', nb_slaves=nb_l1_banks, nb_masters=l1_interleaver_nb_masters,
                                     interleaving_bits=int(math.log2(bandwidth)))
         
         # DMA interleaver
@@ -27,8 +27,11 @@
 #include <vp/itf/io.hpp>
 #include <vp/itf/wire.hpp>
 #include <vp/proxy.hpp>
+#include <vp/signal.hpp>
+#include <pulp/utils/statistics.hpp>
 #include <stdio.h>
 #include <math.h>
+#include <vector>
 
 #define RISCY
 #define CONFIG_GVSOC_ISS_SNITCH
@@ -97,6 +100,8 @@ public:
     int next_entry = -1;
     // The corresponding frep configuration
     FrepConfig config;
+    // Index of the staggered variant to be offloaded next in the replay cache
+    int replay_id = 0;
 };
 
 BufferEntry::BufferEntry(OffloadReq req, bool is_outer, int max_inst, int max_rpt, int stagger_max, unsigned int stagger_mask, int base_entry, int next_entry, FrepConfig config) :
@@ -113,14 +118,13 @@ public:
 
     sequencer(vp::ComponentConf &conf);
 
-    OffloadReq acc_req;
-
 private:
 
     // Functions for read/write logic
     void write_entry(BufferEntry entry);
     void update_entry(int index);
-    BufferEntry read_entry(int index);
+    OffloadReq *read_entry(int index);
+    void fill_replay(int index);
     BufferEntry gen_entry(OffloadReq *req, FrepConfig *frep_config);
     // Functions determining the state of the buffer
     bool isFull();
@@ -136,6 +140,7 @@ private:
     inline void stalled_dec();
     inline void stalled_inc();
     void reset(bool active);
+    void stop();
 
     vp::Trace     trace;
     vp::ClockEvent *event;
@@ -160,9 +165,13 @@ private:
     // Generic latency of sequencer module
     int latency = 0;
 
-    // Build a ring buffer table with 16 entries
-    static const int size = 16;
-    BufferEntry RingBuffer[size];
+    // Ring buffer table, its number of entries is a power of two so that indexes wrap with a mask
+    int size;
+    int size_mask;
+    std::vector<BufferEntry> RingBuffer;
+    // Replay cache, one per buffer entry, holding the request as offloaded for each register
+    // staggering step, so that frep iterations just pick one instead of rebuilding it.
+    std::vector<std::vector<OffloadReq>> ReplayCache;
     // Important index for read/write operations
     int write_id = 0;
     int read_id = 0;
@@ -174,11 +183,36 @@ private:
 
     // Store latest frep configuration
     FrepConfig frep_config;
+
+    // Statistics, also visible as trace events
+    bool statistics;
+    // Path of the file where statistics are dumped, or empty if they should go through the trace
+    std::string statistics_file;
+    // Number of entries in the buffer
+    vp::Signal<int64_t> occupancy;
+    // Number of cycles the integer core was stalled because the buffer was full
+    vp::Signal<uint64_t> full_stalls;
+    // Number of instructions sent through the bypass lane
+    vp::Signal<uint64_t> bypass_insns;
+    // Number of frep iterations, one per instruction for inner loops and one per loop body for
+    // outer loops
+    vp::Signal<uint64_t> frep_iterations;
+    // Number of instructions offloaded from the buffer
+    vp::Signal<uint64_t> offloads;
+    // Cycles of the first and last offload from the buffer, to compute the throughput
+    int64_t first_offload_cycle = -1;
+    int64_t last_offload_cycle = -1;
+    int max_occupancy = 0;
 };
 
 
 sequencer::sequencer(vp::ComponentConf &config)
-    : vp::Component(config)
+    : vp::Component(config),
+      occupancy(*this, "occupancy", 64),
+      full_stalls(*this, "full_stalls", 64),
+      bypass_insns(*this, "bypass_insns", 64),
+      frep_iterations(*this, "frep_iterations", 64),
+      offloads(*this, "offloads", 64)
 {
     traces.new_trace("trace", &trace, vp::DEBUG);
 
@@ -196,6 +230,17 @@ sequencer::sequencer(vp::ComponentConf &config)
     new_master_port("acc_req_ready_o", &this->ready_o_itf, (vp::Block *)this);
 
     this->latency = get_js_config()->get_child_int("latency");
+    this->statistics = get_js_config()->get_child_bool("statistics");
+    this->statistics_file = get_js_config()->get_child_str("statistics_file");
+
+    this->size = get_js_config()->get_child_int("depth");
+    if (this->size <= 0 || (this->size & (this->size - 1)) != 0)
+    {
+        this->trace.fatal("Sequence buffer depth must be a power of two (depth: %d)\n", this->size);
+    }
+    this->size_mask = this->size - 1;
+    this->RingBuffer.resize(this->size);
+    this->ReplayCache.resize(this->size);
 
 }
 
@@ -215,24 +260,39 @@ void sequencer::offload_event(vp::Block *__this, vp::ClockEvent *event)
     _this->trace.msg(vp::Trace::LEVEL_TRACE, "Sequencer receives acceleration request output handshaking signal: %d\n", _this->acc_req_ready_o);
 
     // If the buffer has some entries, offload entry one by one each cycle
-    BufferEntry offload_entry;
     int buf_id = _this->read_id;
 
     // The buffer is not empty and the subsystem is ready, offload the request from the buffer.
     if (!_this->isEmpty() && _this->acc_req_ready_o)
     {
         // Read out an entry from the buffer.
-        offload_entry = _this->read_entry(buf_id);
+        // The fp subsystem gets the pre-computed request of the replay cache, which stays valid
+        // until this buffer slot is written again. The instruction is shared by all the
+        // iterations replaying this variant and must not be modified by the subsystem. The
+        // scalar fields may be, so they are reloaded from the entry before each offload.
+        OffloadReq *offload_req = _this->read_entry(buf_id);
+        OffloadReq *entry_req = &_this->RingBuffer[buf_id].req;
+        offload_req->pc = entry_req->pc;
+        offload_req->is_write = entry_req->is_write;
+        offload_req->frm = entry_req->frm;
+        offload_req->fmode = entry_req->fmode;
 
         // Output handshaking, between sequencer and fp subsystem
-        _this->acc_req = offload_entry.req;
-        _this->trace.msg("Offload to fp subsystem from buffer index %d (opcode: 0x%lx, pc: 0x%lx)\n", buf_id, _this->acc_req.insn.opcode, _this->acc_req.pc);
+        _this->trace.msg("Offload to fp subsystem from buffer index %d (opcode: 0x%lx, pc: 0x%lx)\n", buf_id, offload_req->insn.opcode, offload_req->pc);
 
         // Offload request if the port is connected
         if (_this->out.is_bound())
         {
-            _this->out.sync(&_this->acc_req);
+            _this->out.sync(offload_req);
+        }
+
+        int64_t cycles = _this->clock.get_cycles();
+        if (_this->first_offload_cycle < 0)
+        {
+            _this->first_offload_cycle = cycles;
         }
+        _this->last_offload_cycle = cycles;
+        _this->offloads.set(_this->offloads.get() + 1);
 
         // Update the buffer after each read operation.
         _this->update_entry(buf_id);
@@ -241,6 +301,7 @@ void sequencer::offload_event(vp::Block *__this, vp::ClockEvent *event)
         if (_this->RingBuffer[buf_id].max_rpt < 0)
         {
             _this->nb_entries--;
+            _this->occupancy.set(_this->nb_entries);
         }
         _this->trace.msg(vp::Trace::LEVEL_TRACE, "Number of entries in the ring buffer: %d\n", _this->nb_entries);
     }
@@ -349,6 +410,8 @@ void sequencer::req(vp::Block *__this, OffloadReq *req)
         {
             _this->out.sync(req);
         }
+
+        _this->bypass_insns.set(_this->bypass_insns.get() + 1);
     }
 
 
@@ -410,6 +473,11 @@ vp::IoReqStatus sequencer::rsp_state(vp::Block *__this, vp::IoReq *req)
         _this->trace.msg(vp::Trace::LEVEL_TRACE, "Go through sequenceable lane\n");
         // Check whether the buffer has empty space.
         _this->acc_req_ready = !_this->isFull();
+        if (!_this->acc_req_ready)
+        {
+            // The integer core retries every cycle until the buffer has space
+            _this->full_stalls.set(_this->full_stalls.get() + 1);
+        }
     }
 
     bool acc_req_ready = _this->acc_req_ready;
@@ -453,7 +521,7 @@ BufferEntry sequencer::gen_entry(OffloadReq *req, FrepConfig *config)
 
     // Observe whether it's inside a sequence defined by a frep configuration
     bool sequence = true;
-    if (((this->write_id > ((this->base_id + config->max_inst) % this->size)) & (this->write_id < this->base_id))
+    if (((this->write_id > ((this->base_id + config->max_inst) & this->size_mask)) & (this->write_id < this->base_id))
         | config->max_inst < 0)
     {
         sequence = false;
@@ -470,7 +538,7 @@ BufferEntry sequencer::gen_entry(OffloadReq *req, FrepConfig *config)
         new_entry.isn_sequence = true;
         new_entry.max_rpt = 0;
         new_entry.base_entry = this->write_id;
-        new_entry.next_entry = (this->write_id + 1) % this->size;
+        new_entry.next_entry = (this->write_id + 1) & this->size_mask;
         this->trace.msg(vp::Trace::LEVEL_TRACE, "Generate IO req in buffer index %d (opcode: 0x%llx, pc: 0x%llx)\n", this->write_id, new_entry.req.insn.opcode, new_entry.req.pc);
     }
     else
@@ -493,7 +561,7 @@ BufferEntry sequencer::gen_entry(OffloadReq *req, FrepConfig *config)
         // Find whether it's the last instruction/last iteration in frep config,
         // it will affect the value of next_id in this entry.
         bool insn_last = false;
-        if (this->write_id == ((new_entry.base_entry + new_entry.max_inst) % this->size))
+        if (this->write_id == ((new_entry.base_entry + new_entry.max_inst) & this->size_mask))
         {
             insn_last = true;
         }
@@ -510,7 +578,7 @@ BufferEntry sequencer::gen_entry(OffloadReq *req, FrepConfig *config)
             if (!insn_last)
             {
                 // There is still instruction following in this configuration.
-                new_entry.next_entry = (this->write_id + 1) % this->size;
+                new_entry.next_entry = (this->write_id + 1) & this->size_mask;
             }
             else
             {
@@ -523,7 +591,7 @@ BufferEntry sequencer::gen_entry(OffloadReq *req, FrepConfig *config)
                 else
                 {
                     // No iteration, move to the following entry in buffer.
-                    new_entry.next_entry = (this->write_id + 1) % this->size;
+                    new_entry.next_entry = (this->write_id + 1) & this->size_mask;
                 }
             }
         }
@@ -533,7 +601,7 @@ BufferEntry sequencer::gen_entry(OffloadReq *req, FrepConfig *config)
             if(rpt_last)
             {
                 // No iteration, move to the following entry in buffer.
-                new_entry.next_entry = (this->write_id + 1) % this->size;
+                new_entry.next_entry = (this->write_id + 1) & this->size_mask;
             }
             else
             {
@@ -547,7 +615,7 @@ BufferEntry sequencer::gen_entry(OffloadReq *req, FrepConfig *config)
             this->write_id, new_entry.config.is_outer, new_entry.config.max_inst, new_entry.config.max_rpt, new_entry.config.stagger_max, new_entry.config.stagger_mask);
 
         // Reset frep config if this sequence is over
-        if (this->write_id == ((this->base_id + config->max_inst) % this->size))
+        if (this->write_id == ((this->base_id + config->max_inst) & this->size_mask))
         {
             config->max_inst = -1;
             config->max_rpt = -1;
@@ -572,57 +640,100 @@ void sequencer::write_entry(BufferEntry entry)
     {
         // Write new entry to write_id
         this->RingBuffer[this->write_id] = entry;
+        this->fill_replay(this->write_id);
         this->trace.msg("Wrote IO request in buffer index %d (opcode: 0x%llx, pc: 0x%llx)\n", this->write_id, this->RingBuffer[this->write_id].req.insn.opcode, this->RingBuffer[this->write_id].req.pc);
 
         // Update write_id for the next write operation
-        this->write_id = (this->write_id + 1) % this->size;
+        this->write_id = (this->write_id + 1) & this->size_mask;
         this->nb_entries++;
+        this->occupancy.set(this->nb_entries);
+        if (this->nb_entries > this->max_occupancy)
+        {
+            this->max_occupancy = this->nb_entries;
+        }
     }
 }
 
 
-// Get called when we read out an entry from the buffer.
-BufferEntry sequencer::read_entry(int index)
+// Get called when a new entry is written, to pre-compute the requests it will offload.
+// Register staggering cycles the staggered registers through stagger_max + 1 consecutive
+// indexes, so each step gets its own copy of the request with the register indexes and
+// the decoded arguments (used for traces) already updated.
+void sequencer::fill_replay(int index)
 {
-    if (this->isEmpty())
-    {
-        this->trace.msg("Sequence buffer is empty and no instruction can be read\n");
-        // Todo: write a return here to avoid accident happening.
-        // For now return a dummy one to avoid gcc warning
-        return BufferEntry();
-    }
-    else
+    BufferEntry *entry = &this->RingBuffer[index];
+    std::vector<OffloadReq> &replay = this->ReplayCache[index];
+    bool stagger = !entry->isn_sequence && entry->config.stagger_max > 0;
+    int nb_variants = stagger && entry->stagger_mask ? entry->config.stagger_max + 1 : 1;
+
+    entry->replay_id = 0;
+    replay.resize(nb_variants);
+
+    for (int k = 0; k < nb_variants; k++)
     {
-        BufferEntry entry = this->RingBuffer[index];
-        this->trace.msg("Read IO request in buffer index %d (opcode: 0x%llx, pc: 0x%llx)\n", index, this->RingBuffer[index].req.insn.opcode, this->RingBuffer[index].req.pc);
+        OffloadReq *req = &replay[k];
+        *req = entry->req;
 
-        // Assign read_id to index of next instruction
-        this->read_id = entry.next_entry;
-        this->trace.msg(vp::Trace::LEVEL_TRACE, "Update buffer read_id to %d after a read\n", this->read_id);
+        if (entry->stagger_mask & 0x1)
+        {
+            req->insn.out_regs[0] += k;
+        }
+        if (entry->stagger_mask & 0x2)
+        {
+            req->insn.in_regs[0] += k;
+        }
+        if (entry->stagger_mask & 0x4)
+        {
+            req->insn.in_regs[1] += k;
+        }
+        if (entry->stagger_mask & 0x8)
+        {
+            req->insn.in_regs[2] += k;
+        }
 
         // Update register index for trace if this instruction's stagger_max>0
-        if (!entry.isn_sequence & entry.config.stagger_max > 0)
+        if (stagger)
         {
-            int nb_args = entry.req.insn.decoder_item->u.insn.nb_args;
+            int nb_args = req->insn.decoder_item->u.insn.nb_args;
             for (int i = 0; i < nb_args; i++)
             {
-                iss_decoder_arg_t *arg = &entry.req.insn.decoder_item->u.insn.args[i];
-                iss_insn_arg_t *insn_arg = &entry.req.insn.args[i];
+                iss_decoder_arg_t *arg = &req->insn.decoder_item->u.insn.args[i];
+                iss_insn_arg_t *insn_arg = &req->insn.args[i];
                 if ((arg->type == ISS_DECODER_ARG_TYPE_OUT_REG || arg->type == ISS_DECODER_ARG_TYPE_IN_REG) && (insn_arg->u.reg.index != 0 || arg->flags & ISS_DECODER_ARG_FLAG_FREG))
                 {
                     if (arg->type == ISS_DECODER_ARG_TYPE_OUT_REG)
                     {
-                        insn_arg->u.reg.index = entry.req.insn.out_regs[arg->u.reg.id];
+                        insn_arg->u.reg.index = req->insn.out_regs[arg->u.reg.id];
                     }
                     else if (arg->type == ISS_DECODER_ARG_TYPE_IN_REG)
                     {
-                        insn_arg->u.reg.index = entry.req.insn.in_regs[arg->u.reg.id];
+                        insn_arg->u.reg.index = req->insn.in_regs[arg->u.reg.id];
                     }
                 }
             }
         }
+    }
+}
+
 
-        return entry;
+// Get called when we read out an entry from the buffer.
+OffloadReq *sequencer::read_entry(int index)
+{
+    if (this->isEmpty())
+    {
+        this->trace.msg("Sequence buffer is empty and no instruction can be read\n");
+        return NULL;
+    }
+    else
+    {
+        BufferEntry *entry = &this->RingBuffer[index];
+        this->trace.msg("Read IO request in buffer index %d (opcode: 0x%llx, pc: 0x%llx)\n", index, entry->req.insn.opcode, entry->req.pc);
+
+        // Assign read_id to index of next instruction
+        this->read_id = entry->next_entry;
+        this->trace.msg(vp::Trace::LEVEL_TRACE, "Update buffer read_id to %d after a read\n", this->read_id);
+
+        return &this->ReplayCache[index][entry->replay_id];
     }
 }
 
@@ -640,11 +751,16 @@ void sequencer::update_entry(int index)
         // Update next_entry index for the next iteration
         bool insn_last = false;
         // base_entry and config.max_inst are const variables after configuration.
-        if (index == ((entry->base_entry + entry->config.max_inst) % this->size))
+        if (index == ((entry->base_entry + entry->config.max_inst) & this->size_mask))
         {
             insn_last = true;
         }
 
+        if (!entry->config.is_outer || insn_last)
+        {
+            this->frep_iterations.set(this->frep_iterations.get() + 1);
+        }
+
         bool rpt_last = false;
         if (entry->max_rpt == 0)
         {
@@ -658,7 +774,7 @@ void sequencer::update_entry(int index)
             if (!insn_last)
             {
                 // There is still instruction following in this configuration.
-                entry->next_entry = (index + 1) % this->size;
+                entry->next_entry = (index + 1) & this->size_mask;
             }
             else
             {
@@ -671,7 +787,7 @@ void sequencer::update_entry(int index)
                 else
                 {
                     // No iteration, move to the following entry in buffer.
-                    entry->next_entry = (index + 1) % this->size;
+                    entry->next_entry = (index + 1) & this->size_mask;
                 }
             }
         }
@@ -681,7 +797,7 @@ void sequencer::update_entry(int index)
             if(rpt_last)
             {
                 // No iteration, move to the following entry in buffer.
-                entry->next_entry = (index + 1) % this->size;
+                entry->next_entry = (index + 1) & this->size_mask;
             }
             else
             {
@@ -690,69 +806,13 @@ void sequencer::update_entry(int index)
             }
         }
 
-        // Update stagger related information
-        int temp_out = entry->req.insn.out_regs[0] + entry->stagger_max;
-        int temp_in1 = entry->req.insn.in_regs[0] + entry->stagger_max;
-        int temp_in2 = entry->req.insn.in_regs[1] + entry->stagger_max;
-        int temp_in3 = entry->req.insn.in_regs[2] + entry->stagger_max;
-
-        entry->stagger_max --;
-        int stagger_cnt = entry->stagger_max;
-
-        if (entry->stagger_mask & 0x1)
-        {
-            if (stagger_cnt < 0)
-            {
-                entry->stagger_max = entry->config.stagger_max;
-                entry->req.insn.out_regs[0] = temp_out - entry->stagger_max;
-            }
-            else
-            {
-                entry->req.insn.out_regs[0]++;
-            }
-            this->trace.msg(vp::Trace::LEVEL_TRACE, "Update rd to %d (stagger_mask: 0x%llx)\n", entry->req.insn.out_regs[0], entry->stagger_mask);
-        }
-
-        if (entry->stagger_mask & 0x2)
+        // Move to the next register staggering step, wrapping after stagger_max + 1 iterations
+        int nb_variants = this->ReplayCache[index].size();
+        if (nb_variants > 1)
         {
-            if (stagger_cnt < 0)
-            {
-                entry->stagger_max = entry->config.stagger_max;
-                entry->req.insn.in_regs[0] = temp_in1 - entry->stagger_max;
-            }
-            else
-            {
-                entry->req.insn.in_regs[0]++;
-            }
-            this->trace.msg(vp::Trace::LEVEL_TRACE, "Update rs1 to %d (stagger_mask: 0x%llx)\n", entry->req.insn.in_regs[0], entry->stagger_mask);
-        }
-
-        if (entry->stagger_mask & 0x4)
-        {
-            if (stagger_cnt < 0)
-            {
-                entry->stagger_max = entry->config.stagger_max;
-                entry->req.insn.in_regs[1] = temp_in2 - entry->stagger_max;
-            }
-            else
-            {
-                entry->req.insn.in_regs[1]++;
-            }
-            this->trace.msg(vp::Trace::LEVEL_TRACE, "Update rs2 to %d (stagger_mask: 0x%llx)\n", entry->req.insn.in_regs[1], entry->stagger_mask);
-        }
-
-        if (entry->stagger_mask & 0x8)
-        {
-            if (stagger_cnt < 0)
-            {
-                entry->stagger_max = entry->config.stagger_max;
-                entry->req.insn.in_regs[2] = temp_in3 - entry->stagger_max;
-            }
-            else
-            {
-                entry->req.insn.in_regs[2]++;
-            }
-            this->trace.msg(vp::Trace::LEVEL_TRACE, "Update rs3 to %d (stagger_mask: 0x%llx)\n", entry->req.insn.in_regs[2], entry->stagger_mask);
+            entry->replay_id = entry->replay_id + 1 == nb_variants ? 0 : entry->replay_id + 1;
+            entry->stagger_max = entry->config.stagger_max - entry->replay_id;
+            this->trace.msg(vp::Trace::LEVEL_TRACE, "Update stagger step to %d (stagger_mask: 0x%llx)\n", entry->replay_id, entry->stagger_mask);
         }
 
         this->trace.msg(vp::Trace::LEVEL_TRACE, "Update sequence frep configuration in buffer index %d (is_outer: %d, max_inst: %d, max_rpt: %d, stagger_max: %d, stagger_mask: 0x%llx, base_id: %d, next_id: %d)\n",
@@ -764,6 +824,24 @@ void sequencer::update_entry(int index)
 }
 
 
+// Get called at the end of the simulation to dump statistics.
+void sequencer::stop()
+{
+    if (this->statistics)
+    {
+        int64_t offloads = this->offloads.get();
+        int64_t active_cycles = offloads ? this->last_offload_cycle - this->first_offload_cycle + 1 : 0;
+
+        StatisticsOutput output(this, &this->trace, this->statistics_file);
+        output.print(this, "depth: %d, max occupancy: %d", this->size, this->max_occupancy);
+        output.print(this, "full buffer stall cycles: %lu, bypass instructions: %lu, frep iterations: %lu",
+            this->full_stalls.get(), this->bypass_insns.get(), this->frep_iterations.get());
+        output.print(this, "offloaded instructions: %ld in %ld cycles (%.3f per cycle)",
+            offloads, active_cycles, active_cycles ? (double)offloads / active_cycles : 0.0);
+    }
+}
+
+
 // Get called when we need to check whether the buffer is full.
 bool sequencer::isFull()
 {
@@ -34,11 +34,26 @@ class Sequencer(gvsoc.systree.Component):
         The name of the component within the parent space.
     latency: int
         Global latency applied to all incoming requests. This impacts the start time of the burst.
+    depth: int
+        Number of entries of the sequence buffer. Must be a power of two.
+    statistics: bool
+        If True, statistics are dumped at the end of the simulation, like the number of cycles
+        the integer core was stalled on a full buffer and the offload throughput.
+    statistics_file: str
+        Path of the file where statistics are dumped. The path of the component is inserted before
+        the extension. If None, they are printed through the component trace, at info level.
     """
-    def __init__(self, parent: gvsoc.systree.Component, name: str, latency: int=0):
+    def __init__(self, parent: gvsoc.systree.Component, name: str, latency: int=0, depth: int=16,
+            statistics: bool=False, statistics_file: str=None):
         super(Sequencer, self).__init__(parent, name)
 
+        if depth <= 0 or (depth & (depth - 1)) != 0:
+            raise RuntimeError(f'Sequencer depth must be a power of two (got {depth})')
+
         self.set_component('pulp.snitch.sequencer')
 
         self.add_property('latency', latency)
+        self.add_property('depth', depth)
+        self.add_property('statistics', statistics)
+        self.add_property('statistics_file', statistics_file if statistics_file is not None else '')
 
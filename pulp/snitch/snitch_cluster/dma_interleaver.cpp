@@ -21,6 +21,7 @@
 #include <vp/vp.hpp>
 #include <vp/itf/io.hpp>
 #include <math.h>
+#include <pulp/cluster/bank_profiler.hpp>
 
 class DmaInterleaver : public vp::Component
 {
@@ -30,6 +31,8 @@ public:
 
     static vp::IoReqStatus req(vp::Block *__this, vp::IoReq *req);
 
+    void stop();
+
 private:
     vp::Trace trace;
 
@@ -41,6 +44,12 @@ private:
     int offset_right_shift;
     int offset_left_shift;
     int bank_width;
+
+    // Bank accesses and conflicts, only collected and dumped if statistics are enabled. There is a
+    // single initiator, the DMA.
+    bool statistics;
+    std::string statistics_file;
+    BankProfiler profiler;
 };
 
 DmaInterleaver::DmaInterleaver(vp::ComponentConf &config)
@@ -65,6 +74,22 @@ DmaInterleaver::DmaInterleaver(vp::ComponentConf &config)
 
     this->input_port.set_req_meth(&DmaInterleaver::req);
     this->new_slave_port("input", &this->input_port);
+
+    this->statistics = this->get_js_config()->get_child_bool("statistics");
+    this->statistics_file = this->get_js_config()->get_child_str("statistics_file");
+    if (this->statistics)
+    {
+        this->profiler.init(nb_banks, 1);
+    }
+}
+
+void DmaInterleaver::stop()
+{
+    if (this->statistics)
+    {
+        StatisticsOutput output(this, &this->trace, this->statistics_file);
+        this->profiler.dump(output, this);
+    }
 }
 
 vp::IoReqStatus DmaInterleaver::req(vp::Block *__this, vp::IoReq *req)
@@ -81,6 +106,7 @@ vp::IoReqStatus DmaInterleaver::req(vp::Block *__this, vp::IoReq *req)
 
     bank_req.init();
     uint64_t max_delay = 0;
+    int64_t cycles = _this->clock.get_cycles();
     while (size)
     {
         int bank_size = std::min(_this->bank_width - (offset & (_this->bank_width - 1)), size);
@@ -89,6 +115,11 @@ vp::IoReqStatus DmaInterleaver::req(vp::Block *__this, vp::IoReq *req)
         uint64_t bank_offset = ((offset >> _this->offset_right_shift) << _this->offset_left_shift) +
             (offset & ((1<< _this->offset_left_shift) - 1));
 
+        if (_this->statistics)
+        {
+            _this->profiler.access(cycles, bank_id, 0);
+        }
+
         bank_req.set_addr(bank_offset);
         bank_req.set_size(bank_size);
         bank_req.set_data(data);
@@ -18,7 +18,8 @@ import gvsoc.systree
 
 class DmaInterleaver(gvsoc.systree.Component):
 
-    def __init__(self, parent, slave, nb_master_ports, nb_banks, bank_width):
+    def __init__(self, parent, slave, nb_master_ports, nb_banks, bank_width, statistics=False,
+            statistics_file=None):
 
         super(DmaInterleaver, self).__init__(parent, slave)
 
@@ -28,7 +29,9 @@ class DmaInterleaver(gvsoc.systree.Component):
 
         self.add_properties({
             'nb_banks': nb_banks,
-            'bank_width': bank_width
+            'bank_width': bank_width,
+            'statistics': statistics,
+            'statistics_file': statistics_file if statistics_file is not None else ''
         })
 
     # def i_INPUT(self, id) -> gvsoc.systree.SlaveItf:
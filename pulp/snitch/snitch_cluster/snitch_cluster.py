@@ -56,6 +56,8 @@ class ClusterArch:
         self.core_type = properties.core_type
         self.use_spatz = properties.use_spatz
         self.isa = properties.isa
+        # Not all chips declare DMA profiling
+        self.dma_profile_file = getattr(properties, 'dma_profile_file', None)
 
     class Tcdm:
         def __init__(self, base, nb_masters):
@@ -177,7 +179,8 @@ class SnitchCluster(gvsoc.systree.Component):
 
         # Cluster DMA
         idma = SnitchDma(self, 'idma', loc_base=arch.tcdm.area.base, loc_size=arch.tcdm.area.size,
-            tcdm_width=4096, transfer_queue_size=8, burst_queue_size=24)
+            tcdm_width=4096, transfer_queue_size=8, burst_queue_size=24,
+            profile_file=arch.dma_profile_file if arch.dma_profile_file else None)
 
         #
         # Bindings
@@ -0,0 +1,107 @@
+/*
+ * Copyright (C) 2024 ETH Zurich and University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <algorithm>
+#include <string>
+#include <vp/vp.hpp>
+
+/**
+ * @brief Output of the statistics dumped by a component at the end of the simulation
+ *
+ * Each statistic is printed as one line, prefixed by the path of the block it belongs to.
+ * By default the lines go through a trace of the component at info level, so that nothing is
+ * printed unless this trace is active. If a file is given, the lines are written to it instead.
+ * The path of the component is inserted before the file extension so that several components
+ * can be given the same file without overwriting each other.
+ * The output is closed when the object is destroyed, so it is usually declared locally in the
+ * stop method of the component.
+ */
+class StatisticsOutput
+{
+public:
+    /**
+     * @brief Open the output
+     *
+     * @param component Component dumping the statistics.
+     * @param trace Trace used to print the statistics when no file is given, and to report errors.
+     * @param path Path of the statistics file, or empty to print them through the trace.
+     */
+    StatisticsOutput(vp::Component *component, vp::Trace *trace, std::string path)
+    : trace(trace)
+    {
+        if (path == "")
+        {
+            return;
+        }
+
+        std::string component_path = component->get_path();
+        std::replace(component_path.begin(), component_path.end(), '/', '.');
+        size_t ext = path.find_last_of('.');
+        size_t dir = path.find_last_of('/');
+        if (ext == std::string::npos || (dir != std::string::npos && ext < dir))
+        {
+            ext = path.size();
+        }
+        path.insert(ext, component_path[0] == '.' ? component_path : "." + component_path);
+
+        this->file = fopen(path.c_str(), "w");
+        if (this->file == NULL)
+        {
+            this->trace->force_warning("Unable to open statistics file, dumping to trace (path: %s)\n",
+                path.c_str());
+        }
+    }
+
+    ~StatisticsOutput()
+    {
+        if (this->file != NULL)
+        {
+            fclose(this->file);
+        }
+    }
+
+    /**
+     * @brief Print one statistic
+     *
+     * @param block Block the statistic belongs to, its path prefixes the line.
+     * @param format Printf-like format of the line, without the trailing newline.
+     */
+    void print(vp::Block *block, const char *format, ...)
+    {
+        char line[1024];
+        va_list ap;
+        va_start(ap, format);
+        vsnprintf(line, sizeof(line), format, ap);
+        va_end(ap);
+
+        if (this->file != NULL)
+        {
+            fprintf(this->file, "%s: %s\n", block->get_path().c_str(), line);
+        }
+        else
+        {
+            this->trace->msg(vp::Trace::LEVEL_INFO, "%s: %s\n", block->get_path().c_str(), line);
+        }
+    }
+
+private:
+    vp::Trace *trace;
+    FILE *file = NULL;
+};